@@ -123,6 +123,8 @@ size_t Action::memsize() const {
 
 void Action::commit(DirtyList* dirty_list) {
 	Map &map = editor.getMap();
+	// Undoing back to the saved state is only noticed if it was hashed before the first change
+	map.updateSavedState();
 	Selection &selection = editor.getSelection();
 	selection.start(Selection::INTERNAL);
 
@@ -151,7 +153,9 @@ void Action::commit(DirtyList* dirty_list) {
 					dirty_list->AddPosition(pos.x, pos.y, pos.z);
 				}
 
-				new_tile->update();
+				// Changes keep their counts as they go, only the selection is settled here
+				new_tile->settleFlags();
+				ASSERT(new_tile->hasConsistentState());
 
 				// std::cout << "\tSwitched tile at " << pos.x << ";" << pos.y << ";" << pos.z << " from " << (void*)oldtile << " to " << *data <<  std::endl;
 				if (new_tile->isSelected()) {
@@ -280,6 +284,7 @@ void Action::undo(DirtyList* dirty_list) {
 	}
 
 	Map &map = editor.getMap();
+	map.updateSavedState();
 	Selection &selection = editor.getSelection();
 	selection.start(Selection::INTERNAL);
 
@@ -547,7 +552,7 @@ void ActionQueue::addBatch(BatchAction* batch, int stacking_delay) {
 	batch->commit();
 
 	// Update title
-	if (batch->isNoSelection() && editor.getMap().doChange()) {
+	if (batch->isNoSelection() && editor.getMap().doChange(true)) {
 		g_gui.UpdateTitle();
 	}
 
@@ -632,7 +637,7 @@ bool ActionQueue::undo() {
 		}
 
 		// Update title
-		if (batch && batch->isNoSelection() && editor.getMap().doChange()) {
+		if (batch && batch->isNoSelection() && editor.getMap().doChange(true)) {
 			g_gui.UpdateTitle();
 		}
 		return true;
@@ -649,7 +654,7 @@ bool ActionQueue::redo() {
 		current++;
 
 		// Update title
-		if (batch && batch->isNoSelection() && editor.getMap().doChange()) {
+		if (batch && batch->isNoSelection() && editor.getMap().doChange(true)) {
 			g_gui.UpdateTitle();
 		}
 		return true;
@@ -254,6 +254,10 @@ public:
 	bool empty() const noexcept {
 		return actions.empty();
 	}
+	// Approximate footprint of the whole history, kept below the undo memory setting
+	size_t getMemoryUsage() const noexcept {
+		return memory_size;
+	}
 
 	bool hasChanges() const;
 
@@ -35,6 +35,8 @@
 #include "complexitem.h"
 #include "monster.h"
 #include "npc.h"
+#include "memory_report.h"
+#include "worker_pool.h"
 
 #if defined(__LINUX__) || defined(__WINDOWS__)
 	#include <GL/glut.h>
@@ -86,7 +88,12 @@ EVT_SET_FOCUS(MapScrollBar::OnFocus)
 EVT_MOUSEWHEEL(MapScrollBar::OnWheel)
 END_EVENT_TABLE()
 
+#ifdef RME_TESTS
+// The tests link the editor and bring their own main()
+wxIMPLEMENT_APP_NO_MAIN(Application);
+#else
 wxIMPLEMENT_APP(Application);
+#endif
 
 Application::~Application() {
 	// Destroy
@@ -124,9 +131,12 @@ bool Application::OnInit() {
 	g_gui.LoadHotkeys();
 	ClientVersion::loadVersions();
 
+	m_file_to_open = wxEmptyString;
+	ParseCommandLineMap(m_file_to_open);
+
 #ifdef _USE_PROCESS_COM
 	m_single_instance_checker = newd wxSingleInstanceChecker; // Instance checker has to stay alive throughout the applications lifetime
-	if (g_settings.getInteger(Config::ONLY_ONE_INSTANCE) && m_single_instance_checker->IsAnotherRunning()) {
+	if (g_settings.getInteger(Config::ONLY_ONE_INSTANCE) && !m_memory_report && m_single_instance_checker->IsAnotherRunning()) {
 		RMEProcessClient client;
 		wxConnectionBase* connection = client.MakeConnection("localhost", "rme_host", "rme_talk");
 		if (connection) {
@@ -163,9 +173,6 @@ bool Application::OnInit() {
 	std::string error;
 	StringVector warnings;
 
-	m_file_to_open = wxEmptyString;
-	ParseCommandLineMap(m_file_to_open);
-
 	g_gui.root = newd MainFrame(__W_RME_APPLICATION_NAME__, wxDefaultPosition, wxSize(700, 500));
 	SetTopWindow(g_gui.root);
 	g_gui.SetTitle("");
@@ -178,7 +185,9 @@ bool Application::OnInit() {
 	wxIcon icon(rme_icon);
 	g_gui.root->SetIcon(icon);
 
-	if (g_settings.getInteger(Config::WELCOME_DIALOG) == 1 && m_file_to_open == wxEmptyString) {
+	if (m_memory_report) {
+		// Stays hidden, the report is printed once the map has been loaded
+	} else if (g_settings.getInteger(Config::WELCOME_DIALOG) == 1 && m_file_to_open == wxEmptyString) {
 		g_gui.ShowWelcomeDialog(icon);
 	} else {
 		g_gui.root->Show();
@@ -285,12 +294,19 @@ void Application::OnEventLoopEnter(wxEventLoopBase* loop) {
 
 	// Don't try to create a map if we didn't load the client map.
 	if (ClientVersion::getLatestVersion() == nullptr) {
+		if (m_memory_report) {
+			std::cerr << "No client version available, can not load the map." << std::endl;
+			g_gui.root->Close(true);
+		}
 		return;
 	}
 
 	// Open a map.
 	if (m_file_to_open != wxEmptyString) {
 		g_gui.LoadMap(FileName(m_file_to_open));
+		if (m_memory_report) {
+			PrintMemoryReport();
+		}
 	} else if (!g_gui.IsWelcomeDialogShown() && g_gui.NewMap()) { // Open a new empty map
 		// You generally don't want to save this map...
 		g_gui.GetCurrentEditor()->clearChanges();
@@ -351,13 +367,34 @@ void Application::OnFatalException() {
 }
 
 bool Application::ParseCommandLineMap(wxString &fileName) {
+	m_memory_report = false;
 	if (argc == 2) {
 		fileName = wxString(argv[1]);
 		return true;
 	}
+	// --memory-report <map>: load the map, print the memory report to stdout and quit
+	if (argc == 3 && wxString(argv[1]) == "--memory-report") {
+		m_memory_report = true;
+		fileName = wxString(argv[2]);
+		return true;
+	}
 	return false;
 }
 
+void Application::PrintMemoryReport() {
+	if (Editor* editor = g_gui.GetCurrentEditor()) {
+		MemoryReport report;
+		report.addEditor(*editor);
+		report.addItemPools();
+		report.addGraphics(g_gui.gfx);
+		std::cout << "Memory report for " << nstr(m_file_to_open) << "\n";
+		std::cout << report.toString() << std::flush;
+	} else {
+		std::cerr << "Could not load " << nstr(m_file_to_open) << std::endl;
+	}
+	g_gui.root->Close(true);
+}
+
 MainFrame::MainFrame(const wxString &title, const wxPoint &pos, const wxSize &size) :
 	wxFrame((wxFrame*)nullptr, -1, title, pos, size, wxDEFAULT_FRAME_STYLE) {
 	// Receive idle events
@@ -402,7 +439,32 @@ MainFrame::MainFrame(const wxString &title, const wxPoint &pos, const wxSize &si
 MainFrame::~MainFrame() = default;
 
 void MainFrame::OnIdle(wxIdleEvent &event) {
-	////
+	// A load bar yields to events in the middle of its work, which may be walking the very map
+	if (g_gui.HasLoadBar() || WorkerPool::isWaiting()) {
+		return;
+	}
+
+	// Lazily opened maps read the rest of their tiles a block at a time, one map per event
+	for (int index = 0; index < g_gui.GetTabCount(); ++index) {
+		auto* tab = dynamic_cast<MapTab*>(g_gui.GetTab(index));
+		Map* map = tab ? tab->GetMap() : nullptr;
+		if (!map) {
+			continue;
+		}
+		if (!map->hasPendingTiles()) {
+			map->updateSavedState();
+			continue;
+		}
+
+		if (map->loadPendingTiles(1)) {
+			event.RequestMore();
+		} else {
+			// The houses came in with the last block
+			g_gui.RefreshPalettes(map);
+			g_gui.RefreshView();
+		}
+		return;
+	}
 }
 
 #ifdef _USE_UPDATER_
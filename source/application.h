@@ -47,9 +47,11 @@ public:
 
 private:
 	bool m_startup;
+	bool m_memory_report;
 	wxString m_file_to_open;
 	void FixVersionDiscrapencies();
 	bool ParseCommandLineMap(wxString &fileName);
+	void PrintMemoryReport();
 
 	virtual void OnFatalException();
 
@@ -19,6 +19,8 @@
 
 #include "tile.h"
 #include "basemap.h"
+#include "map_traversal.h"
+#include "content_hash.h"
 
 BaseMap::BaseMap() :
 	allocator(),
@@ -32,6 +34,9 @@ BaseMap::~BaseMap() {
 }
 
 void BaseMap::clear(bool del) {
+	// Tiles that were never read don't need to be cleared
+	pending_tiles.reset();
+
 	PositionVector pos_vec;
 	for (MapIterator map_iter = begin(); map_iter != end(); ++map_iter) {
 		Tile* t = (*map_iter)->get();
@@ -42,13 +47,27 @@ void BaseMap::clear(bool del) {
 	}
 }
 
+QTreeNode* BaseMap::createLeaf(int x, int y) {
+	loadPendingTiles(x, y);
+#ifdef RME_MAP_SECTOR_TABLE
+	QTreeNode* leaf = sectors.getLeaf(x, y);
+	if (!leaf) {
+		leaf = root.getLeafForce(x, y);
+		sectors.setLeaf(x, y, leaf);
+	}
+	return leaf;
+#else
+	return root.getLeafForce(x, y);
+#endif
+}
+
 void BaseMap::clearVisible(uint32_t mask) {
 	root.clearVisible(mask);
 }
 
 Tile* BaseMap::createTile(int x, int y, int z) {
 	ASSERT(z < rme::MapLayers);
-	QTreeNode* leaf = root.getLeafForce(x, y);
+	QTreeNode* leaf = createLeaf(x, y);
 	TileLocation* loc = leaf->createTile(x, y, z);
 	if (loc->get()) {
 		return loc->get();
@@ -60,11 +79,11 @@ Tile* BaseMap::createTile(int x, int y, int z) {
 
 TileLocation* BaseMap::getTileL(int x, int y, int z) {
 	ASSERT(z < rme::MapLayers);
-	QTreeNode* leaf = root.getLeaf(x, y);
+	QTreeNode* leaf = getLeaf(x, y);
 	if (leaf) {
 		Floor* floor = leaf->getFloor(z);
 		if (floor) {
-			return &floor->locs[(x & 3) * 4 + (y & 3)];
+			return floor->getLocation((x & 3) * 4 + (y & 3));
 		}
 	}
 	return nullptr;
@@ -87,12 +106,126 @@ const TileLocation* BaseMap::getTileL(const Position &pos) const {
 TileLocation* BaseMap::createTileL(int x, int y, int z) {
 	ASSERT(z < rme::MapLayers);
 
-	QTreeNode* leaf = root.getLeafForce(x, y);
+	QTreeNode* leaf = createLeaf(x, y);
 	Floor* floor = leaf->createFloor(x, y, z);
 	uint32_t offsetX = x & 3;
 	uint32_t offsetY = y & 3;
 
-	return &floor->locs[offsetX * 4 + offsetY];
+	return floor->createLocation(allocator, offsetX * 4 + offsetY);
+}
+
+std::array<BaseMap::FloorUsage, rme::MapLayers> BaseMap::getFloorUsage() const {
+	std::array<FloorUsage, rme::MapLayers> usage;
+	std::vector<const QTreeNode*> nodes { &root };
+	while (!nodes.empty()) {
+		const QTreeNode* node = nodes.back();
+		nodes.pop_back();
+		if (!node->isLeaf) {
+			for (const QTreeNode* child : node->child) {
+				if (child) {
+					nodes.push_back(child);
+				}
+			}
+			continue;
+		}
+
+		for (int z = 0; z < rme::MapLayers; ++z) {
+			const Floor* floor = node->array[z];
+			if (!floor) {
+				continue;
+			}
+			FloorUsage &level = usage[z];
+			++level.floors;
+			if (floor->isDense()) {
+				++level.dense_floors;
+			}
+			level.locations += floor->getLocationCount();
+			level.bytes += floor->memsize();
+		}
+	}
+	return usage;
+}
+
+uint64_t BaseMap::getContentHash() {
+	loadAllPendingTiles();
+	if (root.content_hash == 0) {
+		// The cold subtrees are hashed in parallel, the levels above them then only combine
+		const std::vector<QTreeNode*> subtrees = MapTraversal::split(*this);
+		g_workers.run(subtrees.size(), [&subtrees](size_t index, size_t) {
+			subtrees[index]->getContentHash();
+		});
+	}
+	return root.getContentHash();
+}
+
+std::vector<Position> BaseMap::findDifferences(BaseMap &other) {
+	getContentHash();
+	other.getContentHash();
+
+	std::vector<Position> differences;
+	findDifferences(&root, &other.root, 0, 0, 0x10000, differences);
+	return differences;
+}
+
+void BaseMap::findDifferences(QTreeNode* node, QTreeNode* other, int node_x, int node_y, int side, std::vector<Position> &differences) {
+	const uint64_t node_hash = node ? node->getContentHash() : ContentHash::Empty;
+	const uint64_t other_hash = other ? other->getContentHash() : ContentHash::Empty;
+	if (node_hash == other_hash) {
+		return;
+	}
+
+	// Both trees have their leaves on the same level, a missing node is just empty
+	if ((node ? node : other)->isLeaf) {
+		for (int z = 0; z < rme::MapLayers; ++z) {
+			Floor* floor = node ? node->array[z] : nullptr;
+			Floor* other_floor = other ? other->array[z] : nullptr;
+			const uint64_t floor_hash = floor ? floor->getContentHash() : ContentHash::Empty;
+			const uint64_t other_floor_hash = other_floor ? other_floor->getContentHash() : ContentHash::Empty;
+			if (floor_hash != other_floor_hash) {
+				differences.emplace_back(node_x, node_y, z);
+			}
+		}
+		return;
+	}
+
+	const int child_side = side >> 2;
+	for (int i = 0; i < rme::MapLayers; ++i) {
+		QTreeNode* child = node ? node->child[i] : nullptr;
+		QTreeNode* other_child = other ? other->child[i] : nullptr;
+		if (child || other_child) {
+			findDifferences(child, other_child, node_x + (i & 3) * child_side, node_y + (i >> 2) * child_side, child_side, differences);
+		}
+	}
+}
+
+void BaseMap::loadPendingTiles(const Position &min, const Position &max) {
+	if (!pending_tiles) {
+		return;
+	}
+	for (int y = min.y & ~0xFF; y <= max.y; y += 0x100) {
+		for (int x = min.x & ~0xFF; x <= max.x; x += 0x100) {
+			loadPendingTiles(x, y);
+		}
+	}
+}
+
+bool BaseMap::loadPendingTiles(size_t count) {
+	if (!pending_tiles) {
+		return false;
+	}
+	pending_tiles->loadBlocks(count);
+	if (pending_tiles->getPendingCount() != 0) {
+		return true;
+	}
+
+	// Finishing may look tiles up again, which must not find us half done
+	std::unique_ptr<PendingTiles> tiles = std::move(pending_tiles);
+	tiles->finish();
+	return false;
+}
+
+void BaseMap::loadAllPendingTiles() {
+	loadPendingTiles(std::numeric_limits<size_t>::max());
 }
 
 TileLocation* BaseMap::createTileL(const Position &pos) {
@@ -104,11 +237,11 @@ void BaseMap::setTile(int x, int y, int z, Tile* new_tile, bool remove) {
 	ASSERT(!new_tile || new_tile->getY() == y);
 	ASSERT(!new_tile || new_tile->getZ() == z);
 
-	QTreeNode* leaf = root.getLeafForce(x, y);
+	QTreeNode* leaf = createLeaf(x, y);
 	Tile* old_tile = leaf->setTile(x, y, z, new_tile);
 
 	if ((remove && old_tile) || new_tile) {
-		updateUniqueIds(remove ? old_tile : nullptr, new_tile);
+		updateTileIndexes(remove ? old_tile : nullptr, new_tile);
 	}
 
 	if (remove) {
@@ -133,11 +266,11 @@ Tile* BaseMap::swapTile(int x, int y, int z, Tile* new_tile) {
 	ASSERT(!new_tile || new_tile->getY() == y);
 	ASSERT(!new_tile || new_tile->getZ() == z);
 
-	QTreeNode* leaf = root.getLeafForce(x, y);
+	QTreeNode* leaf = createLeaf(x, y);
 	Tile* old_tile = leaf->setTile(x, y, z, new_tile);
 
 	if (old_tile || new_tile) {
-		updateUniqueIds(old_tile, new_tile);
+		updateTileIndexes(old_tile, new_tile);
 	}
 
 	return old_tile;
@@ -172,6 +305,7 @@ MapIterator::MapIterator(const MapIterator &other) {
 }
 
 MapIterator BaseMap::begin() {
+	loadAllPendingTiles();
 	MapIterator it(this);
 	it.nodestack.push_back(MapIterator::NodeIndex(&root));
 
@@ -192,10 +326,10 @@ MapIterator BaseMap::begin() {
 						if (Floor* floor = leaf->array[it.local_z]) {
 							for (it.local_i = 0; it.local_i < 16; ++it.local_i) {
 								// printf("\tit(%d;%d;%d)\n", it.local_x, it.local_y, it.local_z);
-								TileLocation &t = floor->locs[it.local_i];
-								if (t.get()) {
+								TileLocation* t = floor->getLocation(it.local_i);
+								if (t && t->get()) {
 									// printf("return it\n");
-									it.current_tile = &t;
+									it.current_tile = t;
 									return it;
 								}
 							}
@@ -261,11 +395,11 @@ MapIterator &MapIterator::operator++() {
 							// printf("\n");
 							for (; local_i < rme::MapLayers; ++local_i) {
 								// printf("\t\tIterating over Y:%d of %p\n", local_y, child);
-								TileLocation &t = floor->locs[local_i];
-								if (t.get()) {
+								TileLocation* t = floor->getLocation(local_i);
+								if (t && t->get()) {
 									if (increased) {
 										// printf("Modified %p to %p\n", current_tile, t);
-										current_tile = &t;
+										current_tile = t;
 										return *this;
 									} else {
 										increased = true;
@@ -24,6 +24,10 @@
 #include "map_allocator.h"
 #include "tile.h"
 
+#include <array>
+#include <memory>
+#include <type_traits>
+
 // Class declarations
 class QTreeNode;
 class BaseMap;
@@ -32,6 +36,46 @@ class Floor;
 class QTreeNode;
 class TileLocation;
 
+// Tiles still waiting in the map file after a lazy open. The map reads the 256x256 block
+// of a position the first time it is touched, the rest is read a few blocks at a time.
+class PendingTiles {
+public:
+	virtual ~PendingTiles() = default;
+
+	bool isPending(int x, int y) const noexcept {
+		return pending_count != 0 && x >= 0 && y >= 0 && x <= 0xFFFF && y <= 0xFFFF && pending[getBlock(x, y)];
+	}
+	size_t getPendingCount() const noexcept {
+		return pending_count;
+	}
+
+	// Reads every floor of the block holding x, y
+	virtual void loadBlock(int x, int y) = 0;
+	// Reads up to count of the pending blocks
+	virtual void loadBlocks(size_t count) = 0;
+	// Called once no block is pending anymore, the map has already let go of us
+	virtual void finish() { }
+
+protected:
+	static uint32_t getBlock(int x, int y) noexcept {
+		return (uint32_t(y >> 8) << 8) | uint32_t(x >> 8);
+	}
+	void setPending(uint32_t block, bool value) {
+		if (pending[block] == value) {
+			return;
+		}
+		pending[block] = value;
+		if (value) {
+			++pending_count;
+		} else {
+			--pending_count;
+		}
+	}
+
+	std::vector<bool> pending = std::vector<bool>(0x10000);
+	size_t pending_count = 0;
+};
+
 class MapIterator {
 public:
 	MapIterator(BaseMap* _map = nullptr);
@@ -111,10 +155,27 @@ public:
 
 	// Get a Quad Tree Leaf from the map
 	QTreeNode* getLeaf(int x, int y) {
+		loadPendingTiles(x, y);
+#ifdef RME_MAP_SECTOR_TABLE
+		return sectors.getLeaf(x, y);
+#else
 		return root.getLeaf(x, y);
+#endif
 	}
-	QTreeNode* createLeaf(int x, int y) {
-		return root.getLeafForce(x, y);
+	QTreeNode* createLeaf(int x, int y);
+
+	// Calls func(Tile*) for every tile inside the box (bounds included), only walking the
+	// leaves and floors that exist, so empty space costs nothing.
+	// Floors are visited bottom-up per leaf. Within a floor, no tile is handed out before a tile with
+	// both a lower or equal x and y, but this is not the column by column order the drawing loops use,
+	// so overlapping sprites would blend differently there.
+	// If func returns bool, returning false stops the walk and visitRegion returns false.
+	template <typename Func>
+	bool visitRegion(const Position &min, const Position &max, Func &&func);
+	template <typename Func>
+	bool visitRegion(const Position &min, const Position &max, Func &&func) const {
+		// Same as getTileL, func should only take const tiles
+		return const_cast<BaseMap*>(this)->visitRegion(min, max, std::forward<Func>(func));
 	}
 
 	// Assigns a tile, it might seem pointless to provide position, but it is not, as the passed tile may be nullptr
@@ -128,23 +189,140 @@ public:
 	// Clears the visiblity according to the mask passed
 	void clearVisible(uint32_t mask);
 
+	// Merkle hash of every tile of the map, only what changed since the last call is hashed again.
+	// setTile and swapTile keep the cached hashes right, code changing a tile in place must drop them.
+	uint64_t getContentHash();
+	void invalidateContentHash(const Position &position) {
+		if (QTreeNode* leaf = getLeaf(position.x, position.y)) {
+			leaf->invalidateContentHash(position.z);
+		}
+	}
+	void clearContentHashes() {
+		root.clearContentHashes();
+	}
+	// Top left corner of every 4x4 floor block whose tiles differ between the two maps,
+	// only the subtrees whose hashes differ are walked
+	std::vector<Position> findDifferences(BaseMap &other);
+
 	uint64_t getTileCount() const noexcept {
 		return tilecount;
 	}
 
+	// A lazily opened map hands its unread tiles over here, every lookup reads in what it needs
+	void setPendingTiles(std::unique_ptr<PendingTiles> tiles) {
+		pending_tiles = std::move(tiles);
+	}
+	bool hasPendingTiles() const noexcept {
+		return pending_tiles != nullptr;
+	}
+	void loadPendingTiles(int x, int y) {
+		if (pending_tiles && pending_tiles->isPending(x, y)) {
+			pending_tiles->loadBlock(x, y);
+		}
+	}
+	void loadPendingTiles(const Position &min, const Position &max);
+	// Reads up to count pending blocks and finishes the pending tiles once none are left.
+	// Returns whether there is still something to read.
+	bool loadPendingTiles(size_t count);
+	// For code that walks the whole map
+	void loadAllPendingTiles();
+
+	// How the 4x4 floor blocks of one floor level are stored
+	struct FloorUsage {
+		uint64_t floors = 0;
+		uint64_t dense_floors = 0;
+		uint64_t locations = 0;
+		uint64_t bytes = 0;
+	};
+	std::array<FloorUsage, rme::MapLayers> getFloorUsage() const;
+
+	// Memory of the flat leaf index, if the map keeps one
+	size_t getSectorTableMemsize() const noexcept {
+#ifdef RME_MAP_SECTOR_TABLE
+		return sectors.memsize();
+#else
+		return 0;
+#endif
+	}
+
 public:
 	MapAllocator allocator;
 
 protected:
-	virtual void updateUniqueIds(Tile* old_tile, Tile* new_tile) { }
+	virtual void updateTileIndexes(Tile* old_tile, Tile* new_tile) { }
+
+	template <typename Func>
+	static bool visitNode(QTreeNode* node, int node_x, int node_y, int side, const Position &min, const Position &max, Func &func);
+	static void findDifferences(QTreeNode* node, QTreeNode* other, int node_x, int node_y, int side, std::vector<Position> &differences);
 
 	uint64_t tilecount;
 
 	QTreeNode root; // The Quad Tree root
+#ifdef RME_MAP_SECTOR_TABLE
+	SectorTable sectors; // Shortcut to the leaves of root
+#endif
+	std::unique_ptr<PendingTiles> pending_tiles; // Goes before the tiles it would read into
 
 	friend class QTreeNode;
+	friend class MapTraversal;
 };
 
+template <typename Func>
+bool BaseMap::visitRegion(const Position &min, const Position &max, Func &&func) {
+	const Position from(std::max(min.x, 0), std::max(min.y, 0), std::max(min.z, 0));
+	const Position to(std::min(max.x, 0xFFFF), std::min(max.y, 0xFFFF), std::min(max.z, rme::MapMaxLayer));
+	if (from.x > to.x || from.y > to.y || from.z > to.z) {
+		return true;
+	}
+	loadPendingTiles(from, to);
+	return visitNode(&root, 0, 0, 0x10000, from, to, func);
+}
+
+template <typename Func>
+bool BaseMap::visitNode(QTreeNode* node, int node_x, int node_y, int side, const Position &min, const Position &max, Func &func) {
+	if (node->isLeaf) {
+		for (int z = min.z; z <= max.z; ++z) {
+			Floor* floor = node->array[z];
+			if (!floor) {
+				continue;
+			}
+			for (TileLocation &location : *floor) {
+				Tile* tile = location.get();
+				const Position &position = location.getPosition();
+				if (!tile || position.x < min.x || position.x > max.x || position.y < min.y || position.y > max.y) {
+					continue;
+				}
+				if constexpr (std::is_same_v<std::invoke_result_t<Func &, Tile*>, bool>) {
+					if (!func(tile)) {
+						return false;
+					}
+				} else {
+					func(tile);
+				}
+			}
+		}
+		return true;
+	}
+
+	// Children are laid out like the tree lookup does, x in the low two bits of the index
+	const int child_side = side >> 2;
+	for (int i = 0; i < rme::MapLayers; ++i) {
+		QTreeNode* child = node->child[i];
+		if (!child) {
+			continue;
+		}
+		const int child_x = node_x + (i & 3) * child_side;
+		const int child_y = node_y + (i >> 2) * child_side;
+		if (child_x > max.x || child_x + child_side <= min.x || child_y > max.y || child_y + child_side <= min.y) {
+			continue;
+		}
+		if (!visitNode(child, child_x, child_y, child_side, min, max, func)) {
+			return false;
+		}
+	}
+	return true;
+}
+
 inline Tile* BaseMap::getTile(int x, int y, int z) {
 	TileLocation* l = getTileL(x, y, z);
 	return l ? l->get() : nullptr;
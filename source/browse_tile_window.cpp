@@ -97,7 +97,7 @@ void BrowseTileListBox::RemoveSelected() {
 
 void BrowseTileListBox::UpdateItems() {
 	int index = 0;
-	for (ItemVector::reverse_iterator it = editTile->items.rbegin(); it != editTile->items.rend(); ++it) {
+	for (TileItems::reverse_iterator it = editTile->items.rbegin(); it != editTile->items.rend(); ++it) {
 		items[index] = (*it);
 		++index;
 	}
@@ -290,9 +290,7 @@ void BrowseTileWindow::ChangeItemIndex(bool up /* = true*/) {
 	const auto tileItemsSize = tile->items.size() - 1;
 	auto index = tileItemsSize - selectedItemIndex;
 
-	const auto tmpItem = tile->items[index];
-	tile->items[index] = tile->items[index + i];
-	tile->items[index + i] = tmpItem;
+	tile->items.swap(index, index + i);
 
 	itemList->UpdateItems();
 
@@ -67,6 +67,11 @@ void Brushes::clear() {
 		delete borderEntry.second;
 	}
 	borders.clear();
+
+	brush_names.clear();
+	named_brushes.clear();
+	raw_names.clear();
+	named_raws.clear();
 }
 
 void Brushes::init() {
@@ -191,7 +196,56 @@ bool Brushes::unserializeBorder(pugi::xml_node node, wxArrayString &warnings) {
 }
 
 void Brushes::addBrush(Brush* brush) {
+	// Names may repeat, but a brush is only listed and indexed once
+	const auto [first, last] = brushes.equal_range(brush->getName());
+	if (std::any_of(first, last, [brush](const auto &entry) { return entry.second == brush; })) {
+		return;
+	}
+
 	brushes.insert(std::make_pair(brush->getName(), brush));
+	// Brushes made after loading, such as new monster types, are searchable right away
+	if (!named_brushes.empty() && !brush->isRaw()) {
+		brush_names.add(brush->getName());
+		named_brushes.push_back(brush);
+	}
+}
+
+void Brushes::buildNameIndex() {
+	brush_names.clear();
+	named_brushes.clear();
+	for (const auto &[name, brush] : brushes) {
+		if (!brush->isRaw()) {
+			brush_names.add(name);
+			named_brushes.push_back(brush);
+		}
+	}
+
+	// In item id order, like the RAW palette
+	raw_names.clear();
+	named_raws.clear();
+	for (int id = g_items.getMinID(); id <= g_items.getMaxID(); ++id) {
+		const ItemType &type = g_items.getItemType(id);
+		if (type.id != 0 && type.raw_brush) {
+			raw_names.add(type.raw_brush->getName());
+			named_raws.push_back(type.raw_brush);
+		}
+	}
+}
+
+std::vector<Brush*> Brushes::findBrushes(const std::string &text) const {
+	std::vector<Brush*> result;
+	for (const uint32_t handle : brush_names.find(text)) {
+		result.push_back(named_brushes[handle]);
+	}
+	return result;
+}
+
+std::vector<RAWBrush*> Brushes::findRawBrushes(const std::string &text) const {
+	std::vector<RAWBrush*> result;
+	for (const uint32_t handle : raw_names.find(text)) {
+		result.push_back(named_raws[handle]);
+	}
+	return result;
 }
 
 Brush* Brushes::getBrush(const std::string &name) const {
@@ -441,7 +495,7 @@ bool DoorBrush::canDraw(BaseMap* map, const Position &position) const {
 }
 
 void DoorBrush::undraw(BaseMap* map, Tile* tile) {
-	for (ItemVector::iterator it = tile->items.begin(); it != tile->items.end(); ++it) {
+	for (TileItems::iterator it = tile->items.begin(); it != tile->items.end(); ++it) {
 		Item* item = *it;
 		if (item->isBrushDoor()) {
 			item->getWallBrush()->draw(map, tile, nullptr);
@@ -454,7 +508,7 @@ void DoorBrush::undraw(BaseMap* map, Tile* tile) {
 }
 
 void DoorBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
-	for (ItemVector::iterator item_iter = tile->items.begin(); item_iter != tile->items.end();) {
+	for (TileItems::iterator item_iter = tile->items.begin(); item_iter != tile->items.end();) {
 		Item* item = *item_iter;
 		if (!item->isWall()) {
 			++item_iter;
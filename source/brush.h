@@ -22,6 +22,7 @@
 #include "position.h"
 
 #include "brush_enums.h"
+#include "name_index.h"
 
 // Thanks to a million forward declarations, we don't have to include any files!
 // TODO move to a declarations file.
@@ -80,11 +81,23 @@ public:
 		return brushes;
 	}
 
+	// Indexes the brush names for searching, once the RAW brushes exist
+	void buildNameIndex();
+	// Brushes whose name contains text, best matches first, without the RAW brushes
+	std::vector<Brush*> findBrushes(const std::string &text) const;
+	// RAW brushes whose name contains text, best matches first
+	std::vector<RAWBrush*> findRawBrushes(const std::string &text) const;
+
 protected:
 	typedef std::map<uint32_t, AutoBorder*> BorderMap;
 	BrushMap brushes;
 	BorderMap borders;
 
+	NameIndex brush_names;
+	std::vector<Brush*> named_brushes;
+	NameIndex raw_names;
+	std::vector<RAWBrush*> named_raws;
+
 	friend class AutoBorder;
 	friend class GroundBrush;
 };
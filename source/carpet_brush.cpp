@@ -158,8 +158,7 @@ void CarpetBrush::undraw(BaseMap* map, Tile* tile) {
 		if (item->isCarpet()) {
 			CarpetBrush* carpetBrush = item->getCarpetBrush();
 			if (carpetBrush) {
-				delete item;
-				it = items.erase(it);
+				it = tile->destroyItem(it);
 			} else {
 				++it;
 			}
@@ -176,8 +175,12 @@ void CarpetBrush::doCarpets(BaseMap* map, Tile* tile) {
 			return false;
 		}
 
-		for (Item* item : tile->items) {
-			if (item->getCarpetBrush() == carpetBrush) {
+		// Neighbours are only read, their records stay as they are
+		for (size_t index = 0; index < tile->items.size(); ++index) {
+			const bool matches = tile->items.visit(index, [carpetBrush](const Item &item) {
+				return item.getCarpetBrush() == carpetBrush;
+			});
+			if (matches) {
 				return true;
 			}
 		}
@@ -263,7 +266,7 @@ void CarpetBrush::doCarpets(BaseMap* map, Tile* tile) {
 		// border type is always valid.
 		uint16_t id = carpetBrush->getRandomCarpet(static_cast<BorderType>(carpet_types[tileData]));
 		if (id != 0) {
-			item->setID(id);
+			tile->changeItem(item, [id](Item* carpet) { carpet->setID(id); });
 		}
 	}
 }
@@ -1052,47 +1052,16 @@ void FindBrushDialog::OnClickOKInternal() {
 			bool do_search = (search_string.size() >= 2);
 
 			if (do_search) {
-				const BrushMap &map = g_brushes.getMap();
-				for (BrushMap::const_iterator iter = map.begin(); iter != map.end(); ++iter) {
-					const Brush* brush = iter->second;
-					if (as_lower_str(brush->getName()).find(search_string) == std::string::npos) {
-						continue;
-					}
-
-					// Don't match RAWs now.
-					if (brush->isRaw()) {
-						continue;
-					}
-
-					// Found one!
-					result_brush = brush;
-					break;
-				}
-
-				// Did we not find a matching brush?
-				if (!result_brush) {
-					// Then let's search the RAWs
-					for (int id = 0; id <= g_items.getMaxID(); ++id) {
-						const ItemType &type = g_items.getItemType(id);
-						if (type.id == 0) {
-							continue;
-						}
-
-						RAWBrush* raw_brush = type.raw_brush;
-						if (!raw_brush) {
-							continue;
-						}
-
-						if (as_lower_str(raw_brush->getName()).find(search_string) == std::string::npos) {
-							continue;
-						}
-
-						// Found one!
-						result_brush = raw_brush;
-						break;
+				// Prefer a brush, then search the RAWs
+				const std::vector<Brush*> brushes = g_brushes.findBrushes(search_string);
+				if (!brushes.empty()) {
+					result_brush = brushes.front();
+				} else {
+					const std::vector<RAWBrush*> raws = g_brushes.findRawBrushes(search_string);
+					if (!raws.empty()) {
+						result_brush = raws.front();
 					}
 				}
-				// Done!
 			}
 		} else {
 			result_brush = brush;
@@ -1109,52 +1078,18 @@ void FindBrushDialog::RefreshContentsInternal() {
 
 	if (do_search) {
 
-		bool found_search_results = false;
-
-		const BrushMap &brushes_map = g_brushes.getMap();
+		// The RAWs display last of all results
+		const std::vector<Brush*> brushes = g_brushes.findBrushes(search_string);
+		const std::vector<RAWBrush*> raws = g_brushes.findRawBrushes(search_string);
+		bool found_search_results = !brushes.empty() || !raws.empty();
 
-		// We store the raws so they display last of all results
-		std::deque<const RAWBrush*> raws;
-
-		for (BrushMap::const_iterator iter = brushes_map.begin(); iter != brushes_map.end(); ++iter) {
-			const Brush* brush = iter->second;
-
-			if (as_lower_str(brush->getName()).find(search_string) == std::string::npos) {
-				continue;
-			}
-
-			if (brush->isRaw()) {
-				continue;
-			}
-
-			found_search_results = true;
-			item_list->AddBrush(const_cast<Brush*>(brush));
+		for (Brush* brush : brushes) {
+			item_list->AddBrush(brush);
 		}
-
-		for (int id = 0; id <= g_items.getMaxID(); ++id) {
-			const ItemType &type = g_items.getItemType(id);
-			if (type.id == 0) {
-				continue;
-			}
-
-			RAWBrush* raw_brush = type.raw_brush;
-			if (!raw_brush) {
-				continue;
-			}
-
-			if (as_lower_str(raw_brush->getName()).find(search_string) == std::string::npos) {
-				continue;
-			}
-
-			found_search_results = true;
+		for (RAWBrush* raw_brush : raws) {
 			item_list->AddBrush(raw_brush);
 		}
 
-		while (raws.size() > 0) {
-			item_list->AddBrush(const_cast<RAWBrush*>(raws.front()));
-			raws.pop_front();
-		}
-
 		if (found_search_results) {
 			item_list->SetSelection(0);
 		} else {
@@ -20,6 +20,7 @@
 #include "complexitem.h"
 
 #include "iomap.h"
+#include "content_hash.h"
 
 // Container
 Container::Container(const uint16_t type) :
@@ -44,6 +45,14 @@ Item* Container::deepCopy() const {
 	return copy;
 }
 
+void Container::hashContent(ContentHash &hash) const {
+	Item::hashContent(hash);
+	hash.add(contents.size());
+	for (const Item* item : contents) {
+		item->hashContent(hash);
+	}
+}
+
 Item* Container::getItem(size_t index) const {
 	if (index >= 0 && index < contents.size()) {
 		return contents.at(index);
@@ -66,6 +75,13 @@ Item* Teleport::deepCopy() const {
 	return copy;
 }
 
+void Teleport::hashContent(ContentHash &hash) const {
+	Item::hashContent(hash);
+	hash.add(destination.x);
+	hash.add(destination.y);
+	hash.add(destination.z);
+}
+
 // Door
 Door::Door(const uint16_t type) :
 	Item(type, 0),
@@ -81,6 +97,11 @@ Item* Door::deepCopy() const {
 	return copy;
 }
 
+void Door::hashContent(ContentHash &hash) const {
+	Item::hashContent(hash);
+	hash.add(doorId);
+}
+
 // Depot
 Depot::Depot(const uint16_t type) :
 	Item(type, 0),
@@ -95,3 +116,8 @@ Item* Depot::deepCopy() const {
 	}
 	return copy;
 }
+
+void Depot::hashContent(ContentHash &hash) const {
+	Item::hashContent(hash);
+	hash.add(depotId);
+}
@@ -37,6 +37,7 @@ public:
 	~Container();
 
 	Item* deepCopy() const override;
+	void hashContent(ContentHash &hash) const override;
 	Container* getContainer() override {
 		return this;
 	}
@@ -46,6 +47,9 @@ public:
 	ItemVector &getVector() noexcept {
 		return contents;
 	}
+	const ItemVector &getVector() const noexcept {
+		return contents;
+	}
 	size_t getItemCount() const noexcept {
 		return contents.size();
 	}
@@ -70,6 +74,7 @@ public:
 	Teleport(const uint16_t type);
 
 	Item* deepCopy() const override;
+	void hashContent(ContentHash &hash) const override;
 	Teleport* getTeleport() override {
 		return this;
 	}
@@ -107,6 +112,7 @@ public:
 	Door(const uint16_t type);
 
 	Item* deepCopy() const override;
+	void hashContent(ContentHash &hash) const override;
 	Door* getDoor() override {
 		return this;
 	}
@@ -132,6 +138,7 @@ public:
 	Depot(const uint16_t _type);
 
 	Item* deepCopy() const override;
+	void hashContent(ContentHash &hash) const override;
 	Depot* getDepot() override {
 		return this;
 	}
@@ -0,0 +1,66 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_CONTENT_HASH_H
+#define RME_CONTENT_HASH_H
+
+#include <string>
+
+// Order dependent 64 bit hash of what the map would save. It doesn't depend on the
+// process or the platform, so two editors can compare the hashes of what they hold.
+class ContentHash {
+public:
+	// Hash of a tile, floor or node with nothing to save, the hextree skips those
+	static constexpr uint64_t Empty = 1;
+
+	void add(uint64_t value) noexcept {
+		state = mix(state ^ value) + 0x9E3779B97F4A7C15ull;
+	}
+	void add(const std::string &value) noexcept {
+		add(value.size());
+		uint64_t word = 0;
+		for (size_t i = 0; i < value.size(); ++i) {
+			word |= uint64_t(uint8_t(value[i])) << ((i % 8) * 8);
+			if (i % 8 == 7) {
+				add(word);
+				word = 0;
+			}
+		}
+		add(word);
+	}
+
+	// Never 0, which callers use for "not computed", nor Empty
+	uint64_t get() const noexcept {
+		const uint64_t value = mix(state);
+		return value > Empty ? value : value + 2;
+	}
+
+private:
+	static uint64_t mix(uint64_t value) noexcept {
+		value ^= value >> 33;
+		value *= 0xFF51AFD7ED558CCDull;
+		value ^= value >> 33;
+		value *= 0xC4CEB9FE1A85EC53ull;
+		value ^= value >> 33;
+		return value;
+	}
+
+	uint64_t state = 0;
+};
+
+#endif
@@ -276,7 +276,7 @@ bool DoodadBrush::ownsItem(Item* item) const {
 
 void DoodadBrush::undraw(BaseMap* map, Tile* tile) {
 	// Remove all doodad-related
-	for (ItemVector::iterator item_iter = tile->items.begin(); item_iter != tile->items.end();) {
+	for (TileItems::iterator item_iter = tile->items.begin(); item_iter != tile->items.end();) {
 		Item* item = *item_iter;
 		if (item->getDoodadBrush() != nullptr) {
 			if (item->isComplex() && g_settings.getInteger(Config::ERASER_LEAVE_UNIQUE)) {
@@ -284,14 +284,12 @@ void DoodadBrush::undraw(BaseMap* map, Tile* tile) {
 			} else if (g_settings.getInteger(Config::DOODAD_BRUSH_ERASE_LIKE)) {
 				// Only delete items of the same doodad brush
 				if (ownsItem(item)) {
-					delete item;
-					item_iter = tile->items.erase(item_iter);
+					item_iter = tile->destroyItem(item_iter);
 				} else {
 					++item_iter;
 				}
 			} else {
-				delete item;
-				item_iter = tile->items.erase(item_iter);
+				item_iter = tile->destroyItem(item_iter);
 			}
 		} else {
 			++item_iter;
@@ -302,12 +300,10 @@ void DoodadBrush::undraw(BaseMap* map, Tile* tile) {
 		if (g_settings.getInteger(Config::DOODAD_BRUSH_ERASE_LIKE)) {
 			// Only delete items of the same doodad brush
 			if (ownsItem(tile->ground)) {
-				delete tile->ground;
-				tile->ground = nullptr;
+				tile->setGround(nullptr);
 			}
 		} else {
-			delete tile->ground;
-			tile->ground = nullptr;
+			tile->setGround(nullptr);
 		}
 	}
 }
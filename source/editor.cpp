@@ -213,6 +213,11 @@ void Editor::undo(int indexes) {
 		}
 		indexes--;
 	}
+	// Stepping back to what is on disk leaves nothing to save
+	if (map.hasChanged() && map.matchesSavedState()) {
+		map.clearChanges();
+		g_gui.UpdateTitle();
+	}
 	g_gui.UpdateActions();
 	g_gui.RefreshView();
 }
@@ -228,6 +233,11 @@ void Editor::redo(int indexes) {
 		}
 		indexes--;
 	}
+	// Stepping back to what is on disk leaves nothing to save
+	if (map.hasChanged() && map.matchesSavedState()) {
+		map.clearChanges();
+		g_gui.UpdateTitle();
+	}
 	g_gui.UpdateActions();
 	g_gui.RefreshView();
 }
@@ -262,6 +272,9 @@ void Editor::clearChanges() {
 }
 
 void Editor::saveMap(FileName filename, bool showdialog) {
+	// What is still only in the opened file has to be read before the file is moved to the backups
+	map.loadAllPendingTiles();
+
 	std::string savefile = filename.GetFullPath().mb_str(wxConvUTF8).data();
 	bool save_as = false;
 	bool save_otgz = false;
@@ -419,6 +432,11 @@ void Editor::saveMap(FileName filename, bool showdialog) {
 		if (!success) {
 			return;
 		}
+
+		const size_t area_nodes = mapsaver.getAreaNodeCount();
+		wxString ss;
+		ss << "Saved " << area_nodes << " tile area" << (area_nodes != 1 ? "s" : "") << " (" << mapsaver.getIteratorAreaNodeCount() << " in the old tile order, " << mapsaver.getAreaBytesSaved() << " bytes saved)";
+		g_gui.SetStatusText(ss);
 	}
 
 	// Move to permanent backup
@@ -501,6 +519,9 @@ bool Editor::importMap(FileName filename, int import_x_offset, int import_y_offs
 		g_gui.PopupDialog("Error", "Error loading map!\n" + imported_map.getError(), wxOK | wxICON_INFORMATION);
 		return false;
 	}
+	// Merging the houses needs all of them, which lazily opened maps only know once every tile was read
+	map.loadRemainingTiles();
+	imported_map.loadRemainingTiles();
 	g_gui.ListDialog("Warning", imported_map.getWarnings());
 
 	Position offset(import_x_offset, import_y_offset, import_z_offset);
@@ -823,7 +844,7 @@ bool Editor::importMap(FileName filename, int import_x_offset, int import_y_offs
 		}
 
 		if (offset != Position(0, 0, 0)) {
-			for (ItemVector::iterator iter = import_tile->items.begin(); iter != import_tile->items.end(); ++iter) {
+			for (TileItems::iterator iter = import_tile->items.begin(); iter != import_tile->items.end(); ++iter) {
 				Item* item = *iter;
 				if (Teleport* teleport = dynamic_cast<Teleport*>(item)) {
 					teleport->setDestination(teleport->getDestination() + offset);
@@ -915,7 +936,10 @@ void Editor::borderizeMap(bool showdialog) {
 		Tile* tile = tileLocation->get();
 		ASSERT(tile);
 
+		map.beforeTileChange(tile);
 		tile->borderize(&map);
+		tile->settleFlags();
+		map.tileChanged(tile);
 		++tiles_done;
 	}
 
@@ -940,8 +964,10 @@ void Editor::randomizeSelection() {
 			Item* old_ground = tile->ground;
 			Item* new_ground = new_tile->ground;
 			if (old_ground && new_ground) {
-				new_ground->setActionID(old_ground->getActionID());
-				new_ground->setUniqueID(old_ground->getUniqueID());
+				new_tile->changeItem(new_ground, [old_ground](Item* ground) {
+					ground->setActionID(old_ground->getActionID());
+					ground->setUniqueID(old_ground->getUniqueID());
+				});
 			}
 
 			new_tile->select();
@@ -978,14 +1004,18 @@ void Editor::randomizeMap(bool showdialog) {
 				actionId = 0;
 				uniqueId = 0;
 			}
+			map.beforeTileChange(tile);
 			groundBrush->draw(&map, tile, nullptr);
 
 			Item* newGround = tile->ground;
 			if (newGround) {
-				newGround->setActionID(actionId);
-				newGround->setUniqueID(uniqueId);
+				tile->changeItem(newGround, [actionId, uniqueId](Item* ground) {
+					ground->setActionID(actionId);
+					ground->setUniqueID(uniqueId);
+				});
 			}
-			tile->update();
+			tile->settleFlags();
+			map.tileChanged(tile);
 		}
 		++tiles_done;
 	}
@@ -996,6 +1026,9 @@ void Editor::randomizeMap(bool showdialog) {
 }
 
 void Editor::clearInvalidHouseTiles(bool showdialog) {
+	// Tiles read after the houses were cleaned up would bring them back
+	map.loadRemainingTiles();
+
 	if (showdialog) {
 		g_gui.CreateLoadBar("Clearing invalid house tiles...");
 	}
@@ -1037,7 +1070,10 @@ void Editor::clearInvalidHouseTiles(bool showdialog) {
 		ASSERT(tile);
 		if (tile->isHouseTile()) {
 			if (houses.getHouse(tile->getHouseID()) == nullptr) {
+				map.beforeTileChange(tile);
 				tile->setHouse(nullptr);
+				tile->settleFlags();
+				map.tileChanged(tile);
 			}
 		}
 		++tiles_done;
@@ -1484,7 +1520,7 @@ void Editor::drawInternal(Position offset, bool alt, bool dodraw) {
 				if (tile) {
 					bool place = true;
 					if (!doodad_brush->placeOnDuplicate() && !alt) {
-						for (ItemVector::const_iterator iter = tile->items.begin(); iter != tile->items.end(); ++iter) {
+						for (TileItems::const_iterator iter = tile->items.begin(); iter != tile->items.end(); ++iter) {
 							if (doodad_brush->ownsItem(*iter)) {
 								place = false;
 								break;
@@ -1509,7 +1545,7 @@ void Editor::drawInternal(Position offset, bool alt, bool dodraw) {
 				if (tile && !tile->isBlocking()) {
 					bool place = true;
 					if (!doodad_brush->placeOnDuplicate() && !alt) {
-						for (ItemVector::const_iterator iter = tile->items.begin(); iter != tile->items.end(); ++iter) {
+						for (TileItems::const_iterator iter = tile->items.begin(); iter != tile->items.end(); ++iter) {
 							if (doodad_brush->ownsItem(*iter)) {
 								place = false;
 								break;
@@ -46,24 +46,21 @@ bool EraserBrush::canDraw(BaseMap* map, const Position &position) const {
 }
 
 void EraserBrush::undraw(BaseMap* map, Tile* tile) {
-	for (ItemVector::iterator item_iter = tile->items.begin(); item_iter != tile->items.end();) {
+	for (TileItems::iterator item_iter = tile->items.begin(); item_iter != tile->items.end();) {
 		Item* item = *item_iter;
 		if (item->isComplex() && g_settings.getInteger(Config::ERASER_LEAVE_UNIQUE)) {
 			++item_iter;
 		} else {
-			delete item;
-			item_iter = tile->items.erase(item_iter);
+			item_iter = tile->destroyItem(item_iter);
 		}
 	}
 	if (tile->ground) {
 		if (g_settings.getInteger(Config::ERASER_LEAVE_UNIQUE)) {
 			if (!tile->ground->isComplex()) {
-				delete tile->ground;
-				tile->ground = nullptr;
+				tile->setGround(nullptr);
 			}
 		} else {
-			delete tile->ground;
-			tile->ground = nullptr;
+			tile->setGround(nullptr);
 		}
 	}
 }
@@ -77,8 +74,7 @@ void EraserBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 			//} else if(item->getDoodadBrush()) {
 			//++item_iter;
 		} else {
-			delete item;
-			itemIter = tile->items.erase(itemIter);
+			itemIter = tile->destroyItem(itemIter);
 		}
 	}
 
@@ -19,6 +19,15 @@
 
 #include "filehandle.h"
 
+#ifdef __WINDOWS__
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
 uint8_t NodeFileWriteHandle::NODE_START = ::NODE_START;
 uint8_t NodeFileWriteHandle::NODE_END = ::NODE_END;
 uint8_t NodeFileWriteHandle::ESCAPE_CHAR = ::ESCAPE_CHAR;
@@ -142,6 +151,7 @@ bool FileReadHandle::getLongString(std::string &str) {
 
 NodeFileReadHandle::NodeFileReadHandle() :
 	last_was_start(false),
+	stable_cache(false),
 	cache(nullptr),
 	cache_size(32768),
 	cache_length(0),
@@ -178,8 +188,9 @@ void NodeFileReadHandle::freeNode(BinaryNode* node) {
 //=============================================================================
 // Memory based node file read handle
 
-MemoryNodeFileReadHandle::MemoryNodeFileReadHandle(const uint8_t* data, size_t size) {
+MemoryNodeFileReadHandle::MemoryNodeFileReadHandle(const uint8_t* data, size_t size, bool outlives_nodes /* = false*/) {
 	assign(data, size);
+	stable_cache = outlives_nodes;
 }
 
 void MemoryNodeFileReadHandle::assign(const uint8_t* data, size_t size) {
@@ -299,11 +310,135 @@ BinaryNode* DiskNodeFileReadHandle::getRootNode() {
 	}
 }
 
+//=============================================================================
+// Memory mapped node file read handle
+
+MappedNodeFileReadHandle::MappedNodeFileReadHandle(const std::string &name, const std::vector<std::string> &acceptable_identifiers) :
+	mapping(nullptr),
+	mapping_size(0) {
+#ifdef __WINDOWS__
+	mapping_handle = nullptr;
+	HANDLE handle = CreateFileW(string2wstring(name).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		error_code = FILE_COULD_NOT_OPEN;
+		return;
+	}
+
+	LARGE_INTEGER file_size;
+	if (GetFileSizeEx(handle, &file_size) && file_size.QuadPart >= 4) {
+		mapping_handle = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping_handle) {
+			mapping = static_cast<uint8_t*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+			mapping_size = static_cast<size_t>(file_size.QuadPart);
+		}
+	}
+	// The mapping keeps the file open
+	CloseHandle(handle);
+#else
+	const int fd = open(name.c_str(), O_RDONLY);
+	if (fd == -1) {
+		error_code = FILE_COULD_NOT_OPEN;
+		return;
+	}
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) == 0 && file_stat.st_size >= 4) {
+		void* address = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (address != MAP_FAILED) {
+			mapping = static_cast<uint8_t*>(address);
+			mapping_size = file_stat.st_size;
+			madvise(address, mapping_size, MADV_SEQUENTIAL);
+		}
+	}
+	// The mapping keeps the file open
+	::close(fd);
+#endif
+
+	if (!mapping) {
+		close();
+		error_code = FILE_COULD_NOT_OPEN;
+		return;
+	}
+
+	// 0x00 00 00 00 is accepted as a wildcard version
+	if (memcmp(mapping, "\0\0\0\0", 4) != 0) {
+		bool accepted = false;
+		for (const std::string &identifier : acceptable_identifiers) {
+			if (memcmp(mapping, identifier.c_str(), 4) == 0) {
+				accepted = true;
+				break;
+			}
+		}
+
+		if (!accepted) {
+			close();
+			error_code = FILE_SYNTAX_ERROR;
+			return;
+		}
+	}
+
+	stable_cache = true;
+	cache = mapping + 4;
+	cache_size = cache_length = mapping_size - 4;
+	local_read_index = 0;
+}
+
+MappedNodeFileReadHandle::~MappedNodeFileReadHandle() {
+	close();
+}
+
+void MappedNodeFileReadHandle::close() {
+	freeNode(root_node);
+	root_node = nullptr;
+	cache = nullptr;
+	cache_size = cache_length = 0;
+	local_read_index = 0;
+
+#ifdef __WINDOWS__
+	if (mapping) {
+		UnmapViewOfFile(mapping);
+	}
+	if (mapping_handle) {
+		CloseHandle(mapping_handle);
+		mapping_handle = nullptr;
+	}
+#else
+	if (mapping) {
+		munmap(mapping, mapping_size);
+	}
+#endif
+	mapping = nullptr;
+	mapping_size = 0;
+}
+
+bool MappedNodeFileReadHandle::renewCache() {
+	// Everything is mapped from the start
+	return false;
+}
+
+BinaryNode* MappedNodeFileReadHandle::getRootNode() {
+	assert(root_node == nullptr); // You should never do this twice
+
+	if (cache_length == 0 || cache[0] != NODE_START) {
+		error_code = FILE_SYNTAX_ERROR;
+		return nullptr;
+	}
+
+	local_read_index = 1;
+	last_was_start = true;
+	root_node = getNode(nullptr);
+	root_node->load();
+	return root_node;
+}
+
 //=============================================================================
 // Binary file node
 
 BinaryNode::BinaryNode(NodeFileReadHandle* file, BinaryNode* parent) :
+	data(nullptr),
+	data_size(0),
 	read_offset(0),
+	start_offset(0),
 	file(file),
 	parent(parent),
 	child(nullptr) {
@@ -327,21 +462,21 @@ BinaryNode* BinaryNode::getChild() {
 }
 
 bool BinaryNode::getRAW(uint8_t* ptr, size_t sz) {
-	if (read_offset + sz > data.size()) {
-		read_offset = data.size();
+	if (read_offset + sz > data_size) {
+		read_offset = data_size;
 		return false;
 	}
-	memcpy(ptr, data.data() + read_offset, sz);
+	memcpy(ptr, data + read_offset, sz);
 	read_offset += sz;
 	return true;
 }
 
 bool BinaryNode::getRAW(std::string &str, size_t sz) {
-	if (read_offset + sz > data.size()) {
-		read_offset = data.size();
+	if (read_offset + sz > data_size) {
+		read_offset = data_size;
 		return false;
 	}
-	str.assign(data.data() + read_offset, sz);
+	str.assign(reinterpret_cast<const char*>(data) + read_offset, sz);
 	read_offset += sz;
 	return true;
 }
@@ -406,7 +541,6 @@ BinaryNode* BinaryNode::advance() {
 			// Another node follows this.
 			// Load this node as the next one
 			read_offset = 0;
-			data.clear();
 			load();
 			return this;
 		} else if (op == NODE_END) {
@@ -422,12 +556,78 @@ BinaryNode* BinaryNode::advance() {
 	}
 }
 
+bool BinaryNode::extract(const uint8_t* &bytes, size_t &length) {
+	ASSERT(file);
+	if (!file->stable_cache || child != nullptr || file->error_code != FILE_NO_ERROR) {
+		return false;
+	}
+
+	const uint8_t* cache = file->cache;
+	const size_t cache_length = file->cache_length;
+	size_t index = file->local_read_index;
+
+	// Our own NODE_END is still ahead when load stopped at a child
+	size_t open = file->last_was_start ? 2 : 0;
+	while (open > 0 && index < cache_length) {
+		switch (cache[index]) {
+			case ESCAPE_CHAR:
+				++index;
+				break;
+			case NODE_START:
+				++open;
+				break;
+			case NODE_END:
+				--open;
+				break;
+			default:
+				break;
+		}
+		++index;
+	}
+
+	if (open > 0) {
+		file->error_code = FILE_PREMATURE_END;
+		return false;
+	}
+
+	bytes = cache + start_offset;
+	length = index - start_offset;
+	file->local_read_index = index;
+	file->last_was_start = false;
+	return true;
+}
+
 void BinaryNode::load() {
 	ASSERT(file);
 	// Read until next node starts
 	uint8_t*&cache = file->cache;
 	size_t &cache_length = file->cache_length;
 	size_t &local_read_index = file->local_read_index;
+
+	unescaped.clear();
+	start_offset = local_read_index - 1;
+	if (file->stable_cache) {
+		// Most nodes hold no escaped byte, those are used in place
+		const size_t start = local_read_index;
+		size_t end = start;
+		while (end < cache_length && cache[end] < ESCAPE_CHAR) {
+			++end;
+		}
+
+		if (end < cache_length && cache[end] != ESCAPE_CHAR) {
+			data = cache + start;
+			data_size = end - start;
+			local_read_index = end + 1;
+			file->last_was_start = cache[end] == NODE_START;
+			return;
+		}
+		// Copy what was scanned, the loop below unescapes the rest
+		unescaped.assign(reinterpret_cast<const char*>(cache + start), end - start);
+		local_read_index = end;
+	}
+
+	data = nullptr;
+	data_size = 0;
 	while (true) {
 		if (local_read_index >= cache_length) {
 			if (!file->renewCache()) {
@@ -443,11 +643,15 @@ void BinaryNode::load() {
 		switch (op) {
 			case NODE_START: {
 				file->last_was_start = true;
+				data = reinterpret_cast<const uint8_t*>(unescaped.data());
+				data_size = unescaped.size();
 				return;
 			}
 
 			case NODE_END: {
 				file->last_was_start = false;
+				data = reinterpret_cast<const uint8_t*>(unescaped.data());
+				data_size = unescaped.size();
 				return;
 			}
 
@@ -469,7 +673,7 @@ void BinaryNode::load() {
 				break;
 		}
 		// std::cout << "Appending..." << std::endl;
-		data.append(1, op);
+		unescaped.append(1, op);
 	}
 }
 
@@ -715,3 +919,17 @@ bool NodeFileWriteHandle::addRAW(const uint8_t* ptr, size_t sz) {
 	writeBytes(ptr, sz);
 	return error_code == FILE_NO_ERROR;
 }
+
+bool NodeFileWriteHandle::addEncoded(const uint8_t* ptr, size_t sz) {
+	while (sz != 0) {
+		const size_t count = std::min(sz, cache_size - local_write_index);
+		memcpy(cache + local_write_index, ptr, count);
+		local_write_index += count;
+		ptr += count;
+		sz -= count;
+		if (local_write_index >= cache_size) {
+			renewCache();
+		}
+	}
+	return error_code == FILE_NO_ERROR;
+}
@@ -124,6 +124,7 @@ protected:
 class NodeFileReadHandle;
 class DiskNodeFileReadHandle;
 class MemoryNodeFileReadHandle;
+class MappedNodeFileReadHandle;
 
 class BinaryNode {
 public:
@@ -146,8 +147,8 @@ public:
 		return getType(u64);
 	}
 	FORCEINLINE bool skip(size_t sz) {
-		if (read_offset + sz > data.size()) {
-			read_offset = data.size();
+		if (read_offset + sz > data_size) {
+			read_offset = data_size;
 			return false;
 		}
 		read_offset += sz;
@@ -162,28 +163,39 @@ public:
 	// Returns this on success, nullptr on failure
 	BinaryNode* advance();
 
+	// On a mapped file, hands out the bytes of this node and everything below it, from
+	// its NODE_START to its NODE_END, and moves past them as if the children were read.
+	// Another thread can then read them through a MemoryNodeFileReadHandle.
+	// Returns false when the file isn't mapped or the children were already visited.
+	bool extract(const uint8_t* &bytes, size_t &length);
+
 protected:
 	template <class T>
 	bool getType(T &ref) {
-		if (read_offset + sizeof(ref) > data.size()) {
-			read_offset = data.size();
+		if (read_offset + sizeof(ref) > data_size) {
+			read_offset = data_size;
 			return false;
 		}
-		ref = *(T*)(data.data() + read_offset);
+		memcpy(&ref, data + read_offset, sizeof(ref));
 
 		read_offset += sizeof(ref);
 		return true;
 	}
 
 	void load();
-	std::string data;
+	// Points into the file mapping, or into unescaped when the bytes had to be copied
+	const uint8_t* data;
+	size_t data_size;
+	std::string unescaped;
 	size_t read_offset;
+	size_t start_offset; // Of the NODE_START in the file cache
 	NodeFileReadHandle* file;
 	BinaryNode* parent;
 	BinaryNode* child;
 
 	friend class DiskNodeFileReadHandle;
 	friend class MemoryNodeFileReadHandle;
+	friend class MappedNodeFileReadHandle;
 };
 
 class NodeFileReadHandle : public FileHandle {
@@ -203,6 +215,8 @@ protected:
 	virtual bool renewCache() = 0;
 
 	bool last_was_start;
+	// The cache holds the whole file and outlives the nodes, so they can point into it
+	bool stable_cache;
 	uint8_t* cache;
 	size_t cache_size;
 	size_t cache_length;
@@ -242,7 +256,8 @@ protected:
 class MemoryNodeFileReadHandle : public NodeFileReadHandle {
 public:
 	// Does NOT claim ownership of the memory it is given.
-	MemoryNodeFileReadHandle(const uint8_t* data, size_t size);
+	// When it outlives the nodes, they point into it instead of copying.
+	MemoryNodeFileReadHandle(const uint8_t* data, size_t size, bool outlives_nodes = false);
 	virtual ~MemoryNodeFileReadHandle();
 
 	void assign(const uint8_t* data, size_t size);
@@ -266,6 +281,41 @@ protected:
 	uint8_t* index;
 };
 
+// Maps the whole file into memory instead of reading it through the cache.
+// Nodes without escaped bytes point straight into the mapping, only the
+// others are copied while unescaping.
+class MappedNodeFileReadHandle : public NodeFileReadHandle {
+public:
+	MappedNodeFileReadHandle(const std::string &name, const std::vector<std::string> &acceptable_identifiers);
+	virtual ~MappedNodeFileReadHandle();
+
+	virtual void close();
+	virtual BinaryNode* getRootNode();
+
+	virtual bool isOpen() {
+		return mapping != nullptr;
+	}
+	virtual bool isOk() {
+		return isOpen() && error_code == FILE_NO_ERROR;
+	}
+
+	virtual size_t size() {
+		return mapping_size;
+	}
+	virtual size_t tell() {
+		return local_read_index + 4;
+	}
+
+protected:
+	virtual bool renewCache();
+
+	uint8_t* mapping;
+	size_t mapping_size;
+#ifdef __WINDOWS__
+	void* mapping_handle;
+#endif
+};
+
 class FileWriteHandle : public FileHandle {
 public:
 	explicit FileWriteHandle(const std::string &name);
@@ -324,6 +374,8 @@ public:
 	bool addRAW(const char* c) {
 		return addRAW(reinterpret_cast<const uint8_t*>(c), strlen(c));
 	}
+	// Appends the output of another node writer as it is, its nodes and escapes included
+	bool addEncoded(const uint8_t* ptr, size_t sz);
 
 protected:
 	virtual void renewCache() = 0;
@@ -377,6 +429,10 @@ public:
 
 	uint8_t* getMemory();
 	size_t getSize();
+	// Bytes allocated for the buffer, not just the used part
+	size_t getCapacity() const noexcept {
+		return cache ? cache_size : 0;
+	}
 
 protected:
 	virtual void renewCache();
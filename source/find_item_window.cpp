@@ -342,22 +342,8 @@ void FindItemDialog::RefreshContentsInternal() {
 	} else if (selection == SearchMode::Names) {
 		std::string search_string = as_lower_str(nstr(name_text_input->GetValue()));
 		if (search_string.size() >= 2) {
-			for (int id = g_items.getMinID(); id <= g_items.getMaxID(); ++id) {
-				const ItemType &item = g_items.getItemType(id);
-				if (item.id == 0) {
-					continue;
-				}
-
-				RAWBrush* raw_brush = item.raw_brush;
-				if (!raw_brush) {
-					continue;
-				}
-
-				if (only_pickupables && !item.pickupable) {
-					continue;
-				}
-
-				if (as_lower_str(raw_brush->getName()).find(search_string) == std::string::npos) {
+			for (RAWBrush* raw_brush : g_brushes.findRawBrushes(search_string)) {
+				if (only_pickupables && !raw_brush->getItemType()->pickupable) {
 					continue;
 				}
 
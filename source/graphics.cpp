@@ -202,6 +202,23 @@ bool GraphicManager::isUnloaded() const {
 	return unloaded;
 }
 
+GraphicManager::CacheUsage GraphicManager::getCacheUsage() const {
+	CacheUsage usage;
+	usage.sprites = sprite_space.size();
+	usage.images = image_space.size();
+	for (const auto &[id, image] : image_space) {
+		// Only sprite data images are kept here, see loadSpriteMetadata
+		const GameSprite::NormalImage* normal = static_cast<const GameSprite::NormalImage*>(image);
+		usage.image_bytes += sizeof(GameSprite::NormalImage);
+		if (normal && normal->dump) {
+			usage.image_bytes += normal->size;
+		}
+	}
+	usage.textures = loaded_textures;
+	usage.texture_bytes = static_cast<size_t>(loaded_textures) * rme::SpritePixelsSize * 4;
+	return usage;
+}
+
 GLuint GraphicManager::getFreeTextureID() {
 	static GLuint id_counter = 0x10000000;
 	return id_counter++; // This should (hopefully) never run out
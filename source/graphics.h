@@ -334,6 +334,16 @@ public:
 	bool hasTransparency() const;
 	bool isUnloaded() const;
 
+	// What the sprite caches hold right now
+	struct CacheUsage {
+		size_t sprites = 0;
+		size_t images = 0;
+		size_t image_bytes = 0; // Including the sprite data kept in memory
+		size_t textures = 0;
+		size_t texture_bytes = 0; // Uploaded to the driver, not necessarily in system memory
+	};
+	CacheUsage getCacheUsage() const;
+
 	ClientVersion* client_version;
 
 private:
@@ -524,8 +524,7 @@ bool GroundBrush::load(pugi::xml_node node, wxArrayString &warnings) {
 void GroundBrush::undraw(BaseMap* map, Tile* tile) {
 	ASSERT(tile);
 	if (tile->hasGround() && tile->ground->getGroundBrush() == this) {
-		delete tile->ground;
-		tile->ground = nullptr;
+		tile->setGround(nullptr);
 	}
 }
 
@@ -965,8 +964,7 @@ void GroundBrush::doBorders(BaseMap* map, Tile* tile) {
 						bool inc = true;
 						for (uint16_t matchId : specificCaseBlock->items_to_match) {
 							if (item->getID() == matchId) {
-								delete item;
-								it = tileItems.erase(it);
+								it = tile->destroyItem(it);
 								inc = false;
 								break;
 							}
@@ -985,7 +983,7 @@ void GroundBrush::doBorders(BaseMap* map, Tile* tile) {
 						}
 
 						if (item->getID() == specificCaseBlock->to_replace_id) {
-							item->setID(specificCaseBlock->with_id);
+							tile->changeItem(item, [id = specificCaseBlock->with_id](Item* border) { border->setID(id); });
 							return;
 						}
 						++it;
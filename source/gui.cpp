@@ -410,6 +410,8 @@ bool GUI::LoadDataFiles(wxString &error, wxArrayString &warnings) {
 	g_brushes.init();
 	g_materials.createOtherTileset();
 	g_materials.createNpcTileset();
+	g_items.buildPropertyTable();
+	g_brushes.buildNameIndex();
 
 	g_gui.DestroyLoadBar();
 	return true;
@@ -180,6 +180,9 @@ public:
 	 * Destroys (hides) the current loading bar.
 	 */
 	void DestroyLoadBar();
+	bool HasLoadBar() const noexcept {
+		return progressBar != nullptr;
+	}
 
 	void UpdateMenubar();
 
@@ -22,6 +22,8 @@
 #include "tile.h"
 #include "map.h"
 
+#include <bitset>
+
 Houses::Houses(Map &map) :
 	map(map),
 	max_house_id(0) {
@@ -85,15 +87,20 @@ House::House(Map &map) :
 	clientid(0),
 	beds(0),
 	map(&map),
-	exit(0, 0, 0) {
+	exit(0, 0, 0),
+	tile_count(0),
+	bounds_dirty(false) {
 	////
 }
 
 void House::clean() {
-	for (PositionList::const_iterator pos_iter = tiles.begin(); pos_iter != tiles.end(); ++pos_iter) {
-		Tile* tile = map->getTile(*pos_iter);
+	for (const auto &[position, counted] : tiles) {
+		Tile* tile = map->getTile(position);
 		if (tile) {
+			map->beforeTileChange(tile);
 			tile->setHouse(nullptr);
+			tile->settleFlags();
+			map->tileChanged(tile);
 		}
 	}
 
@@ -103,50 +110,120 @@ void House::clean() {
 	}
 }
 
-size_t House::size() const {
-	size_t count = 0;
-	for (PositionList::const_iterator pos_iter = tiles.begin(); pos_iter != tiles.end(); ++pos_iter) {
-		auto tile = map->getTile(*pos_iter);
-		auto topItem = tile->getTopItem();
-		if (tile && (!tile->getWall() || tile->getTable() || topItem->isDoor())) {
-			++count;
+void House::updateTile(const Position &position, const Tile* tile) {
+	auto entry = tiles.find(position);
+	if (entry == tiles.end()) {
+		return;
+	}
+
+	forgetTile(entry);
+	if (!tile) {
+		return;
+	}
+
+	tile->items.forEach([&](const Item &item) {
+		if (const Door* door = dynamic_cast<const Door*>(&item)) {
+			doors.push_back({ door->getDoorID(), position });
+		}
+	});
+
+	bool doorOnTop = false;
+	tile->visitTopItem([&doorOnTop](const Item &item) {
+		doorOnTop = item.isDoor();
+	});
+	if (!tile->hasWall() || tile->hasTable() || doorOnTop) {
+		entry->second = true;
+		++tile_count;
+	}
+}
+
+void House::forgetTile(TileMap::iterator entry) {
+	if (entry->second) {
+		entry->second = false;
+		--tile_count;
+	}
+	const Position &position = entry->first;
+	std::erase_if(doors, [&position](const DoorEntry &door) {
+		return door.position == position;
+	});
+}
+
+const Position &House::getMinBound() const {
+	if (bounds_dirty) {
+		updateBounds();
+	}
+	return min_bound;
+}
+
+const Position &House::getMaxBound() const {
+	if (bounds_dirty) {
+		updateBounds();
+	}
+	return max_bound;
+}
+
+void House::updateBounds() const {
+	min_bound = Position();
+	max_bound = Position();
+	bool first = true;
+	for (const auto &[position, counted] : tiles) {
+		if (first) {
+			min_bound = max_bound = position;
+			first = false;
+		} else {
+			min_bound = Position(std::min(min_bound.x, position.x), std::min(min_bound.y, position.y), std::min(min_bound.z, position.z));
+			max_bound = Position(std::max(max_bound.x, position.x), std::max(max_bound.y, position.y), std::max(max_bound.z, position.z));
 		}
 	}
-	return count;
+	bounds_dirty = false;
+}
+
+size_t House::getListBytes() const noexcept {
+	const size_t node = sizeof(void*) + sizeof(TileMap::value_type);
+	return tiles.bucket_count() * sizeof(void*) + tiles.size() * node + doors.capacity() * sizeof(DoorEntry);
 }
 
 void House::addTile(Tile* tile) {
 	ASSERT(tile);
 	tile->setHouse(this);
-	tiles.push_back(tile->getPosition());
+
+	const Position &position = tile->getPosition();
+	const auto [entry, added] = tiles.try_emplace(position, false);
+	if (added && !bounds_dirty) {
+		if (tiles.size() == 1) {
+			min_bound = max_bound = position;
+		} else {
+			min_bound = Position(std::min(min_bound.x, position.x), std::min(min_bound.y, position.y), std::min(min_bound.z, position.z));
+			max_bound = Position(std::max(max_bound.x, position.x), std::max(max_bound.y, position.y), std::max(max_bound.z, position.z));
+		}
+	}
+	updateTile(position, tile);
 }
 
 void House::removeTile(Tile* tile) {
 	ASSERT(tile);
-	for (PositionList::iterator tile_iter = tiles.begin(); tile_iter != tiles.end(); ++tile_iter) {
-		if (*tile_iter == tile->getPosition()) {
-			tiles.erase(tile_iter);
-			tile->setHouse(nullptr);
-			return;
-		}
+	const Position &position = tile->getPosition();
+	auto entry = tiles.find(position);
+	if (entry == tiles.end()) {
+		return;
+	}
+
+	forgetTile(entry);
+	tiles.erase(entry);
+	tile->setHouse(nullptr);
+	if (position.x == min_bound.x || position.y == min_bound.y || position.z == min_bound.z || position.x == max_bound.x || position.y == max_bound.y || position.z == max_bound.z) {
+		bounds_dirty = true;
 	}
 }
 
 uint8_t House::getEmptyDoorID() const {
-	std::set<uint8_t> taken;
-	for (PositionList::const_iterator tile_iter = tiles.begin(); tile_iter != tiles.end(); ++tile_iter) {
-		if (const Tile* tile = map->getTile(*tile_iter)) {
-			for (ItemVector::const_iterator item_iter = tile->items.begin(); item_iter != tile->items.end(); ++item_iter) {
-				if (Door* door = dynamic_cast<Door*>(*item_iter)) {
-					taken.insert(door->getDoorID());
-				}
-			}
-		}
+	std::bitset<256> taken;
+	for (const DoorEntry &door : getDoors()) {
+		taken.set(door.id);
 	}
 
 	for (int i = 1; i < 256; ++i) {
-		std::set<uint8_t>::iterator it = taken.find(uint8_t(i));
-		if (it == taken.end()) {
+		if (!taken.test(i)) {
 			// Free ID!
 			return i;
 		}
@@ -155,15 +232,9 @@ uint8_t House::getEmptyDoorID() const {
 }
 
 Position House::getDoorPositionByID(uint8_t id) const {
-	for (PositionList::const_iterator tile_iter = tiles.begin(); tile_iter != tiles.end(); ++tile_iter) {
-		if (const Tile* tile = map->getTile(*tile_iter)) {
-			for (ItemVector::const_iterator item_iter = tile->items.begin(); item_iter != tile->items.end(); ++item_iter) {
-				if (Door* door = dynamic_cast<Door*>(*item_iter)) {
-					if (door->getDoorID() == id) {
-						return *tile_iter;
-					}
-				}
-			}
+	for (const DoorEntry &door : getDoors()) {
+		if (door.id == id) {
+			return door.position;
 		}
 	}
 	return Position();
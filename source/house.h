@@ -20,6 +20,8 @@
 
 #include "position.h"
 
+#include <unordered_map>
+
 class Map;
 class Tile;
 class Door;
@@ -33,7 +35,13 @@ public:
 	void clean();
 	void addTile(Tile* tile);
 	void removeTile(Tile* tile);
-	size_t size() const;
+	bool hasTile(const Position &position) const {
+		return tiles.contains(position);
+	}
+	// Tiles that count towards the house size, walls only count when they hold a table or a door
+	size_t size() const noexcept {
+		return tile_count;
+	}
 	std::string getDescription();
 
 	uint32_t id;
@@ -53,15 +61,47 @@ public:
 	uint8_t getEmptyDoorID() const;
 	Position getDoorPositionByID(uint8_t id) const;
 
-	const PositionList &getTiles() const {
+	struct DoorEntry {
+		uint8_t id;
+		Position position;
+	};
+	const std::vector<DoorEntry> &getDoors() const noexcept {
+		return doors;
+	}
+
+	// Corners of the box holding every tile, both invalid when the house has no tiles
+	const Position &getMinBound() const;
+	const Position &getMaxBound() const;
+
+	// Heap memory of the tile and door lists, without counting the doors again
+	size_t getListBytes() const noexcept;
+
+	// Each tile of the house, with whether it counts towards the size
+	using TileMap = std::unordered_map<Position, bool>;
+	const TileMap &getTiles() const noexcept {
 		return tiles;
 	}
 
+	// The map calls this whenever the tile at a house position changes, with nullptr before the
+	// change and the changed tile after it. Positions outside the house are ignored.
+	void updateTile(const Position &position, const Tile* tile);
+
 protected:
+	// Takes the tile's part out of the size and doors
+	void forgetTile(TileMap::iterator entry);
+	void updateBounds() const;
+
 	Map* map;
-	PositionList tiles;
+	TileMap tiles;
 	Position exit;
 
+	std::vector<DoorEntry> doors;
+	size_t tile_count;
+	// The box only grows as tiles are added, removing one from its edge has it computed again
+	mutable Position min_bound;
+	mutable Position max_bound;
+	mutable bool bounds_dirty;
+
 	friend class Houses;
 };
 
@@ -31,6 +31,10 @@
 #include "town.h"
 
 #include "iomap_otbm.h"
+#include "map_traversal.h"
+
+#include <condition_variable>
+#include <mutex>
 
 typedef uint8_t attribute_t;
 typedef uint32_t flags_t;
@@ -467,6 +471,83 @@ bool IOMapOTBM::getVersionInfo(NodeFileReadHandle* f, MapVersion &out_ver) {
 	return true;
 }
 
+// The areas of a mapped file indexed by 256x256 block, read with the same decoding and merging as a
+// full load. Blocks are read when the map touches them and in file order otherwise, which only
+// changes the order of the warnings.
+class IOMapOTBM::LazyTileAreas : public PendingTiles {
+public:
+	LazyTileAreas(Map &map, const FileName &filename) :
+		map(map),
+		filename(filename),
+		loader(map.getVersion()),
+		areas(0x10000) {
+		////
+	}
+
+	void addArea(uint16_t x, uint16_t y, const uint8_t* bytes, size_t length) {
+		const uint32_t block = getBlock(x, y);
+		if (areas[block].empty()) {
+			order.push_back(block);
+		}
+		areas[block].emplace_back(bytes, length);
+		setPending(block, true);
+	}
+
+	// Keeps the mapping the areas point into
+	void start(std::unique_ptr<MappedNodeFileReadHandle> mapped, const MapVersion &version) {
+		file = std::move(mapped);
+		loader.version = version;
+	}
+
+	void loadBlock(int x, int y) override {
+		std::vector<std::pair<const uint8_t*, size_t>> spans;
+		takeBlock(getBlock(x, y), spans);
+		loader.loadTileAreas(map, spans);
+	}
+
+	void loadBlocks(size_t count) override {
+		std::vector<std::pair<const uint8_t*, size_t>> spans;
+		for (; next != order.size() && count != 0; ++next) {
+			if (!pending[order[next]]) {
+				continue;
+			}
+			takeBlock(order[next], spans);
+			--count;
+			if (spans.size() >= AreaBatchSize) {
+				loader.loadTileAreas(map, spans);
+			}
+		}
+		loader.loadTileAreas(map, spans);
+	}
+
+	void finish() override {
+		loader.loadHouseFile(map, filename);
+		for (const wxString &warning : loader.getWarnings()) {
+			map.warnings.push_back(warning);
+		}
+		// Unless it was edited meanwhile, the map now holds what the file does
+		if (!map.hasChanged()) {
+			map.clearChanges();
+		}
+	}
+
+private:
+	void takeBlock(uint32_t block, std::vector<std::pair<const uint8_t*, size_t>> &spans) {
+		// Merging looks up the tiles of the block, which must not read it again
+		setPending(block, false);
+		spans.insert(spans.end(), areas[block].begin(), areas[block].end());
+		std::vector<std::pair<const uint8_t*, size_t>>().swap(areas[block]);
+	}
+
+	Map &map;
+	FileName filename;
+	IOMapOTBM loader;
+	std::unique_ptr<MappedNodeFileReadHandle> file;
+	std::vector<std::vector<std::pair<const uint8_t*, size_t>>> areas; // By block
+	std::vector<uint32_t> order; // Blocks by their first area in the file
+	size_t next = 0;
+};
+
 bool IOMapOTBM::loadMap(Map &map, const FileName &filename) {
 #if OTGZ_SUPPORT > 0
 	if (filename.GetExt() == "otgz") {
@@ -617,25 +698,61 @@ bool IOMapOTBM::loadMap(Map &map, const FileName &filename) {
 	}
 #endif
 
-	DiskNodeFileReadHandle f(nstr(filename.GetFullPath()), StringVector(1, "OTBM"));
-	if (!f.isOk()) {
-		error(("Couldn't open file for reading\nThe error reported was: " + wxstr(f.getErrorMessage())).wc_str());
-		return false;
-	}
+	// Reading through a mapping saves copying most nodes, the plain reader is
+	// only needed where the file can't be mapped
+	auto mapped = std::make_unique<MappedNodeFileReadHandle>(nstr(filename.GetFullPath()), StringVector(1, "OTBM"));
+	std::unique_ptr<LazyTileAreas> lazy;
+	if (mapped->isOk()) {
+		const uint64_t lazy_size = uint64_t(g_settings.getInteger(Config::LAZY_LOAD_MAP_SIZE)) * 1024 * 1024;
+		if (lazy_size != 0 && mapped->size() >= lazy_size) {
+			lazy = std::make_unique<LazyTileAreas>(map, filename);
+			lazy_areas = lazy.get();
+		}
+		const bool loaded = loadMap(map, *mapped);
+		lazy_areas = nullptr;
+		if (!loaded) {
+			return false;
+		}
+	} else {
+		mapped->close();
 
-	if (!loadMap(map, f)) {
-		return false;
+		DiskNodeFileReadHandle f(nstr(filename.GetFullPath()), StringVector(1, "OTBM"));
+		if (!f.isOk()) {
+			error(("Couldn't open file for reading\nThe error reported was: " + wxstr(f.getErrorMessage())).wc_str());
+			return false;
+		}
+
+		if (!loadMap(map, f)) {
+			return false;
+		}
 	}
 
 	// Read auxilliary files
-	if (!loadHouses(map, filename)) {
-		warning("Failed to load houses.");
-		map.housefile = nstr(filename.GetName()) + "-house.xml";
-	}
 	if (!loadZones(map, filename)) {
 		warning("Failed to load zones.");
 		map.zonefile = nstr(filename.GetName()) + "-zones.xml";
 	}
+	if (lazy && lazy->getPendingCount() != 0) {
+		lazy->start(std::move(mapped), version);
+		map.setPendingTiles(std::move(lazy));
+		// The spawns are read right away, looking up their tiles reads the blocks they are in.
+		// The houses need every tile that names them, they come last, see LazyTileAreas::finish
+		loadSpawnFiles(map, filename);
+	} else {
+		loadHouseFile(map, filename);
+		loadSpawnFiles(map, filename);
+	}
+	return true;
+}
+
+void IOMapOTBM::loadHouseFile(Map &map, const FileName &filename) {
+	if (!loadHouses(map, filename)) {
+		warning("Failed to load houses.");
+		map.housefile = nstr(filename.GetName()) + "-house.xml";
+	}
+}
+
+void IOMapOTBM::loadSpawnFiles(Map &map, const FileName &filename) {
 	if (!loadSpawnsMonster(map, filename)) {
 		warning("Failed to load monsters spawns.");
 		map.spawnmonsterfile = nstr(filename.GetName()) + "-monster.xml";
@@ -644,9 +761,21 @@ bool IOMapOTBM::loadMap(Map &map, const FileName &filename) {
 		warning("Failed to load npcs spawns.");
 		map.spawnnpcfile = nstr(filename.GetName()) + "-npc.xml";
 	}
-	return true;
 }
 
+struct IOMapOTBM::DecodedTileArea {
+	struct DecodedTile {
+		Position position;
+		Tile* tile; // nullptr when it was discarded after the duplicate check
+		uint32_t house_id;
+		size_t first_warning; // Warnings before the duplicate check
+		size_t warnings_end; // Warnings of the tile itself, dropped with a duplicate
+	};
+
+	std::vector<DecodedTile> tiles;
+	wxArrayString warnings;
+};
+
 bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 	BinaryNode* root = f.getRootNode();
 	if (!root) {
@@ -754,6 +883,7 @@ bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 	}
 
 	int nodes_loaded = 0;
+	std::vector<std::pair<const uint8_t*, size_t>> pending_areas;
 
 	for (BinaryNode* mapNode = mapHeaderNode->getChild(); mapNode != nullptr; mapNode = mapNode->advance()) {
 		++nodes_loaded;
@@ -766,130 +896,29 @@ bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 			warning("Invalid map node");
 			continue;
 		}
-		if (node_type == OTBM_TILE_AREA) {
-			uint16_t base_x, base_y;
-			uint8_t base_z;
-			if (!mapNode->getU16(base_x) || !mapNode->getU16(base_y) || !mapNode->getU8(base_z)) {
-				warning("Invalid map node, no base coordinate");
-				continue;
-			}
-
-			for (BinaryNode* tileNode = mapNode->getChild(); tileNode != nullptr; tileNode = tileNode->advance()) {
-				Tile* tile = nullptr;
-				uint8_t tile_type;
-				if (!tileNode->getByte(tile_type)) {
-					warning("Invalid tile type");
-					continue;
-				}
-				if (tile_type == OTBM_TILE || tile_type == OTBM_HOUSETILE) {
-					// printf("Start\n");
-					uint8_t x_offset, y_offset;
-					if (!tileNode->getU8(x_offset) || !tileNode->getU8(y_offset)) {
-						warning("Could not read position of tile");
-						continue;
-					}
-					const Position pos(base_x + x_offset, base_y + y_offset, base_z);
-
-					if (map.getTile(pos)) {
-						warning("Duplicate tile at %d:%d:%d, discarding duplicate", pos.x, pos.y, pos.z);
-						continue;
-					}
-
-					tile = map.allocator(map.createTileL(pos));
-					House* house = nullptr;
-					if (tile_type == OTBM_HOUSETILE) {
-						uint32_t house_id;
-						if (!tileNode->getU32(house_id)) {
-							warning("House tile without house data, discarding tile");
-							delete tile;
-							continue;
-						}
-						if (house_id) {
-							house = map.houses.getHouse(house_id);
-							if (!house) {
-								house = newd House(map);
-								house->id = house_id;
-								map.houses.addHouse(house);
-							}
-						} else {
-							warning("Invalid house id from tile %d:%d:%d", pos.x, pos.y, pos.z);
-						}
-					}
-
-					// printf("So far so good\n");
-
-					uint8_t attribute;
-					while (tileNode->getU8(attribute)) {
-						switch (attribute) {
-							case OTBM_ATTR_TILE_FLAGS: {
-								uint32_t flags = 0;
-								if (!tileNode->getU32(flags)) {
-									warning("Invalid tile flags of tile on %d:%d:%d", pos.x, pos.y, pos.z);
-								}
-								tile->setMapFlags(flags);
-								break;
-							}
-							case OTBM_ATTR_ITEM: {
-								Item* item = Item::Create_OTBM(*this, tileNode);
-								if (item == nullptr) {
-									warning("Invalid item at tile %d:%d:%d", pos.x, pos.y, pos.z);
-								}
-								tile->addItem(item);
-								break;
-							}
-							default: {
-								warning("Unknown tile attribute at %d:%d:%d", pos.x, pos.y, pos.z);
-								break;
-							}
-						}
-					}
-
-					// printf("Didn't die in loop\n");
-
-					for (BinaryNode* childNode = tileNode->getChild(); childNode != nullptr; childNode = childNode->advance()) {
-						Item* item = nullptr;
-						uint8_t node_type;
-						if (!childNode->getByte(node_type)) {
-							warning("Unknown item type %d:%d:%d", pos.x, pos.y, pos.z);
-							continue;
-						}
-						if (node_type == OTBM_ITEM) {
-							item = Item::Create_OTBM(*this, childNode);
-							if (item) {
-								if (!item->unserializeItemNode_OTBM(*this, childNode)) {
-									warning("Couldn't unserialize item attributes at %d:%d:%d", pos.x, pos.y, pos.z);
-								}
-								// reform(&map, tile, item);
-								tile->addItem(item);
-							}
-						} else if (node_type == OTBM_TILE_ZONE) {
-							uint16_t zone_count;
-							if (!childNode->getU16(zone_count)) {
-								warning("Invalid zone count at %d:%d:%d", pos.x, pos.y, pos.z);
-								continue;
-							}
-							for (uint16_t i = 0; i < zone_count; ++i) {
-								uint16_t zone_id;
-								if (!childNode->getU16(zone_id)) {
-									warning("Invalid zone id at %d:%d:%d", pos.x, pos.y, pos.z);
-									continue;
-								}
-								tile->addZone(zone_id);
-							}
-						} else {
-							warning("Unknown type of tile child node");
-						}
-					}
-
-					tile->update();
-					if (house) {
-						house->addTile(tile);
-					}
+		// Areas ahead of the other nodes are placed first, like they were read
+		if (node_type != OTBM_TILE_AREA) {
+			loadTileAreas(map, pending_areas);
+		}
 
-					map.setTile(pos.x, pos.y, pos.z, tile);
+		if (node_type == OTBM_TILE_AREA) {
+			const uint8_t* bytes;
+			size_t length;
+			if (mapNode->extract(bytes, length)) {
+				// The extracted bytes start at the node, reading the base coordinate doesn't move them
+				uint16_t base_x, base_y;
+				if (lazy_areas && mapNode->getU16(base_x) && mapNode->getU16(base_y)) {
+					lazy_areas->addArea(base_x, base_y, bytes, length);
 				} else {
-					warning("Unknown type of tile node");
+					pending_areas.emplace_back(bytes, length);
+					if (pending_areas.size() >= AreaBatchSize) {
+						loadTileAreas(map, pending_areas);
+					}
 				}
+			} else {
+				DecodedTileArea area;
+				decodeTileArea(map, mapNode, area);
+				mergeTileArea(map, area);
 			}
 		} else if (node_type == OTBM_TOWNS) {
 			for (BinaryNode* townNode = mapNode->getChild(); townNode != nullptr; townNode = townNode->advance()) {
@@ -972,6 +1001,7 @@ bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 			}
 		}
 	}
+	loadTileAreas(map, pending_areas);
 
 	if (!f.isOk()) {
 		warning(wxstr(f.getErrorMessage()).wc_str());
@@ -979,6 +1009,199 @@ bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 	return true;
 }
 
+void IOMapOTBM::decodeTileArea(Map &map, BinaryNode* areaNode, DecodedTileArea &area) const {
+	const auto warning = [&area](const char* format, auto... args) {
+		area.warnings.push_back(wxString::Format(format, args...));
+	};
+
+	uint16_t base_x, base_y;
+	uint8_t base_z;
+	if (!areaNode->getU16(base_x) || !areaNode->getU16(base_y) || !areaNode->getU8(base_z)) {
+		warning("Invalid map node, no base coordinate");
+		return;
+	}
+
+	for (BinaryNode* tileNode = areaNode->getChild(); tileNode != nullptr; tileNode = tileNode->advance()) {
+		uint8_t tile_type;
+		if (!tileNode->getByte(tile_type)) {
+			warning("Invalid tile type");
+			continue;
+		}
+		if (tile_type != OTBM_TILE && tile_type != OTBM_HOUSETILE) {
+			warning("Unknown type of tile node");
+			continue;
+		}
+
+		uint8_t x_offset, y_offset;
+		if (!tileNode->getU8(x_offset) || !tileNode->getU8(y_offset)) {
+			warning("Could not read position of tile");
+			continue;
+		}
+
+		DecodedTileArea::DecodedTile &decoded = area.tiles.emplace_back();
+		decoded.position = Position(base_x + x_offset, base_y + y_offset, base_z);
+		decoded.tile = nullptr;
+		decoded.house_id = 0;
+		decoded.first_warning = area.warnings.size();
+
+		const Position &pos = decoded.position;
+		if (tile_type == OTBM_HOUSETILE) {
+			uint32_t house_id;
+			if (!tileNode->getU32(house_id)) {
+				warning("House tile without house data, discarding tile");
+				decoded.warnings_end = area.warnings.size();
+				continue;
+			}
+			if (house_id) {
+				decoded.house_id = house_id;
+			} else {
+				warning("Invalid house id from tile %d:%d:%d", pos.x, pos.y, pos.z);
+			}
+		}
+
+		Tile* tile = map.allocator.allocateTile();
+		uint8_t attribute;
+		while (tileNode->getU8(attribute)) {
+			switch (attribute) {
+				case OTBM_ATTR_TILE_FLAGS: {
+					uint32_t flags = 0;
+					if (!tileNode->getU32(flags)) {
+						warning("Invalid tile flags of tile on %d:%d:%d", pos.x, pos.y, pos.z);
+					}
+					tile->setMapFlags(flags);
+					break;
+				}
+				case OTBM_ATTR_ITEM: {
+					Item* item = Item::Create_OTBM(*this, tileNode);
+					if (item == nullptr) {
+						warning("Invalid item at tile %d:%d:%d", pos.x, pos.y, pos.z);
+					}
+					tile->addItem(item);
+					break;
+				}
+				default: {
+					warning("Unknown tile attribute at %d:%d:%d", pos.x, pos.y, pos.z);
+					break;
+				}
+			}
+		}
+
+		for (BinaryNode* childNode = tileNode->getChild(); childNode != nullptr; childNode = childNode->advance()) {
+			Item* item = nullptr;
+			uint8_t node_type;
+			if (!childNode->getByte(node_type)) {
+				warning("Unknown item type %d:%d:%d", pos.x, pos.y, pos.z);
+				continue;
+			}
+			if (node_type == OTBM_ITEM) {
+				item = Item::Create_OTBM(*this, childNode);
+				if (item) {
+					if (!item->unserializeItemNode_OTBM(*this, childNode)) {
+						warning("Couldn't unserialize item attributes at %d:%d:%d", pos.x, pos.y, pos.z);
+					}
+					tile->addItem(item);
+				}
+			} else if (node_type == OTBM_TILE_ZONE) {
+				uint16_t zone_count;
+				if (!childNode->getU16(zone_count)) {
+					warning("Invalid zone count at %d:%d:%d", pos.x, pos.y, pos.z);
+					continue;
+				}
+				for (uint16_t i = 0; i < zone_count; ++i) {
+					uint16_t zone_id;
+					if (!childNode->getU16(zone_id)) {
+						warning("Invalid zone id at %d:%d:%d", pos.x, pos.y, pos.z);
+						continue;
+					}
+					tile->addZone(zone_id);
+				}
+			} else {
+				warning("Unknown type of tile child node");
+			}
+		}
+
+		// addItem kept the flags up to date, the plain items go into records now that
+		// nothing holds on to them yet
+		tile->items.compact();
+		ASSERT(tile->hasConsistentState());
+		decoded.tile = tile;
+		decoded.warnings_end = area.warnings.size();
+	}
+}
+
+void IOMapOTBM::mergeTileArea(Map &map, DecodedTileArea &area) {
+	size_t next_warning = 0;
+	const auto flushWarnings = [&](size_t end) {
+		for (; next_warning < end; ++next_warning) {
+			warnings.push_back(area.warnings[next_warning]);
+		}
+	};
+
+	// The tiles come area by area, the id registry sorts what they add once at the end
+	map.item_ids.beginBatch();
+	for (DecodedTileArea::DecodedTile &decoded : area.tiles) {
+		const Position &pos = decoded.position;
+		flushWarnings(decoded.first_warning);
+		if (map.getTile(pos)) {
+			// The sequential reader skipped the duplicate before reading anything else of it
+			warning("Duplicate tile at %d:%d:%d, discarding duplicate", pos.x, pos.y, pos.z);
+			delete decoded.tile;
+			next_warning = decoded.warnings_end;
+			continue;
+		}
+
+		House* house = nullptr;
+		if (decoded.house_id) {
+			house = map.houses.getHouse(decoded.house_id);
+			if (!house) {
+				house = newd House(map);
+				house->id = decoded.house_id;
+				map.houses.addHouse(house);
+			}
+		}
+		flushWarnings(decoded.warnings_end);
+
+		Tile* tile = decoded.tile;
+		if (!tile) {
+			continue;
+		}
+
+		tile->setLocation(map.createTileL(pos));
+		if (house) {
+			house->addTile(tile);
+		}
+		map.setTile(pos.x, pos.y, pos.z, tile);
+	}
+	map.item_ids.endBatch();
+	flushWarnings(area.warnings.size());
+	area.tiles.clear();
+}
+
+void IOMapOTBM::loadTileAreas(Map &map, std::vector<std::pair<const uint8_t*, size_t>> &areas) {
+	if (areas.empty()) {
+		return;
+	}
+
+	std::vector<DecodedTileArea> decoded(areas.size());
+	g_workers.run(areas.size(), [&](size_t index, size_t) {
+		// The mapping outlives the reader, so the nodes point straight into it
+		MemoryNodeFileReadHandle handle(areas[index].first, areas[index].second, true);
+		BinaryNode* areaNode = handle.getRootNode();
+		if (areaNode) {
+			areaNode->skip(1); // The type byte was read before extracting
+			decodeTileArea(map, areaNode, decoded[index]);
+		}
+	});
+
+	// One batch of the id registry for all of them
+	map.item_ids.beginBatch();
+	for (DecodedTileArea &area : decoded) {
+		mergeTileArea(map, area);
+	}
+	map.item_ids.endBatch();
+	areas.clear();
+}
+
 bool IOMapOTBM::loadSpawnsMonster(Map &map, const FileName &dir) {
 	std::string fn = (const char*)(dir.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME).mb_str(wxConvUTF8));
 	fn += map.spawnmonsterfile;
@@ -1113,7 +1336,7 @@ bool IOMapOTBM::loadSpawnsMonster(Map &map, pugi::xml_document &doc) {
 			monster->setSpawnMonsterTime(spawntime);
 			monsterTile->monster = monster;
 
-			if (monsterTile->getLocation()->getSpawnMonsterCount() == 0) {
+			if (!map.spawnsMonster.isCovered(monsterTile->getPosition())) {
 				// No monster spawn, create a newd one
 				ASSERT(monsterTile->spawnMonster == nullptr);
 				SpawnMonster* spawnMonster = newd SpawnMonster(1);
@@ -1378,7 +1601,7 @@ bool IOMapOTBM::loadSpawnsNpc(Map &map, pugi::xml_document &doc) {
 			npc->setSpawnNpcTime(spawntime);
 			npcTile->npc = npc;
 
-			if (npcTile->getLocation()->getSpawnNpcCount() == 0) {
+			if (!map.spawnsNpc.isCovered(npcTile->getPosition())) {
 				// No npc spawn, create a newd one
 				ASSERT(npcTile->spawnNpc == nullptr);
 				SpawnNpc* spawnNpc = newd SpawnNpc(1);
@@ -1391,6 +1614,9 @@ bool IOMapOTBM::loadSpawnsNpc(Map &map, pugi::xml_document &doc) {
 }
 
 bool IOMapOTBM::saveMap(Map &map, const FileName &identifier) {
+	// Tiles still waiting in the opened file are written like the others
+	map.loadAllPendingTiles();
+
 #if OTGZ_SUPPORT > 0
 	if (identifier.GetExt() == "otgz") {
 		// Create the archive
@@ -1546,8 +1772,6 @@ bool IOMapOTBM::saveMap(Map &map, NodeFileWriteHandle &f) {
 	 * format.
 	 */
 
-	const IOMapOTBM &self = *this;
-
 	FileName tmpName;
 	MapVersion mapVersion = map.getVersion();
 
@@ -1586,107 +1810,7 @@ bool IOMapOTBM::saveMap(Map &map, NodeFileWriteHandle &f) {
 			f.addU8(OTBM_ATTR_EXT_ZONE_FILE);
 			f.addString(nstr(tmpName.GetFullName()));
 
-			// Start writing tiles
-			uint32_t tiles_saved = 0;
-			bool first = true;
-
-			int local_x = -1, local_y = -1, local_z = -1;
-
-			MapIterator map_iterator = map.begin();
-			while (map_iterator != map.end()) {
-				// Update progressbar
-				++tiles_saved;
-				if (tiles_saved % 8192 == 0) {
-					g_gui.SetLoadDone(int(tiles_saved / double(map.getTileCount()) * 100.0));
-				}
-
-				// Get tile
-				Tile* save_tile = (*map_iterator)->get();
-
-				// Is it an empty tile that we can skip? (Leftovers...)
-				if (!save_tile || save_tile->size() == 0) {
-					++map_iterator;
-					continue;
-				}
-
-				const Position &pos = save_tile->getPosition();
-
-				// Decide if newd node should be created
-				if (pos.x < local_x || pos.x >= local_x + 256 || pos.y < local_y || pos.y >= local_y + 256 || pos.z != local_z) {
-					// End last node
-					if (!first) {
-						f.endNode();
-					}
-					first = false;
-
-					// Start newd node
-					f.addNode(OTBM_TILE_AREA);
-					f.addU16(local_x = pos.x & 0xFF00);
-					f.addU16(local_y = pos.y & 0xFF00);
-					f.addU8(local_z = pos.z);
-				}
-				f.addNode(save_tile->isHouseTile() ? OTBM_HOUSETILE : OTBM_TILE);
-
-				f.addU8(save_tile->getX() & 0xFF);
-				f.addU8(save_tile->getY() & 0xFF);
-
-				if (save_tile->isHouseTile()) {
-					f.addU32(save_tile->getHouseID());
-				}
-
-				if (save_tile->getMapFlags()) {
-					f.addByte(OTBM_ATTR_TILE_FLAGS);
-					f.addU32(save_tile->getMapFlags());
-				}
-
-				if (save_tile->ground) {
-					Item* ground = save_tile->ground;
-					if (ground->isMetaItem()) {
-						// Do nothing, we don't save metaitems...
-					} else if (ground->hasBorderEquivalent()) {
-						bool found = false;
-						for (Item* item : save_tile->items) {
-							if (item->getGroundEquivalent() == ground->getID()) {
-								// Do nothing
-								// Found equivalent
-								found = true;
-								break;
-							}
-						}
-
-						if (!found) {
-							ground->serializeItemNode_OTBM(self, f);
-						}
-					} else if (ground->isComplex()) {
-						ground->serializeItemNode_OTBM(self, f);
-					} else {
-						f.addByte(OTBM_ATTR_ITEM);
-						ground->serializeItemCompact_OTBM(self, f);
-					}
-				}
-
-				for (Item* item : save_tile->items) {
-					if (!item->isMetaItem()) {
-						item->serializeItemNode_OTBM(self, f);
-					}
-				}
-				if (!save_tile->zones.empty()) {
-					f.addNode(OTBM_TILE_ZONE);
-					f.addU16(save_tile->zones.size());
-					for (const auto &zoneId : save_tile->zones) {
-						f.addU16(zoneId);
-					}
-					f.endNode();
-				}
-
-				f.endNode();
-				++map_iterator;
-			}
-
-			// Only close the last node if one has actually been created
-			if (!first) {
-				f.endNode();
-			}
+			saveTiles(map, f);
 
 			f.addNode(OTBM_TOWNS);
 			for (const auto &townEntry : map.towns) {
@@ -1722,6 +1846,200 @@ bool IOMapOTBM::saveMap(Map &map, NodeFileWriteHandle &f) {
 	return true;
 }
 
+void IOMapOTBM::saveTiles(Map &map, NodeFileWriteHandle &f) {
+	// Tiles are grouped by area (a 256x256 block on one floor) so that every area gets one node.
+	// In MapIterator order the floors of a block take turns leaf by leaf, and the same area
+	// is opened again for every run of tiles. The blocks are split in ranges written to their
+	// own buffer on the workers, each block sorted by floor in one pass. A finished range goes to the
+	// file as soon as those before it did, and only a few ranges are buffered ahead of that.
+	struct BlockRange {
+		std::unique_ptr<MemoryNodeFileWriteHandle> buffer;
+		bool finished = false;
+		size_t area_nodes = 0;
+		size_t iterator_area_nodes = 0; // The same tiles in MapIterator order
+		size_t area_bytes_saved = 0;
+	};
+
+	const std::vector<QTreeNode*> blocks = MapTraversal::getNodes(map, 256);
+	// A few ranges per worker, so one dense range doesn't leave the others idle
+	const size_t range_count = std::min(blocks.size(), g_workers.getThreadCount() * 16);
+	const size_t buffered_ranges = g_workers.getThreadCount() * 2;
+	std::vector<BlockRange> ranges(range_count);
+	std::atomic<uint64_t> tiles_saved(0);
+
+	// Guards f, the finished flags and the next range to append
+	std::mutex write_lock;
+	std::condition_variable appended;
+	size_t next_range = 0;
+	bool failed = false;
+
+	area_nodes = 0;
+	iterator_area_nodes = 0;
+	area_bytes_saved = 0;
+
+	g_workers.run(
+		range_count, [&](size_t index, size_t) {
+			{
+				// Ranges are handed out in order, so the one to append next is never waiting here
+				std::unique_lock<std::mutex> guard(write_lock);
+				appended.wait(guard, [&]() { return failed || index < next_range + buffered_ranges; });
+				if (failed) {
+					return;
+				}
+			}
+
+			BlockRange &range = ranges[index];
+			range.buffer = std::make_unique<MemoryNodeFileWriteHandle>();
+			MemoryNodeFileWriteHandle &buffer = *range.buffer;
+			const size_t first = blocks.size() * index / range_count;
+			const size_t last = blocks.size() * (index + 1) / range_count;
+			// Reused from block to block
+			std::vector<Tile*> floors[rme::MapLayers];
+			size_t iterator_floor_nodes[rme::MapLayers] = {};
+			try {
+				for (size_t block = first; block != last; ++block) {
+					// MapIterator order opens another area whenever the floor changes
+					int last_z = -1;
+					auto collect = [&](Tile* tile) {
+						// Is it an empty tile that we can skip? (Leftovers...)
+						if (tile->size() != 0) {
+							floors[tile->getZ()].push_back(tile);
+							if (tile->getZ() != last_z) {
+								last_z = tile->getZ();
+								iterator_floor_nodes[last_z]++;
+							}
+						}
+					};
+					tiles_saved += MapTraversal::visitSubtree(blocks[block], collect);
+
+					for (int z = 0; z < rme::MapLayers; ++z) {
+						if (floors[z].empty()) {
+							continue;
+						}
+						const Position &pos = floors[z].front()->getPosition();
+						const Position area(pos.x & 0xFF00, pos.y & 0xFF00, z);
+						buffer.addNode(OTBM_TILE_AREA);
+						buffer.addU16(area.x);
+						buffer.addU16(area.y);
+						buffer.addU8(area.z);
+						for (Tile* tile : floors[z]) {
+							saveTile(tile, buffer);
+						}
+						buffer.endNode();
+						range.area_nodes++;
+						// The tile nodes are the same either way, the other areas only add their headers
+						range.iterator_area_nodes += iterator_floor_nodes[z];
+						range.area_bytes_saved += (iterator_floor_nodes[z] - 1) * getAreaNodeSize(area);
+						iterator_floor_nodes[z] = 0;
+						floors[z].clear();
+					}
+					// Warms the hash tree, so hashing the saved state afterwards only combines the blocks
+					blocks[block]->getContentHash();
+				}
+			} catch (...) {
+				// The ranges waiting for this one would wait forever
+				std::lock_guard<std::mutex> guard(write_lock);
+				failed = true;
+				appended.notify_all();
+				throw;
+			}
+
+			// Whoever finishes the range next in line appends it and the finished ones after it
+			std::lock_guard<std::mutex> guard(write_lock);
+			range.finished = true;
+			for (; next_range != range_count && ranges[next_range].finished; ++next_range) {
+				BlockRange &done = ranges[next_range];
+				f.addEncoded(done.buffer->getMemory(), done.buffer->getSize());
+				done.buffer.reset();
+				area_nodes += done.area_nodes;
+				iterator_area_nodes += done.iterator_area_nodes;
+				area_bytes_saved += done.area_bytes_saved;
+			}
+			appended.notify_all();
+		},
+		[&]() {
+			g_gui.SetLoadDone(int(tiles_saved.load() / double(map.getTileCount()) * 100.0));
+		}
+	);
+}
+
+size_t IOMapOTBM::getAreaNodeSize(const Position &area) {
+	// Node start, type, coordinates and node end, and an escape for every coordinate byte
+	// that reads like a control byte
+	const uint8_t coordinates[] = {
+		uint8_t(area.x & 0xFF), uint8_t(area.x >> 8),
+		uint8_t(area.y & 0xFF), uint8_t(area.y >> 8),
+		uint8_t(area.z)
+	};
+	size_t size = 3 + sizeof(coordinates);
+	for (uint8_t byte : coordinates) {
+		if (byte == NODE_START || byte == NODE_END || byte == ESCAPE_CHAR) {
+			++size;
+		}
+	}
+	return size;
+}
+
+void IOMapOTBM::saveTile(Tile* tile, NodeFileWriteHandle &f) const {
+	const IOMapOTBM &self = *this;
+
+	f.addNode(tile->isHouseTile() ? OTBM_HOUSETILE : OTBM_TILE);
+
+	f.addU8(tile->getX() & 0xFF);
+	f.addU8(tile->getY() & 0xFF);
+
+	if (tile->isHouseTile()) {
+		f.addU32(tile->getHouseID());
+	}
+
+	if (tile->getMapFlags()) {
+		f.addByte(OTBM_ATTR_TILE_FLAGS);
+		f.addU32(tile->getMapFlags());
+	}
+
+	if (tile->ground) {
+		Item* ground = tile->ground;
+		if (ground->isMetaItem()) {
+			// Do nothing, we don't save metaitems...
+		} else if (ground->hasBorderEquivalent()) {
+			bool found = false;
+			for (size_t index = 0; index < tile->items.size(); ++index) {
+				if (g_items[tile->items.getID(index)].ground_equivalent == ground->getID()) {
+					// Do nothing
+					// Found equivalent
+					found = true;
+					break;
+				}
+			}
+
+			if (!found) {
+				ground->serializeItemNode_OTBM(self, f);
+			}
+		} else if (ground->isComplex()) {
+			ground->serializeItemNode_OTBM(self, f);
+		} else {
+			f.addByte(OTBM_ATTR_ITEM);
+			ground->serializeItemCompact_OTBM(self, f);
+		}
+	}
+
+	tile->items.forEach([&](const Item &item) {
+		if (!item.isMetaItem()) {
+			item.serializeItemNode_OTBM(self, f);
+		}
+	});
+	if (!tile->zones.empty()) {
+		f.addNode(OTBM_TILE_ZONE);
+		f.addU16(tile->zones.size());
+		for (const auto &zoneId : tile->zones) {
+			f.addU16(zoneId);
+		}
+		f.endNode();
+	}
+
+	f.endNode();
+}
+
 bool IOMapOTBM::saveSpawns(Map &map, const FileName &dir) {
 	wxString filepath = dir.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME);
 	filepath += wxString(map.spawnmonsterfile.c_str(), wxConvUTF8);
@@ -1762,33 +2080,32 @@ bool IOMapOTBM::saveSpawns(Map &map, pugi::xml_document &doc) {
 		int32_t radius = spawnMonster->getSize();
 		spawnNode.append_attribute("radius") = radius;
 
-		for (int32_t y = -radius; y <= radius; ++y) {
-			for (int32_t x = -radius; x <= radius; ++x) {
-				Tile* monster_tile = map.getTile(spawnPosition + Position(x, y, 0));
-				if (monster_tile) {
-					Monster* monster = monster_tile->monster;
-					if (monster && !monster->isSaved()) {
-						pugi::xml_node monsterNode = spawnNode.append_child("monster");
-						monsterNode.append_attribute("name") = monster->getName().c_str();
-						monsterNode.append_attribute("x") = x;
-						monsterNode.append_attribute("y") = y;
-						monsterNode.append_attribute("z") = spawnPosition.z;
-						auto monsterSpawnTime = monster->getSpawnMonsterTime();
-						if (monsterSpawnTime > std::numeric_limits<uint32_t>::max() || monsterSpawnTime < std::numeric_limits<uint32_t>::min()) {
-							monsterSpawnTime = 60;
-						}
-
-						monsterNode.append_attribute("spawntime") = monsterSpawnTime;
-						if (monster->getDirection() != NORTH) {
-							monsterNode.append_attribute("direction") = monster->getDirection();
-						}
+		for (Tile* monster_tile : map.getSpawnMonsterCreatures(spawnPosition)) {
+			Monster* monster = monster_tile->monster;
+			if (monster->isSaved()) {
+				continue;
+			}
+			int32_t x = monster_tile->getX() - spawnPosition.x;
+			int32_t y = monster_tile->getY() - spawnPosition.y;
+
+			pugi::xml_node monsterNode = spawnNode.append_child("monster");
+			monsterNode.append_attribute("name") = monster->getName().c_str();
+			monsterNode.append_attribute("x") = x;
+			monsterNode.append_attribute("y") = y;
+			monsterNode.append_attribute("z") = spawnPosition.z;
+			auto monsterSpawnTime = monster->getSpawnMonsterTime();
+			if (monsterSpawnTime > std::numeric_limits<uint32_t>::max() || monsterSpawnTime < std::numeric_limits<uint32_t>::min()) {
+				monsterSpawnTime = 60;
+			}
 
-						// Mark as saved
-						monster->save();
-						monsterList.push_back(monster);
-					}
-				}
+			monsterNode.append_attribute("spawntime") = monsterSpawnTime;
+			if (monster->getDirection() != NORTH) {
+				monsterNode.append_attribute("direction") = monster->getDirection();
 			}
+
+			// Mark as saved
+			monster->save();
+			monsterList.push_back(monster);
 		}
 	}
 
@@ -1917,28 +2234,27 @@ bool IOMapOTBM::saveSpawnsNpc(Map &map, pugi::xml_document &doc) {
 		int32_t radius = spawnNpc->getSize();
 		spawnNpcNode.append_attribute("radius") = radius;
 
-		for (int32_t y = -radius; y <= radius; ++y) {
-			for (int32_t x = -radius; x <= radius; ++x) {
-				Tile* npcTile = map.getTile(spawnPosition + Position(x, y, 0));
-				if (npcTile) {
-					Npc* npc = npcTile->npc;
-					if (npc && !npc->isSaved()) {
-						pugi::xml_node npcNode = spawnNpcNode.append_child("npc");
-						npcNode.append_attribute("name") = npc->getName().c_str();
-						npcNode.append_attribute("x") = x;
-						npcNode.append_attribute("y") = y;
-						npcNode.append_attribute("z") = spawnPosition.z;
-						npcNode.append_attribute("spawntime") = npc->getSpawnNpcTime();
-						if (npc->getDirection() != NORTH) {
-							npcNode.append_attribute("direction") = npc->getDirection();
-						}
-
-						// Mark as saved
-						npc->save();
-						npcList.push_back(npc);
-					}
-				}
+		for (Tile* npcTile : map.getSpawnNpcCreatures(spawnPosition)) {
+			Npc* npc = npcTile->npc;
+			if (npc->isSaved()) {
+				continue;
+			}
+			int32_t x = npcTile->getX() - spawnPosition.x;
+			int32_t y = npcTile->getY() - spawnPosition.y;
+
+			pugi::xml_node npcNode = spawnNpcNode.append_child("npc");
+			npcNode.append_attribute("name") = npc->getName().c_str();
+			npcNode.append_attribute("x") = x;
+			npcNode.append_attribute("y") = y;
+			npcNode.append_attribute("z") = spawnPosition.z;
+			npcNode.append_attribute("spawntime") = npc->getSpawnNpcTime();
+			if (npc->getDirection() != NORTH) {
+				npcNode.append_attribute("direction") = npc->getDirection();
 			}
+
+			// Mark as saved
+			npc->save();
+			npcList.push_back(npc);
 		}
 	}
 
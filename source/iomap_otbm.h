@@ -125,10 +125,43 @@ public:
 	virtual bool loadMap(Map &map, const FileName &identifier);
 	virtual bool saveMap(Map &map, const FileName &identifier);
 
+	// Tile area nodes written by the last save, and how many the same tiles took in MapIterator order
+	size_t getAreaNodeCount() const noexcept {
+		return area_nodes;
+	}
+	size_t getIteratorAreaNodeCount() const noexcept {
+		return iterator_area_nodes;
+	}
+	// Bytes of area node headers that order would have written on top
+	size_t getAreaBytesSaved() const noexcept {
+		return area_bytes_saved;
+	}
+
 protected:
+	size_t area_nodes = 0;
+	size_t iterator_area_nodes = 0;
+	size_t area_bytes_saved = 0;
+
 	static bool getVersionInfo(NodeFileReadHandle* f, MapVersion &out_ver);
 
 	virtual bool loadMap(Map &map, NodeFileReadHandle &handle);
+	// Tile areas are read in two steps: decoding builds the tiles without touching the map,
+	// so the areas of a mapped file can be decoded on the workers, and merging then places
+	// them in file order. Both paths give the same map and warnings.
+	struct DecodedTileArea;
+	// Areas handed to the workers in one go, each holds at most 256 tiles
+	static constexpr size_t AreaBatchSize = 1024;
+	void decodeTileArea(Map &map, BinaryNode* areaNode, DecodedTileArea &area) const;
+	void mergeTileArea(Map &map, DecodedTileArea &area);
+	void loadTileAreas(Map &map, std::vector<std::pair<const uint8_t*, size_t>> &areas);
+	// Maps past the lazy load size open with their tile areas only indexed, the map
+	// reads them as it goes. Set while loadMap indexes the areas instead of reading them.
+	class LazyTileAreas;
+	LazyTileAreas* lazy_areas = nullptr;
+	// The auxiliary files that refer to tiles, read after the tiles. A lazy load reads the
+	// houses once all of its tiles are in, the spawns read their blocks as they go
+	void loadHouseFile(Map &map, const FileName &filename);
+	void loadSpawnFiles(Map &map, const FileName &filename);
 	bool loadSpawnsMonster(Map &map, const FileName &dir);
 	bool loadSpawnsMonster(Map &map, pugi::xml_document &doc);
 	bool loadHouses(Map &map, const FileName &dir);
@@ -139,6 +172,10 @@ protected:
 	bool loadZones(Map &map, pugi::xml_document &doc);
 
 	virtual bool saveMap(Map &map, NodeFileWriteHandle &handle);
+	void saveTiles(Map &map, NodeFileWriteHandle &f);
+	// Bytes of an area node besides its tiles
+	static size_t getAreaNodeSize(const Position &area);
+	void saveTile(Tile* tile, NodeFileWriteHandle &f) const;
 	bool saveSpawns(Map &map, const FileName &dir);
 	bool saveSpawns(Map &map, pugi::xml_document &doc);
 	bool saveHouses(Map &map, const FileName &dir);
@@ -488,7 +488,8 @@ bool IOMapOTMM::loadMap(Map &map, NodeFileReadHandle &f, const FileName &identif
 								} while (itemNode->advance());
 							}
 
-							tile->update();
+							// addItem kept the flags up to date
+							ASSERT(tile->hasConsistentState());
 							if (house) {
 								house->addTile(tile);
 							}
@@ -952,7 +953,7 @@ bool IOMapOTMM::saveMap(Map &map, NodeFileWriteHandle &f, const FileName &identi
 								f.addU16(0);
 							} else if (ground->hasBorderEquivalent()) {
 								bool found = false;
-								for (ItemVector::const_iterator it = save_tile->items.begin(); it != save_tile->items.end(); ++it) {
+								for (TileItems::const_iterator it = save_tile->items.begin(); it != save_tile->items.end(); ++it) {
 									if ((*it)->getGroundEquivalent() == ground->getID()) {
 										// Do nothing
 										// Found equivalent
@@ -975,7 +976,7 @@ bool IOMapOTMM::saveMap(Map &map, NodeFileWriteHandle &f, const FileName &identi
 							f.addU16(0);
 						}
 
-						for (ItemVector::const_iterator it = save_tile->items.begin(); it != save_tile->items.end(); ++it) {
+						for (TileItems::const_iterator it = save_tile->items.begin(); it != save_tile->items.end(); ++it) {
 							if (!(*it)->isMetaItem()) {
 								(*it)->serializeItemNode_OTMM(*this, f);
 							}
@@ -21,15 +21,19 @@
 #include "graphics.h"
 #include "gui.h"
 #include "tile.h"
+#include "map_allocator.h"
 #include "complexitem.h"
 #include "iomap.h"
 #include "item.h"
+#include "content_hash.h"
 
 #include "ground_brush.h"
 #include "carpet_brush.h"
 #include "table_brush.h"
 #include "wall_brush.h"
 
+#include <typeinfo>
+
 Item* Item::Create(uint16_t id, uint16_t subtype /*= 0xFFFF*/) {
 	if (id == 0) {
 		return nullptr;
@@ -37,7 +41,7 @@ Item* Item::Create(uint16_t id, uint16_t subtype /*= 0xFFFF*/) {
 
 	const ItemType &type = g_items.getItemType(id);
 	if (type.id == 0) {
-		return newd Item(id, subtype);
+		return new Item(id, subtype);
 	}
 
 	if (type.isDepot()) {
@@ -66,49 +70,143 @@ Item::Item(unsigned short _type, unsigned short _count) :
 	id(_type),
 	subtype(1),
 	selected(false),
-	frame(0) {
+	frame(0),
+	references(0) {
 	if (hasSubtype()) {
 		subtype = _count;
 	}
 }
 
+Item::Item(uint16_t id, uint16_t subtype, bool selected) noexcept :
+	id(id),
+	subtype(subtype),
+	selected(selected),
+	frame(0),
+	references(0) {
+	////
+}
+
 Item::~Item() {
 	////
 }
 
+namespace {
+	// One pool per 16 byte size class, large enough for every Item subclass
+	constexpr size_t ItemSizeClass = 16;
+	constexpr size_t ItemSizeClasses = 8;
+
+	struct ItemPools {
+		ItemPools() {
+			for (size_t i = 0; i < ItemSizeClasses; ++i) {
+				pools[i] = newd SlabPool((i + 1) * ItemSizeClass);
+			}
+		}
+		SlabPool* pools[ItemSizeClasses];
+	};
+
+	ItemPools &getItemPools() {
+		// Lives as long as the process, items can outlive any single map
+		static ItemPools itemPools;
+		return itemPools;
+	}
+}
+
+void* Item::operator new(size_t size) {
+	const size_t index = (size - 1) / ItemSizeClass;
+	if (index >= ItemSizeClasses) {
+		// A subclass outgrew the largest size class, serve it from the heap
+		return ::operator new(size);
+	}
+	return getItemPools().pools[index]->allocate();
+}
+
+void Item::operator delete(void* block, size_t size) {
+	if (!block) {
+		return;
+	}
+	// The destructor is virtual, so size is the one of the most derived type
+	if ((size - 1) / ItemSizeClass >= ItemSizeClasses) {
+		::operator delete(block);
+		return;
+	}
+	SlabPool::getOwner(block)->deallocate(block);
+}
+
+size_t Item::getLiveCount() {
+	size_t count = 0;
+	for (const SlabPool* pool : getItemPools().pools) {
+		count += pool->getLiveCount();
+	}
+	return count;
+}
+
+size_t Item::getUsedBytes() {
+	size_t bytes = 0;
+	for (const SlabPool* pool : getItemPools().pools) {
+		bytes += pool->getLiveCount() * pool->getObjectSize();
+	}
+	return bytes;
+}
+
+size_t Item::getReservedBytes() {
+	size_t bytes = 0;
+	for (const SlabPool* pool : getItemPools().pools) {
+		bytes += pool->getReservedBytes();
+	}
+	return bytes;
+}
+
 Item* Item::deepCopy() const {
 	Item* copy = Create(id, subtype);
 	if (copy) {
 		copy->selected = selected;
-		if (attributes) {
-			copy->attributes = newd ItemAttributeMap(*attributes);
-		}
+		// The attributes stay shared until one of the two items changes them
+		copy->shareAttributes(*this);
 	}
 	return copy;
 }
 
+bool Item::isCompactable() const {
+	// Subclasses carry more than an id and a subtype
+	return typeid(*this) == typeid(Item) && !isComplex();
+}
+
+void Item::hashContent(ContentHash &hash) const {
+	hash.add(id);
+	hash.add(getSubtype());
+	hashAttributes(hash);
+}
+
 Item* transformItem(Item* old_item, uint16_t new_id, Tile* parent) {
 	if (old_item == nullptr) {
 		return nullptr;
 	}
 
+	const uint16_t old_id = old_item->getID();
 	old_item->setID(new_id);
 	// Through the magic of deepCopy, this will now be a pointer to an item of the correct type.
 	Item* new_item = old_item->deepCopy();
 	if (parent) {
 		// Find the old item and remove it from the tile, insert this one instead!
+		// The tile takes an item out by what it was when it was added
 		if (old_item == parent->ground) {
-			delete old_item;
-			parent->ground = new_item;
+			old_item->setID(old_id);
+			parent->setGround(new_item);
 			return new_item;
 		}
 
 		std::queue<Container*> containers;
-		for (ItemVector::iterator item_iter = parent->items.begin(); item_iter != parent->items.end(); ++item_iter) {
+		for (TileItems::iterator item_iter = parent->items.begin(); item_iter != parent->items.end(); ++item_iter) {
+			// The old item was handed out as one of the tile's own, records are never containers
+			// and shared items are only looked into when they are
+			const size_t index = item_iter.getIndex();
+			if (parent->items.isRecord(index) || (parent->items.isShared(index) && !parent->items.visit(index, [](const Item &item) { return dynamic_cast<const Container*>(&item) != nullptr; }))) {
+				continue;
+			}
 			if (*item_iter == old_item) {
-				delete old_item;
-				item_iter = parent->items.erase(item_iter);
-				parent->items.insert(item_iter, new_item);
+				old_item->setID(old_id);
+				item_iter = parent->destroyItem(item_iter);
+				parent->insertItem(item_iter, new_item);
 				return new_item;
 			}
 
@@ -238,11 +336,7 @@ uint16_t Item::getGroundSpeed() const {
 }
 
 bool Item::hasLight() const {
-	const ItemType &type = g_items.getItemType(id);
-	if (type.sprite) {
-		return type.sprite->hasLight();
-	}
-	return false;
+	return g_items.hasFlag(id, ITEMTYPE_HAS_LIGHT);
 }
 
 SpriteLight Item::getLight() const {
@@ -262,19 +356,19 @@ double Item::getWeight() const {
 }
 
 void Item::setUniqueID(unsigned short n) {
-	setAttribute("uid", n);
+	setAttribute(ItemAttributeKeys::UniqueId, ItemAttribute(static_cast<int32_t>(n)));
 }
 
 void Item::setActionID(unsigned short n) {
-	setAttribute("aid", n);
+	setAttribute(ItemAttributeKeys::ActionId, ItemAttribute(static_cast<int32_t>(n)));
 }
 
 void Item::setText(const std::string &str) {
-	setAttribute("text", str);
+	setAttribute(ItemAttributeKeys::Text, ItemAttribute(str));
 }
 
 void Item::setDescription(const std::string &str) {
-	setAttribute("desc", str);
+	setAttribute(ItemAttributeKeys::Description, ItemAttribute(str));
 }
 
 double Item::getWeight() {
@@ -294,11 +388,7 @@ bool Item::canHoldDescription() const {
 }
 
 uint8_t Item::getMiniMapColor() const {
-	GameSprite* sprite = g_items.getItemType(id).sprite;
-	if (sprite) {
-		return sprite->getMiniMapColor();
-	}
-	return 0;
+	return g_items.getMiniMapColor(id);
 }
 
 GroundBrush* Item::getGroundBrush() const {
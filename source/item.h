@@ -22,6 +22,7 @@
 #include "iomap_otbm.h"
 // #include "iomap_otmm.h"
 #include "item_attributes.h"
+#include "small_vector.h"
 
 enum ITEMPROPERTY {
 	BLOCKSOLID,
@@ -90,8 +91,19 @@ protected:
 public:
 	virtual ~Item();
 
+	// Items are carved out of size-class slab pools instead of the heap,
+	// each one is still a full polymorphic object owned through an Item*
+	static void* operator new(size_t size);
+	static void operator delete(void* block, size_t size);
+	// Allocation counters over all the item pools
+	static size_t getLiveCount();
+	static size_t getUsedBytes();
+	static size_t getReservedBytes();
+
 	// Deep copy thingy
 	virtual Item* deepCopy() const;
+	// Adds everything the map saves of this item to hash
+	virtual void hashContent(ContentHash &hash) const;
 
 	// Get memory footprint size
 	uint32_t memsize() const;
@@ -223,13 +235,13 @@ public:
 	// Item types
 	bool hasProperty(enum ITEMPROPERTY prop) const;
 	bool isAvoidable() const {
-		return getItemType().blockPathfinder;
+		return g_items.hasFlag(id, ITEMTYPE_BLOCK_PATHFINDER);
 	}
 	bool isBlocking() const {
-		return getItemType().unpassable;
+		return g_items.hasFlag(id, ITEMTYPE_UNPASSABLE);
 	}
 	bool isStackable() const {
-		return getItemType().stackable;
+		return g_items.hasFlag(id, ITEMTYPE_STACKABLE);
 	}
 	bool isClientCharged() const {
 		return getItemType().isClientCharged();
@@ -241,36 +253,36 @@ public:
 		return isClientCharged() || isExtraCharged();
 	}
 	bool isFluidContainer() const {
-		return (getItemType().isFluidContainer());
+		return g_items.hasFlag(id, ITEMTYPE_FLUID_CONTAINER);
 	}
 	bool isAlwaysOnBottom() const {
-		return getItemType().alwaysOnBottom;
+		return g_items.hasFlag(id, ITEMTYPE_ALWAYS_ON_BOTTOM);
 	}
 	int getTopOrder() const {
-		return getItemType().alwaysOnTopOrder;
+		return g_items.getTopOrder(id);
 	}
 	bool isGroundTile() const {
-		return getItemType().isGroundTile();
+		return g_items.hasFlag(id, ITEMTYPE_GROUND);
 	}
 	bool isSplash() const {
-		return getItemType().isSplash();
+		return g_items.hasFlag(id, ITEMTYPE_SPLASH);
 	}
 	bool isMagicField() const {
-		return getItemType().isMagicField();
+		return g_items.hasFlag(id, ITEMTYPE_MAGIC_FIELD);
 	}
 	bool isNotMoveable() const {
-		return !getItemType().moveable;
+		return !g_items.hasFlag(id, ITEMTYPE_MOVEABLE);
 	}
 	bool isMoveable() const {
-		return getItemType().moveable;
+		return g_items.hasFlag(id, ITEMTYPE_MOVEABLE);
 	}
 	bool isPickupable() const {
-		return getItemType().pickupable;
+		return g_items.hasFlag(id, ITEMTYPE_PICKUPABLE);
 	}
 	// bool isWeapon() const { return (getItemType().weaponType != WEAPON_NONE && g_items[id].weaponType != WEAPON_AMMO); }
 	// bool isUseable() const { return getItemType().useable; }
 	bool isHangable() const {
-		return getItemType().isHangable;
+		return g_items.hasFlag(id, ITEMTYPE_HANGABLE);
 	}
 	bool isRoteable() const {
 		return getItemType().rotable && getItemType().rotateTo;
@@ -279,37 +291,37 @@ public:
 		return getItemType().charges != 0;
 	}
 	bool isBorder() const {
-		return getItemType().isBorder;
+		return g_items.hasFlag(id, ITEMTYPE_BORDER);
 	}
 	bool isOptionalBorder() const {
-		return getItemType().isOptionalBorder;
+		return g_items.hasFlag(id, ITEMTYPE_OPTIONAL_BORDER);
 	}
 	bool isWall() const {
-		return getItemType().isWall;
+		return g_items.hasFlag(id, ITEMTYPE_WALL);
 	}
 	bool isDoor() const {
-		return getItemType().isDoor();
+		return g_items.hasFlag(id, ITEMTYPE_DOOR);
 	}
 	bool isOpen() const {
-		return getItemType().isOpen;
+		return g_items.hasFlag(id, ITEMTYPE_OPEN);
 	}
 	bool isBrushDoor() const {
-		return getItemType().isBrushDoor;
+		return g_items.hasFlag(id, ITEMTYPE_BRUSH_DOOR);
 	}
 	bool isTable() const {
-		return getItemType().isTable;
+		return g_items.hasFlag(id, ITEMTYPE_TABLE);
 	}
 	bool isCarpet() const {
-		return getItemType().isCarpet;
+		return g_items.hasFlag(id, ITEMTYPE_CARPET);
 	}
 	bool isMetaItem() const {
-		return getItemType().isMetaItem();
+		return g_items.hasFlag(id, ITEMTYPE_META);
 	}
 	bool hasElevation() const {
-		return getItemType().hasElevation;
+		return g_items.hasFlag(id, ITEMTYPE_HAS_ELEVATION);
 	}
 	bool isBlockMissiles() const {
-		return getItemType().blockMissiles;
+		return g_items.hasFlag(id, ITEMTYPE_BLOCK_MISSILES);
 	}
 
 	// Wall alignment (vertical, horizontal, pole, corner)
@@ -343,6 +355,8 @@ public:
 	virtual bool isComplex() const {
 		return attributes && attributes->size();
 	} // If this item requires full save (not compact)
+	// Plain items without attributes, a tile keeps these as compact records (see TileItems)
+	bool isCompactable() const;
 
 	// Weight
 	bool hasWeight() {
@@ -384,15 +398,23 @@ protected:
 	// Subtype is either fluid type, count, subtype or charges
 	uint16_t subtype;
 	bool selected;
-	int frame;
+	uint8_t frame;
 
 private:
+	// Number of tile item lists sharing this item, 0 while it has a single owner
+	uint16_t references;
+
+	// An item rebuilt from a compact record, the subtype is taken as it was stored
+	Item(uint16_t id, uint16_t subtype, bool selected) noexcept;
+
 	Item &operator=(const Item &i); // Can't copy
 	Item(const Item &i); // Can't copy-construct
 	Item &operator==(const Item &i); // Can't compare
+
+	friend class TileItems;
 };
 
-typedef std::vector<Item*> ItemVector;
+typedef SmallVector<Item*, 3> ItemVector; // Most tiles carry no more than a few items
 typedef std::list<Item*> ItemList;
 
 Item* transformItem(Item* old_item, uint16_t new_id, Tile* parent = nullptr);
@@ -405,23 +427,15 @@ inline int Item::getCount() const {
 }
 
 inline uint16_t Item::getUniqueID() const {
-	const int32_t* a = getIntegerAttribute("uid");
-	if (a) {
-		return *a;
-	}
-	return 0;
+	return attributes ? attributes->getUniqueID() : 0;
 }
 
 inline uint16_t Item::getActionID() const {
-	const int32_t* a = getIntegerAttribute("aid");
-	if (a) {
-		return *a;
-	}
-	return 0;
+	return attributes ? attributes->getActionID() : 0;
 }
 
 inline std::string Item::getText() const {
-	const std::string* a = getStringAttribute("text");
+	const std::string* a = getStringAttribute(ItemAttributeKeys::Text);
 	if (a) {
 		return *a;
 	}
@@ -429,7 +443,7 @@ inline std::string Item::getText() const {
 }
 
 inline std::string Item::getDescription() const {
-	const std::string* a = getStringAttribute("desc");
+	const std::string* a = getStringAttribute(ItemAttributeKeys::Description);
 	if (a) {
 		return *a;
 	}
@@ -19,65 +19,373 @@
 
 #include "item_attributes.h"
 #include "filehandle.h"
+#include "content_hash.h"
+
+#include <algorithm>
+#include <bit>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+//**************** ItemAttributeKeys **********************
+
+namespace {
+	struct ItemAttributeKeySnapshot {
+		std::unordered_map<std::string_view, uint16_t> keys;
+		std::vector<const std::string*> names;
+	};
+
+	// Lookups read the current snapshot without locking, a new name copies it
+	// under the lock and publishes the copy. There are only ever a handful of
+	// names, so the old snapshots are simply kept around for readers still using them.
+	struct ItemAttributeKeyTable {
+		ItemAttributeKeyTable() {
+			auto snapshot = std::make_unique<ItemAttributeKeySnapshot>();
+			// Must match the order of the fixed keys in ItemAttributeKeys
+			for (const char* name : { "aid", "uid", "text", "desc" }) {
+				add(*snapshot, name);
+			}
+			current.store(snapshot.get(), std::memory_order_release);
+			snapshots.push_back(std::move(snapshot));
+		}
+
+		uint16_t add(ItemAttributeKeySnapshot &snapshot, const std::string &name) {
+			const std::string &stored = names.emplace_back(name);
+			uint16_t key = static_cast<uint16_t>(snapshot.names.size());
+			snapshot.keys.emplace(stored, key);
+			snapshot.names.push_back(&stored);
+			return key;
+		}
+
+		std::atomic<const ItemAttributeKeySnapshot*> current;
+		std::mutex lock;
+		// deque so names handed out by reference stay valid
+		std::deque<std::string> names;
+		std::vector<std::unique_ptr<ItemAttributeKeySnapshot>> snapshots;
+	};
+
+	ItemAttributeKeyTable &getKeyTable() {
+		static ItemAttributeKeyTable table;
+		return table;
+	}
+}
+
+uint16_t ItemAttributeKeys::intern(const std::string &name) {
+	uint16_t key = find(name);
+	if (key != Invalid) {
+		return key;
+	}
+
+	ItemAttributeKeyTable &table = getKeyTable();
+	std::lock_guard<std::mutex> guard(table.lock);
+
+	// Another thread may have added it in the meantime
+	const ItemAttributeKeySnapshot* current = table.current.load(std::memory_order_acquire);
+	auto it = current->keys.find(name);
+	if (it != current->keys.end()) {
+		return it->second;
+	}
+
+	ASSERT(current->names.size() < Invalid);
+	auto snapshot = std::make_unique<ItemAttributeKeySnapshot>(*current);
+	key = table.add(*snapshot, name);
+	table.current.store(snapshot.get(), std::memory_order_release);
+	table.snapshots.push_back(std::move(snapshot));
+	return key;
+}
+
+uint16_t ItemAttributeKeys::find(const std::string &name) {
+	const ItemAttributeKeySnapshot* current = getKeyTable().current.load(std::memory_order_acquire);
+	auto it = current->keys.find(name);
+	if (it != current->keys.end()) {
+		return it->second;
+	}
+	return Invalid;
+}
+
+const std::string &ItemAttributeKeys::getName(uint16_t key) {
+	const ItemAttributeKeySnapshot* current = getKeyTable().current.load(std::memory_order_acquire);
+	ASSERT(key < current->names.size());
+	return *current->names[key];
+}
+
+//**************** ItemAttributeList **********************
+
+ItemAttributeList::ItemAttributeList() :
+	references(1) {
+	for (uint16_t key = 0; key < ItemAttributeKeys::FixedCount; ++key) {
+		slots[key].key = key;
+		slots[key].type = ItemAttribute::NONE;
+	}
+}
+
+ItemAttributeList::ItemAttributeList(const ItemAttributeList &other) :
+	references(1),
+	entries(other.entries) {
+	std::copy(std::begin(other.slots), std::end(other.slots), slots);
+	// The copies still point at the strings of the other list
+	for (Entry &slot : slots) {
+		if (slot.type == ItemAttribute::STRING) {
+			slot.string = newd std::string(*slot.string);
+		}
+	}
+	for (Entry &entry : entries) {
+		if (entry.type == ItemAttribute::STRING) {
+			entry.string = newd std::string(*entry.string);
+		}
+	}
+}
+
+ItemAttributeList::~ItemAttributeList() {
+	for (Entry &slot : slots) {
+		clear(slot);
+	}
+	for (Entry &entry : entries) {
+		clear(entry);
+	}
+}
+
+size_t ItemAttributeList::size() const noexcept {
+	size_t count = entries.size();
+	for (const Entry &slot : slots) {
+		count += slot.type != ItemAttribute::NONE ? 1 : 0;
+	}
+	return count;
+}
+
+size_t ItemAttributeList::memsize() const noexcept {
+	size_t mem = sizeof(*this) + entries.getHeapBytes();
+	forEach([&mem](uint16_t key, const Entry &entry) {
+		if (const std::string* str = entry.getString()) {
+			mem += sizeof(std::string);
+			// Short strings are stored inline, their data points into the string itself
+			const char* data = str->data();
+			const char* self = reinterpret_cast<const char*>(str);
+			if (data < self || data >= self + sizeof(std::string)) {
+				mem += str->capacity() + 1;
+			}
+		}
+	});
+	return mem;
+}
+
+void ItemAttributeList::clear(Entry &entry) noexcept {
+	if (entry.type == ItemAttribute::STRING) {
+		delete entry.string;
+	}
+	entry.type = ItemAttribute::NONE;
+}
+
+void ItemAttributeList::assign(Entry &entry, const ItemAttribute &value) {
+	if (const std::string* str = value.getString()) {
+		if (entry.type == ItemAttribute::STRING) {
+			*entry.string = *str;
+			return;
+		}
+		clear(entry);
+		entry.string = newd std::string(*str);
+	} else {
+		clear(entry);
+		if (const int32_t* integer = value.getInteger()) {
+			entry.integer = *integer;
+		} else if (const double* number = value.getFloat()) {
+			entry.number = *number;
+		} else if (const bool* boolean = value.getBoolean()) {
+			entry.boolean = *boolean;
+		}
+	}
+	entry.type = value.type;
+}
+
+void ItemAttributeList::set(uint16_t key, const ItemAttribute &value) {
+	if (value.type == ItemAttribute::NONE) {
+		erase(key);
+		return;
+	}
+
+	if (key < ItemAttributeKeys::FixedCount) {
+		assign(slots[key], value);
+		return;
+	}
+
+	auto it = std::lower_bound(entries.begin(), entries.end(), key, [](const Entry &entry, uint16_t key) {
+		return entry.key < key;
+	});
+	if (it == entries.end() || it->key != key) {
+		Entry entry;
+		entry.key = key;
+		entry.type = ItemAttribute::NONE;
+		it = entries.insert(it, entry);
+	}
+	assign(*it, value);
+}
+
+void ItemAttributeList::erase(uint16_t key) {
+	if (key < ItemAttributeKeys::FixedCount) {
+		clear(slots[key]);
+		return;
+	}
+
+	for (auto it = entries.begin(); it != entries.end(); ++it) {
+		if (it->key == key) {
+			clear(*it);
+			entries.erase(it);
+			return;
+		}
+	}
+}
+
+ItemAttribute ItemAttributeList::Entry::getAttribute() const {
+	switch (type) {
+		case ItemAttribute::STRING:
+			return ItemAttribute(*string);
+		case ItemAttribute::INTEGER:
+			return ItemAttribute(integer);
+		case ItemAttribute::DOUBLE:
+			return ItemAttribute(number);
+		case ItemAttribute::BOOLEAN:
+			return ItemAttribute(boolean);
+		default:
+			return ItemAttribute();
+	}
+}
+
+void ItemAttributeList::Entry::serialize(NodeFileWriteHandle &f) const {
+	// Same layout as ItemAttribute::serialize
+	f.addU8(type);
+	switch (type) {
+		case ItemAttribute::STRING:
+			f.addLongString(*string);
+			break;
+		case ItemAttribute::INTEGER:
+			f.addU32(static_cast<uint32_t>(integer));
+			break;
+		case ItemAttribute::DOUBLE:
+			f.addU64(std::bit_cast<uint64_t>(number));
+			break;
+		case ItemAttribute::BOOLEAN:
+			f.addU8(boolean);
+			break;
+		default:
+			break;
+	}
+}
+
+//**************** ItemAttributes **********************
 
 ItemAttributes::ItemAttributes() :
 	attributes(nullptr) {
 	////
 }
 
-ItemAttributes::ItemAttributes(const ItemAttributes &o) {
-	if (o.attributes) {
-		attributes = newd ItemAttributeMap(*o.attributes);
-	}
+ItemAttributes::ItemAttributes(const ItemAttributes &o) :
+	attributes(nullptr) {
+	shareAttributes(o);
 }
 
 ItemAttributes::~ItemAttributes() {
 	clearAllAttributes();
 }
 
-void ItemAttributes::createAttributes() {
+ItemAttributeList* ItemAttributes::editAttributes() {
 	if (!attributes) {
-		attributes = newd ItemAttributeMap;
+		attributes = newd ItemAttributeList;
+	} else if (attributes->getReferenceCount() > 1) {
+		// Only this item changes, the others keep the list as it was
+		ItemAttributeList* own = newd ItemAttributeList(*attributes);
+		if (attributes->release()) {
+			delete attributes; // The other owners let go in the meantime
+		}
+		attributes = own;
+	}
+	return attributes;
+}
+
+void ItemAttributes::shareAttributes(const ItemAttributes &other) {
+	if (other.attributes == attributes) {
+		return;
+	}
+	clearAllAttributes();
+	if (other.attributes) {
+		other.attributes->retain();
+		attributes = other.attributes;
 	}
 }
 
 void ItemAttributes::clearAllAttributes() {
-	if (attributes) {
+	if (attributes && attributes->release()) {
 		delete attributes;
 	}
 	attributes = nullptr;
 }
 
 ItemAttributeMap ItemAttributes::getAttributes() const {
+	ItemAttributeMap map;
 	if (attributes) {
-		return *attributes;
+		attributes->forEach([&map](uint16_t key, const ItemAttributeList::Entry &value) {
+			map[ItemAttributeKeys::getName(key)] = value.getAttribute();
+		});
 	}
-	return ItemAttributeMap();
+	return map;
+}
+
+void ItemAttributes::hashAttributes(ContentHash &hash) const {
+	if (!attributes) {
+		hash.add(0);
+		return;
+	}
+
+	// Each pair is hashed on its own and the results summed, so the key order doesn't matter
+	uint64_t sum = 0;
+	attributes->forEach([&sum](uint16_t key, const ItemAttributeList::Entry &value) {
+		ContentHash pair;
+		pair.add(ItemAttributeKeys::getName(key));
+		pair.add(value.type);
+		if (const std::string* string = value.getString()) {
+			pair.add(*string);
+		} else if (const int32_t* integer = value.getInteger()) {
+			pair.add(uint32_t(*integer));
+		} else if (const double* number = value.getFloat()) {
+			pair.add(std::bit_cast<uint64_t>(*number));
+		} else if (const bool* boolean = value.getBoolean()) {
+			pair.add(*boolean);
+		}
+		sum += pair.get();
+	});
+	hash.add(attributes->size());
+	hash.add(sum);
+}
+
+void ItemAttributes::setAttribute(uint16_t key, const ItemAttribute &value) {
+	editAttributes()->set(key, value);
 }
 
 void ItemAttributes::setAttribute(const std::string &key, const ItemAttribute &value) {
-	createAttributes();
-	(*attributes)[key] = value;
+	setAttribute(ItemAttributeKeys::intern(key), value);
 }
 
 void ItemAttributes::setAttribute(const std::string &key, const std::string &value) {
-	createAttributes();
-	(*attributes)[key].set(value);
+	setAttribute(ItemAttributeKeys::intern(key), ItemAttribute(value));
 }
 
 void ItemAttributes::setAttribute(const std::string &key, int32_t value) {
-	createAttributes();
-	(*attributes)[key].set(value);
+	setAttribute(ItemAttributeKeys::intern(key), ItemAttribute(value));
 }
 
 void ItemAttributes::setAttribute(const std::string &key, double value) {
-	createAttributes();
-	(*attributes)[key].set(value);
+	setAttribute(ItemAttributeKeys::intern(key), ItemAttribute(value));
 }
 
 void ItemAttributes::setAttribute(const std::string &key, bool value) {
-	createAttributes();
-	(*attributes)[key].set(value);
+	setAttribute(ItemAttributeKeys::intern(key), ItemAttribute(value));
+}
+
+void ItemAttributes::eraseAttribute(uint16_t key) {
+	if (attributes) {
+		editAttributes()->erase(key);
+	}
 }
 
 void ItemAttributes::eraseAttribute(const std::string &key) {
@@ -85,10 +393,9 @@ void ItemAttributes::eraseAttribute(const std::string &key) {
 		return;
 	}
 
-	ItemAttributeMap::iterator iter = attributes->find(key);
-
-	if (iter != attributes->end()) {
-		attributes->erase(iter);
+	uint16_t id = ItemAttributeKeys::find(key);
+	if (id != ItemAttributeKeys::Invalid) {
+		editAttributes()->erase(id);
 	}
 }
 
@@ -97,11 +404,8 @@ const std::string* ItemAttributes::getStringAttribute(const std::string &key) co
 		return nullptr;
 	}
 
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getString();
-	}
-	return nullptr;
+	uint16_t id = ItemAttributeKeys::find(key);
+	return id != ItemAttributeKeys::Invalid ? attributes->getString(id) : nullptr;
 }
 
 const int32_t* ItemAttributes::getIntegerAttribute(const std::string &key) const {
@@ -109,11 +413,8 @@ const int32_t* ItemAttributes::getIntegerAttribute(const std::string &key) const
 		return nullptr;
 	}
 
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getInteger();
-	}
-	return nullptr;
+	uint16_t id = ItemAttributeKeys::find(key);
+	return id != ItemAttributeKeys::Invalid ? attributes->getInteger(id) : nullptr;
 }
 
 const double* ItemAttributes::getFloatAttribute(const std::string &key) const {
@@ -121,11 +422,8 @@ const double* ItemAttributes::getFloatAttribute(const std::string &key) const {
 		return nullptr;
 	}
 
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getFloat();
-	}
-	return nullptr;
+	uint16_t id = ItemAttributeKeys::find(key);
+	return id != ItemAttributeKeys::Invalid ? attributes->getFloat(id) : nullptr;
 }
 
 const bool* ItemAttributes::getBooleanAttribute(const std::string &key) const {
@@ -133,11 +431,8 @@ const bool* ItemAttributes::getBooleanAttribute(const std::string &key) const {
 		return nullptr;
 	}
 
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getBoolean();
-	}
-	return nullptr;
+	uint16_t id = ItemAttributeKeys::find(key);
+	return id != ItemAttributeKeys::Invalid ? attributes->getBoolean(id) : nullptr;
 }
 
 bool ItemAttributes::hasStringAttribute(const std::string &key) const {
@@ -180,7 +475,8 @@ ItemAttribute::ItemAttribute(double f) :
 	*reinterpret_cast<double*>(data) = f;
 }
 
-ItemAttribute::ItemAttribute(bool b) {
+ItemAttribute::ItemAttribute(bool b) :
+	type(ItemAttribute::BOOLEAN) {
 	*reinterpret_cast<bool*>(data) = b;
 }
 
@@ -279,7 +575,7 @@ const bool* ItemAttribute::getBoolean() const {
 bool ItemAttributes::unserializeAttributeMap(const IOMap &maphandle, BinaryNode* stream) {
 	uint16_t n;
 	if (stream->getU16(n)) {
-		createAttributes();
+		ItemAttributeList* list = editAttributes();
 
 		std::string key;
 		ItemAttribute attrib;
@@ -291,7 +587,7 @@ bool ItemAttributes::unserializeAttributeMap(const IOMap &maphandle, BinaryNode*
 			if (!attrib.unserialize(maphandle, stream)) {
 				return false;
 			}
-			(*attributes)[key] = attrib;
+			list->set(ItemAttributeKeys::intern(key), attrib);
 		}
 	}
 	return true;
@@ -301,18 +597,29 @@ void ItemAttributes::serializeAttributeMap(const IOMap &maphandle, NodeFileWrite
 	// Maximum of 65535 attributes per item
 	f.addU16(std::min((size_t)0xFFFF, attributes->size()));
 
-	ItemAttributeMap::const_iterator attribute = attributes->begin();
+	// Written by name like the old std::map, key ids depend on the order names were first seen in
+	SmallVector<const ItemAttributeList::Entry*, 4> sorted;
+	attributes->forEach([&sorted](uint16_t, const ItemAttributeList::Entry &value) {
+		sorted.push_back(&value);
+	});
+	std::sort(sorted.begin(), sorted.end(), [](const ItemAttributeList::Entry* lhs, const ItemAttributeList::Entry* rhs) {
+		return ItemAttributeKeys::getName(lhs->key) < ItemAttributeKeys::getName(rhs->key);
+	});
+
 	int i = 0;
-	while (attribute != attributes->end() && i <= 0xFFFF) {
-		const std::string &key = attribute->first;
-		if (key.size() > 0xFFFF) {
-			f.addString(key.substr(0, 65535));
+	for (const ItemAttributeList::Entry* value : sorted) {
+		if (i++ >= 0xFFFF) {
+			break;
+		}
+
+		const std::string &name = ItemAttributeKeys::getName(value->key);
+		if (name.size() > 0xFFFF) {
+			f.addString(name.substr(0, 65535));
 		} else {
-			f.addString(key);
+			f.addString(name);
 		}
 
-		attribute->second.serialize(maphandle, f);
-		++attribute, ++i;
+		value->serialize(f);
 	}
 }
 
@@ -18,15 +18,19 @@
 #ifndef RME_ITEM_ATTRIBUTES_H_
 #define RME_ITEM_ATTRIBUTES_H_
 
+#include <atomic>
 #include <string>
 #include <map>
+#include <vector>
 
 #include "filehandle.h"
+#include "small_vector.h"
 
 class IOMap;
 class ItemAttribute;
 
 class PropWriteStream;
+class ContentHash;
 class PropStream;
 
 class ItemAttribute {
@@ -65,11 +69,150 @@ public:
 	const bool* getBoolean() const;
 
 private:
-	char data[sizeof(std::string) > sizeof(double) ? sizeof(std::string) : sizeof(double)];
+	alignas(std::string) char data[sizeof(std::string) > sizeof(double) ? sizeof(std::string) : sizeof(double)];
 };
 
 typedef std::map<std::string, ItemAttribute> ItemAttributeMap;
 
+// Attribute names are interned once, items only store the 16 bit key
+class ItemAttributeKeys {
+public:
+	enum : uint16_t {
+		ActionId = 0, // "aid"
+		UniqueId = 1, // "uid"
+		Text = 2, // "text"
+		Description = 3, // "desc"
+		FixedCount = 4,
+		Invalid = 0xFFFF
+	};
+
+	// Returns the key for the name, registering it if it is new
+	static uint16_t intern(const std::string &name);
+	// Returns Invalid if no item ever used this name
+	static uint16_t find(const std::string &name);
+	static const std::string &getName(uint16_t key);
+};
+
+// The attributes of a single item, the fixed keys have their own slots,
+// everything else is kept in a small vector of entries sorted by key
+class ItemAttributeList {
+public:
+	// Plain data so entries move around with memcpy, the list owns the strings
+	struct Entry {
+		uint16_t key;
+		uint8_t type; // ItemAttribute::Type, NONE for an empty slot
+		union {
+			int32_t integer;
+			double number;
+			bool boolean;
+			std::string* string;
+		};
+
+		const std::string* getString() const noexcept {
+			return type == ItemAttribute::STRING ? string : nullptr;
+		}
+		const int32_t* getInteger() const noexcept {
+			return type == ItemAttribute::INTEGER ? &integer : nullptr;
+		}
+		const double* getFloat() const noexcept {
+			return type == ItemAttribute::DOUBLE ? &number : nullptr;
+		}
+		const bool* getBoolean() const noexcept {
+			return type == ItemAttribute::BOOLEAN ? &boolean : nullptr;
+		}
+		ItemAttribute getAttribute() const;
+		void serialize(NodeFileWriteHandle &f) const;
+	};
+
+	ItemAttributeList();
+	ItemAttributeList(const ItemAttributeList &other);
+	ItemAttributeList &operator=(const ItemAttributeList &) = delete;
+	~ItemAttributeList();
+
+	size_t size() const noexcept;
+	bool empty() const noexcept {
+		return size() == 0;
+	}
+
+	uint16_t getActionID() const noexcept {
+		const int32_t* value = slots[ItemAttributeKeys::ActionId].getInteger();
+		return value ? *value : 0;
+	}
+	uint16_t getUniqueID() const noexcept {
+		const int32_t* value = slots[ItemAttributeKeys::UniqueId].getInteger();
+		return value ? *value : 0;
+	}
+
+	void set(uint16_t key, const ItemAttribute &value);
+	void erase(uint16_t key);
+
+	const std::string* getString(uint16_t key) const {
+		const Entry* entry = findEntry(key);
+		return entry ? entry->getString() : nullptr;
+	}
+	const int32_t* getInteger(uint16_t key) const {
+		const Entry* entry = findEntry(key);
+		return entry ? entry->getInteger() : nullptr;
+	}
+	const double* getFloat(uint16_t key) const {
+		const Entry* entry = findEntry(key);
+		return entry ? entry->getFloat() : nullptr;
+	}
+	const bool* getBoolean(uint16_t key) const {
+		const Entry* entry = findEntry(key);
+		return entry ? entry->getBoolean() : nullptr;
+	}
+
+	// Get memory footprint size, including string data
+	size_t memsize() const noexcept;
+
+	// Copies of an item share one list until either of them changes it, see ItemAttributes.
+	// Selection threads copy tiles concurrently, hence the atomic count.
+	void retain() const noexcept {
+		references.fetch_add(1, std::memory_order_relaxed);
+	}
+	// Returns true when the last reference is gone and the list should be deleted
+	bool release() const noexcept {
+		return references.fetch_sub(1, std::memory_order_acq_rel) == 1;
+	}
+	uint32_t getReferenceCount() const noexcept {
+		return references.load(std::memory_order_acquire);
+	}
+
+	// Calls func(key, entry) for every attribute, slots first
+	template <typename Func>
+	void forEach(Func func) const {
+		for (const Entry &slot : slots) {
+			if (slot.type != ItemAttribute::NONE) {
+				func(slot.key, slot);
+			}
+		}
+		for (const Entry &entry : entries) {
+			func(entry.key, entry);
+		}
+	}
+
+private:
+	const Entry* findEntry(uint16_t key) const noexcept {
+		if (key < ItemAttributeKeys::FixedCount) {
+			return slots[key].type != ItemAttribute::NONE ? &slots[key] : nullptr;
+		}
+		// Items rarely have more than a couple of attributes, a linear scan beats a binary search
+		for (const Entry &entry : entries) {
+			if (entry.key == key) {
+				return &entry;
+			}
+		}
+		return nullptr;
+	}
+	static void assign(Entry &entry, const ItemAttribute &value);
+	static void clear(Entry &entry) noexcept;
+
+	mutable std::atomic<uint32_t> references;
+	Entry slots[ItemAttributeKeys::FixedCount];
+	SmallVector<Entry, 1> entries;
+};
+
 class ItemAttributes {
 public:
 	ItemAttributes();
@@ -93,6 +236,15 @@ public:
 	const double* getFloatAttribute(const std::string &key) const;
 	const bool* getBooleanAttribute(const std::string &key) const;
 
+	// Same as above, for keys that are already interned
+	void setAttribute(uint16_t key, const ItemAttribute &attr);
+	const std::string* getStringAttribute(uint16_t key) const {
+		return attributes ? attributes->getString(key) : nullptr;
+	}
+	const int32_t* getIntegerAttribute(uint16_t key) const {
+		return attributes ? attributes->getInteger(key) : nullptr;
+	}
+
 	// Returns true if the attribute (of that type) exists
 	bool hasStringAttribute(const std::string &key) const;
 	bool hasIntegerAttribute(const std::string &key) const;
@@ -100,14 +252,27 @@ public:
 	bool hasBooleanAttribute(const std::string &key) const;
 
 	void eraseAttribute(const std::string &key);
+	void eraseAttribute(uint16_t key);
 
 	void clearAllAttributes();
 	ItemAttributeMap getAttributes() const;
 
+	// Adds the attributes to hash, the result doesn't depend on the order keys were interned in
+	void hashAttributes(ContentHash &hash) const;
+
+	// A shared list is split evenly over the items sharing it
+	size_t getAttributesMemsize() const noexcept {
+		return attributes ? attributes->memsize() / attributes->getReferenceCount() : 0;
+	}
+
 protected:
-	ItemAttributeMap* attributes;
+	// Might be shared with copies of this item, never change it directly, see editAttributes
+	ItemAttributeList* attributes;
 
-	void createAttributes();
+	// Returns a list only this item uses, creating or unsharing it if needed
+	ItemAttributeList* editAttributes();
+	// Makes this item share the attributes of another one
+	void shareAttributes(const ItemAttributes &other);
 };
 
 #endif
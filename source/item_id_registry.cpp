@@ -0,0 +1,198 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#include "main.h"
+
+#include "item_id_registry.h"
+#include "tile.h"
+#include "complexitem.h"
+
+namespace {
+	const ItemIdRegistry::Positions EmptyIdPositions;
+
+	// Calls func for the ground, the items and everything inside their containers
+	template <typename Func>
+	void forEachRegistryItem(const Tile* tile, Func func) {
+		if (tile->ground) {
+			func(tile->ground);
+		}
+
+		// Records on the tile are read in place, they never hold anything
+		std::vector<const Item*> pending;
+		tile->items.forEach([&](const Item &item) {
+			func(&item);
+			if (const Container* container = dynamic_cast<const Container*>(&item)) {
+				const ItemVector &contents = container->getVector();
+				pending.insert(pending.end(), contents.begin(), contents.end());
+			}
+		});
+		while (!pending.empty()) {
+			const Item* item = pending.back();
+			pending.pop_back();
+			func(item);
+
+			if (const Container* container = dynamic_cast<const Container*>(item)) {
+				const ItemVector &contents = container->getVector();
+				pending.insert(pending.end(), contents.begin(), contents.end());
+			}
+		}
+	}
+}
+
+void ItemIdRegistry::addTile(const Tile* tile) {
+	const Position &position = tile->getPosition();
+	forEachRegistryItem(tile, [&](const Item* item) {
+		if (uint16_t uid = item->getUniqueID(); uid != 0) {
+			insertUniqueId(uid, position);
+		}
+		if (uint16_t aid = item->getActionID(); aid != 0) {
+			insert(action_ids, pending_action_ids, aid, position);
+		}
+	});
+}
+
+void ItemIdRegistry::removeTile(const Tile* tile) {
+	const Position &position = tile->getPosition();
+	forEachRegistryItem(tile, [&](const Item* item) {
+		if (uint16_t uid = item->getUniqueID(); uid != 0) {
+			eraseUniqueId(uid, position);
+		}
+		if (uint16_t aid = item->getActionID(); aid != 0) {
+			erase(action_ids, pending_action_ids, aid, position);
+		}
+	});
+}
+
+void ItemIdRegistry::clear() {
+	unique_ids.clear();
+	action_ids.clear();
+	duplicate_unique_ids.clear();
+	pending_unique_ids.clear();
+	pending_action_ids.clear();
+}
+
+void ItemIdRegistry::endBatch() {
+	ASSERT(batch_depth > 0);
+	if (--batch_depth != 0) {
+		return;
+	}
+
+	for (const auto &[id, sorted] : pending_unique_ids) {
+		sortPending(unique_ids[id], sorted);
+	}
+	for (const auto &[id, sorted] : pending_action_ids) {
+		sortPending(action_ids[id], sorted);
+	}
+	pending_unique_ids.clear();
+	pending_action_ids.clear();
+}
+
+const ItemIdRegistry::Positions &ItemIdRegistry::getUniqueIdPositions(uint16_t uid) const {
+	auto it = unique_ids.find(uid);
+	return it != unique_ids.end() ? it->second : EmptyIdPositions;
+}
+
+const ItemIdRegistry::Positions &ItemIdRegistry::getActionIdPositions(uint16_t aid) const {
+	auto it = action_ids.find(aid);
+	return it != action_ids.end() ? it->second : EmptyIdPositions;
+}
+
+std::vector<uint16_t> ItemIdRegistry::getUniqueIds() const {
+	return sortedIds(unique_ids);
+}
+
+std::vector<uint16_t> ItemIdRegistry::getActionIds() const {
+	return sortedIds(action_ids);
+}
+
+uint64_t ItemIdRegistry::memsize() const {
+	constexpr uint64_t TreeNodeOverhead = 4 * sizeof(void*);
+	return tableMemsize(unique_ids) + tableMemsize(action_ids) + duplicate_unique_ids.size() * (TreeNodeOverhead + sizeof(uint16_t));
+}
+
+void ItemIdRegistry::insertUniqueId(uint16_t uid, const Position &position) {
+	insert(unique_ids, pending_unique_ids, uid, position);
+	if (unique_ids[uid].size() == 2) {
+		duplicate_unique_ids.insert(uid);
+	}
+}
+
+void ItemIdRegistry::eraseUniqueId(uint16_t uid, const Position &position) {
+	if (erase(unique_ids, pending_unique_ids, uid, position) == 1) {
+		duplicate_unique_ids.erase(uid);
+	}
+}
+
+void ItemIdRegistry::insert(Table &table, Pending &pending, uint16_t id, const Position &position) {
+	// Kept sorted, so erasing one is a binary search rather than a scan of every use
+	Positions &positions = table[id];
+	if (batch_depth != 0) {
+		pending.try_emplace(id, positions.size());
+		positions.push_back(position);
+		return;
+	}
+	positions.insert(std::upper_bound(positions.begin(), positions.end(), position), position);
+}
+
+size_t ItemIdRegistry::erase(Table &table, Pending &pending, uint16_t id, const Position &position) {
+	auto it = table.find(id);
+	if (it == table.end()) {
+		return 0;
+	}
+
+	Positions &positions = it->second;
+	if (auto unsorted = pending.find(id); unsorted != pending.end()) {
+		sortPending(positions, unsorted->second);
+		pending.erase(unsorted);
+	}
+	auto match = std::lower_bound(positions.begin(), positions.end(), position);
+	if (match == positions.end() || *match != position) {
+		return positions.size();
+	}
+
+	positions.erase(match);
+	if (positions.empty()) {
+		table.erase(it);
+		return 0;
+	}
+	return positions.size();
+}
+
+void ItemIdRegistry::sortPending(Positions &positions, size_t sorted) {
+	// Only the appended part is sorted, then merged with what was in order already
+	std::sort(positions.begin() + sorted, positions.end());
+	std::inplace_merge(positions.begin(), positions.begin() + sorted, positions.end());
+}
+
+std::vector<uint16_t> ItemIdRegistry::sortedIds(const Table &table) {
+	std::vector<uint16_t> ids;
+	ids.reserve(table.size());
+	for (const auto &[id, positions] : table) {
+		ids.push_back(id);
+	}
+	std::sort(ids.begin(), ids.end());
+	return ids;
+}
+
+uint64_t ItemIdRegistry::tableMemsize(const Table &table) {
+	uint64_t bytes = table.bucket_count() * sizeof(void*);
+	for (const auto &[id, positions] : table) {
+		bytes += sizeof(void*) + sizeof(Table::value_type) + positions.capacity() * sizeof(Position);
+	}
+	return bytes;
+}
@@ -0,0 +1,107 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_ITEM_ID_REGISTRY_H
+#define RME_ITEM_ID_REGISTRY_H
+
+#include "position.h"
+
+#include <set>
+#include <unordered_map>
+
+class Tile;
+
+// Where every unique id and action id of the map is used.
+// The map feeds it each tile as it enters or leaves, so lookups never have to scan.
+// An id is listed once per item carrying it, so the position count is the reference count.
+class ItemIdRegistry {
+public:
+	using Positions = std::vector<Position>;
+
+	void addTile(const Tile* tile);
+	void removeTile(const Tile* tile);
+	void clear();
+
+	// Loading adds tiles area by area rather than in position order, between beginBatch and
+	// endBatch the positions are appended and only sorted once the outermost batch ends.
+	// Until then the position lists of the ids added may be out of order.
+	void beginBatch() noexcept {
+		++batch_depth;
+	}
+	void endBatch();
+
+	bool hasUniqueId(uint16_t uid) const {
+		return unique_ids.contains(uid);
+	}
+	bool hasActionId(uint16_t aid) const {
+		return action_ids.contains(aid);
+	}
+	size_t getUniqueIdReferences(uint16_t uid) const {
+		return getUniqueIdPositions(uid).size();
+	}
+	size_t getActionIdReferences(uint16_t aid) const {
+		return getActionIdPositions(aid).size();
+	}
+
+	// Empty when the id is not used, sorted by position
+	const Positions &getUniqueIdPositions(uint16_t uid) const;
+	const Positions &getActionIdPositions(uint16_t aid) const;
+
+	// Sorted ids currently in use
+	std::vector<uint16_t> getUniqueIds() const;
+	std::vector<uint16_t> getActionIds() const;
+
+	// Unique ids carried by more than one item
+	const std::set<uint16_t> &getDuplicateUniqueIds() const noexcept {
+		return duplicate_unique_ids;
+	}
+
+	size_t uniqueIdCount() const noexcept {
+		return unique_ids.size();
+	}
+	size_t actionIdCount() const noexcept {
+		return action_ids.size();
+	}
+
+	uint64_t memsize() const;
+
+private:
+	using Table = std::unordered_map<uint16_t, Positions>;
+
+	// Ids with positions appended during the batch, and how many of them were sorted before
+	using Pending = std::unordered_map<uint16_t, size_t>;
+
+	void insertUniqueId(uint16_t uid, const Position &position);
+	void eraseUniqueId(uint16_t uid, const Position &position);
+
+	void insert(Table &table, Pending &pending, uint16_t id, const Position &position);
+	static size_t erase(Table &table, Pending &pending, uint16_t id, const Position &position);
+	static void sortPending(Positions &positions, size_t sorted);
+	static std::vector<uint16_t> sortedIds(const Table &table);
+	static uint64_t tableMemsize(const Table &table);
+
+	Table unique_ids;
+	Table action_ids;
+	std::set<uint16_t> duplicate_unique_ids;
+
+	int batch_depth = 0;
+	Pending pending_unique_ids;
+	Pending pending_action_ids;
+};
+
+#endif
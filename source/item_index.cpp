@@ -0,0 +1,123 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#include "main.h"
+
+#include "item_index.h"
+#include "map_traversal.h"
+#include "complexitem.h"
+
+namespace {
+	// Calls func for the ground, the items and everything inside their containers
+	template <typename Func>
+	void forEachIndexedItem(const Tile* tile, Func func) {
+		if (tile->ground) {
+			func(tile->ground);
+		}
+
+		// Records on the tile are read in place, they never hold anything
+		std::vector<const Item*> pending;
+		tile->items.forEach([&](const Item &item) {
+			func(&item);
+			if (const Container* container = dynamic_cast<const Container*>(&item)) {
+				const ItemVector &contents = container->getVector();
+				pending.insert(pending.end(), contents.begin(), contents.end());
+			}
+		});
+		while (!pending.empty()) {
+			const Item* item = pending.back();
+			pending.pop_back();
+			func(item);
+
+			if (const Container* container = dynamic_cast<const Container*>(item)) {
+				const ItemVector &contents = container->getVector();
+				pending.insert(pending.end(), contents.begin(), contents.end());
+			}
+		}
+	}
+}
+
+ItemIndex::ItemIndex() :
+	budget(0),
+	built(false),
+	exhausted(false) {
+	////
+}
+
+bool ItemIndex::build(BaseMap &map, uint64_t newBudget, const Progress &progress) {
+	clear();
+	budget = newBudget;
+
+	// Each worker fills its own table, a leaf is only ever walked by one worker
+	// and its tiles come one after another, so runs of the same leaf fold in place
+	const auto visit = [](const Tile* tile, ItemLeafTable &partial) {
+		const uint32_t key = MapLeaf::key(tile->getPosition());
+		forEachIndexedItem(tile, [&](const Item* item) {
+			partial.append(item->getID(), key);
+		});
+	};
+	const auto merge = [](ItemLeafTable &into, ItemLeafTable &from) {
+		into.merge(std::move(from));
+	};
+	table = MapTraversal::reduce<ItemLeafTable>(map, visit, merge, progress);
+	table.finish();
+
+	built = true;
+	checkBudget();
+	return built;
+}
+
+void ItemIndex::clear() {
+	table.clear();
+	built = false;
+	exhausted = false;
+}
+
+void ItemIndex::addTile(const Tile* tile) {
+	if (!built) {
+		return;
+	}
+
+	const uint32_t key = MapLeaf::key(tile->getPosition());
+	forEachIndexedItem(tile, [&](const Item* item) {
+		table.add(item->getID(), key);
+	});
+	checkBudget();
+}
+
+void ItemIndex::removeTile(const Tile* tile) {
+	if (!built) {
+		return;
+	}
+
+	const uint32_t key = MapLeaf::key(tile->getPosition());
+	forEachIndexedItem(tile, [&](const Item* item) {
+		table.remove(item->getID(), key);
+	});
+}
+
+uint64_t ItemIndex::memsize() const noexcept {
+	return table.memsize();
+}
+
+void ItemIndex::checkBudget() {
+	if (table.getEstimatedBytes() > budget) {
+		clear();
+		exhausted = true;
+	}
+}
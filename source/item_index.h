@@ -0,0 +1,85 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_ITEM_INDEX_H
+#define RME_ITEM_INDEX_H
+
+#include "item_leaf_table.h"
+
+#include <functional>
+
+class BaseMap;
+class Tile;
+
+// Which map leaves (4x4 tiles of one floor) hold each item id, so finding or
+// replacing an item only visits those leaves instead of every tile of the map.
+// Built on first use and then kept up to date by the map as tiles are replaced.
+// It gives up, and searches go back to walking the map, once it outgrows its budget.
+class ItemIndex {
+public:
+	using Progress = std::function<void(uint64_t done, uint64_t total)>;
+
+	ItemIndex();
+
+	// budget is in bytes, false if the index doesn't fit (it is then left empty)
+	bool build(BaseMap &map, uint64_t budget, const Progress &progress = nullptr);
+	void clear();
+
+	bool isBuilt() const noexcept {
+		return built;
+	}
+	// Set once a build or an update went over the budget, cleared by clear()
+	bool isExhausted() const noexcept {
+		return exhausted;
+	}
+	uint64_t getBudget() const noexcept {
+		return budget;
+	}
+
+	void addTile(const Tile* tile);
+	void removeTile(const Tile* tile);
+
+	// Items with this id on the map, including the ones inside containers
+	uint32_t getCount(uint16_t id) const noexcept {
+		return built ? table.getCount(id) : 0;
+	}
+
+	// func(x, y, z) with the top left corner of every leaf holding the id
+	template <typename Func>
+	void forEachLeaf(uint16_t id, Func func) const {
+		if (!built) {
+			return;
+		}
+		for (const ItemLeafTable::LeafEntry &entry : table.getLeaves(id)) {
+			const Position corner = MapLeaf::corner(entry.key);
+			func(corner.x, corner.y, corner.z);
+		}
+	}
+
+	uint64_t memsize() const noexcept;
+
+private:
+	void checkBudget();
+
+	ItemLeafTable table;
+	uint64_t budget;
+	bool built;
+	bool exhausted;
+};
+
+#endif
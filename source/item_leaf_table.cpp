@@ -0,0 +1,144 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+// No main.h here, the table does not need the editor and its test builds it on its own
+#include "item_leaf_table.h"
+
+#include <algorithm>
+
+namespace {
+	ItemLeafTable::LeafList::iterator findLeaf(ItemLeafTable::LeafList &list, uint32_t key) {
+		return std::lower_bound(list.begin(), list.end(), key, [](const ItemLeafTable::LeafEntry &entry, uint32_t value) {
+			return entry.key < value;
+		});
+	}
+}
+
+ItemLeafTable::ItemLeafTable() :
+	entries(0) {
+	////
+}
+
+void ItemLeafTable::clear() {
+	leaves.clear();
+	leaves.shrink_to_fit();
+	counts.clear();
+	counts.shrink_to_fit();
+	entries = 0;
+}
+
+void ItemLeafTable::allocate() {
+	if (leaves.empty()) {
+		leaves.resize(Ids);
+		counts.resize(Ids);
+	}
+}
+
+void ItemLeafTable::append(uint16_t id, uint32_t key) {
+	allocate();
+	LeafList &list = leaves[id];
+	if (!list.empty() && list.back().key == key) {
+		++list.back().count;
+	} else {
+		list.push_back({ key, 1 });
+		++entries;
+	}
+	++counts[id];
+}
+
+void ItemLeafTable::merge(ItemLeafTable &&other) {
+	if (other.empty()) {
+		return;
+	}
+	if (empty()) {
+		*this = std::move(other);
+		return;
+	}
+	for (size_t id = 0; id < Ids; ++id) {
+		LeafList &list = leaves[id];
+		list.insert(list.end(), other.leaves[id].begin(), other.leaves[id].end());
+		counts[id] += other.counts[id];
+	}
+	entries += other.entries;
+	other.clear();
+}
+
+void ItemLeafTable::finish() {
+	allocate();
+
+	// A leaf may have been split into several runs, sort and fold them
+	entries = 0;
+	for (LeafList &list : leaves) {
+		std::sort(list.begin(), list.end(), [](const LeafEntry &a, const LeafEntry &b) {
+			return a.key < b.key;
+		});
+		auto out = list.begin();
+		for (auto it = list.begin(); it != list.end(); ++it) {
+			if (out != list.begin() && (out - 1)->key == it->key) {
+				(out - 1)->count += it->count;
+			} else {
+				*out++ = *it;
+			}
+		}
+		list.erase(out, list.end());
+		list.shrink_to_fit();
+		entries += list.size();
+	}
+}
+
+void ItemLeafTable::add(uint16_t id, uint32_t key) {
+	allocate();
+	LeafList &list = leaves[id];
+	auto it = findLeaf(list, key);
+	if (it != list.end() && it->key == key) {
+		++it->count;
+	} else {
+		list.insert(it, { key, 1 });
+		++entries;
+	}
+	++counts[id];
+}
+
+void ItemLeafTable::remove(uint16_t id, uint32_t key) {
+	if (empty()) {
+		return;
+	}
+	LeafList &list = leaves[id];
+	auto it = findLeaf(list, key);
+	if (it == list.end() || it->key != key) {
+		return;
+	}
+
+	if (--it->count == 0) {
+		list.erase(it);
+		--entries;
+	}
+	--counts[id];
+}
+
+uint64_t ItemLeafTable::getEstimatedBytes() const noexcept {
+	return Ids * (sizeof(LeafList) + sizeof(uint32_t)) + entries * sizeof(LeafEntry);
+}
+
+uint64_t ItemLeafTable::memsize() const noexcept {
+	uint64_t bytes = leaves.capacity() * sizeof(LeafList) + counts.capacity() * sizeof(uint32_t);
+	for (const LeafList &list : leaves) {
+		bytes += list.capacity() * sizeof(LeafEntry);
+	}
+	return bytes;
+}
@@ -0,0 +1,80 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_ITEM_LEAF_TABLE_H
+#define RME_ITEM_LEAF_TABLE_H
+
+#include "map_leaf.h"
+
+#include <cstdint>
+#include <vector>
+
+// For every item id, the map leaves holding it with a count per leaf, kept sorted by leaf key,
+// and a total per id. It knows nothing of tiles or items, ItemIndex feeds it ids and leaf keys,
+// so it builds and is tested without the rest of the editor.
+class ItemLeafTable {
+public:
+	struct LeafEntry {
+		uint32_t key;
+		uint32_t count;
+	};
+	using LeafList = std::vector<LeafEntry>;
+
+	static constexpr size_t Ids = 0x10000;
+
+	ItemLeafTable();
+
+	bool empty() const noexcept {
+		return leaves.empty();
+	}
+	void clear();
+
+	// Building: runs are appended as they come, a run of the same leaf folds in place.
+	// Tables filled on other threads are merged, finish() then sorts and folds every list.
+	void append(uint16_t id, uint32_t key);
+	void merge(ItemLeafTable &&other);
+	void finish();
+
+	// Updates on a finished table, the lists stay sorted
+	void add(uint16_t id, uint32_t key);
+	void remove(uint16_t id, uint32_t key);
+
+	uint32_t getCount(uint16_t id) const noexcept {
+		return counts.empty() ? 0 : counts[id];
+	}
+	const LeafList &getLeaves(uint16_t id) const noexcept {
+		static const LeafList none;
+		return leaves.empty() ? none : leaves[id];
+	}
+	uint64_t getEntryCount() const noexcept {
+		return entries;
+	}
+
+	// From the entries rather than the capacities, so it is cheap enough for every update
+	uint64_t getEstimatedBytes() const noexcept;
+	uint64_t memsize() const noexcept;
+
+private:
+	void allocate();
+
+	std::vector<LeafList> leaves; // By item id
+	std::vector<uint32_t> counts; // By item id
+	uint64_t entries;
+};
+
+#endif
@@ -135,6 +135,13 @@ void ItemDatabase::clear() {
 		items[i].reset();
 		items.set(i, nullptr);
 	}
+
+	type_flags.clear();
+	type_flags.shrink_to_fit();
+	top_orders.clear();
+	top_orders.shrink_to_fit();
+	minimap_colors.clear();
+	minimap_colors.shrink_to_fit();
 }
 
 bool ItemDatabase::loadGroupByOtbVersion(const std::shared_ptr<ItemType> &item, wxArrayString &warnings) const {
@@ -766,6 +773,79 @@ std::shared_ptr<ItemType> ItemDatabase::getRawItemType(uint16_t id) {
 	return items[id];
 }
 
+const ItemType* ItemDatabase::findItemType(uint16_t id) const {
+	if (id == 0 || id > maxItemId) {
+		return nullptr;
+	}
+	return items[id].get();
+}
+
+uint32_t ItemDatabase::computeFlags(uint16_t id) const noexcept {
+	// Unknown ids answer like the dummy type getItemType hands out
+	const ItemType* type = findItemType(id);
+	uint32_t flags = type ? ITEMTYPE_VALID : 0;
+	if (!type) {
+		type = &dummy;
+	}
+
+	const auto set = [&flags](bool condition, uint32_t flag) {
+		if (condition) {
+			flags |= flag;
+		}
+	};
+	set(type->unpassable, ITEMTYPE_UNPASSABLE);
+	set(type->blockMissiles, ITEMTYPE_BLOCK_MISSILES);
+	set(type->blockPathfinder, ITEMTYPE_BLOCK_PATHFINDER);
+	set(type->hasElevation, ITEMTYPE_HAS_ELEVATION);
+	set(type->alwaysOnBottom, ITEMTYPE_ALWAYS_ON_BOTTOM);
+	set(type->stackable, ITEMTYPE_STACKABLE);
+	set(type->moveable, ITEMTYPE_MOVEABLE);
+	set(type->pickupable, ITEMTYPE_PICKUPABLE);
+	set(type->isHangable, ITEMTYPE_HANGABLE);
+	set(type->isGroundTile(), ITEMTYPE_GROUND);
+	set(type->isSplash(), ITEMTYPE_SPLASH);
+	set(type->isFluidContainer(), ITEMTYPE_FLUID_CONTAINER);
+	set(type->isMagicField(), ITEMTYPE_MAGIC_FIELD);
+	set(type->isDoor(), ITEMTYPE_DOOR);
+	set(type->isBorder, ITEMTYPE_BORDER);
+	set(type->isOptionalBorder, ITEMTYPE_OPTIONAL_BORDER);
+	set(type->isWall, ITEMTYPE_WALL);
+	set(type->isBrushDoor, ITEMTYPE_BRUSH_DOOR);
+	set(type->isOpen, ITEMTYPE_OPEN);
+	set(type->isTable, ITEMTYPE_TABLE);
+	set(type->isCarpet, ITEMTYPE_CARPET);
+	set(type->isMetaItem(), ITEMTYPE_META);
+	set(type->sprite && type->sprite->hasLight(), ITEMTYPE_HAS_LIGHT);
+	set(type->isFloorChange(), ITEMTYPE_FLOOR_CHANGE);
+	return flags;
+}
+
+int ItemDatabase::computeTopOrder(uint16_t id) const noexcept {
+	const ItemType* type = findItemType(id);
+	return (type ? type : &dummy)->alwaysOnTopOrder;
+}
+
+uint8_t ItemDatabase::computeMiniMapColor(uint16_t id) const noexcept {
+	const ItemType* type = findItemType(id);
+	return type && type->sprite ? type->sprite->getMiniMapColor() : 0;
+}
+
+void ItemDatabase::buildPropertyTable() {
+	// Filled into local vectors first, the getters fall back on the item types while the table is empty
+	std::vector<uint32_t> flags(maxItemId + 1);
+	std::vector<uint8_t> orders(maxItemId + 1);
+	std::vector<uint8_t> colors(maxItemId + 1);
+	for (uint32_t id = 0; id <= maxItemId; ++id) {
+		flags[id] = computeFlags(id);
+		orders[id] = static_cast<uint8_t>(computeTopOrder(id));
+		colors[id] = computeMiniMapColor(id);
+	}
+
+	type_flags = std::move(flags);
+	top_orders = std::move(orders);
+	minimap_colors = std::move(colors);
+}
+
 bool ItemDatabase::isValidID(uint16_t id) const {
 	if (id == 0 || id > maxItemId) {
 		return false;
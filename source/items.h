@@ -150,6 +150,35 @@ enum itemflags_t {
 	FLAG_IGNORE_LOOK = 1 << 23
 };
 
+// Bits of ItemDatabase's packed property table
+enum ItemTypeFlags_t : uint32_t {
+	ITEMTYPE_VALID = 1 << 0,
+	ITEMTYPE_UNPASSABLE = 1 << 1,
+	ITEMTYPE_BLOCK_MISSILES = 1 << 2,
+	ITEMTYPE_BLOCK_PATHFINDER = 1 << 3,
+	ITEMTYPE_HAS_ELEVATION = 1 << 4,
+	ITEMTYPE_ALWAYS_ON_BOTTOM = 1 << 5,
+	ITEMTYPE_STACKABLE = 1 << 6,
+	ITEMTYPE_MOVEABLE = 1 << 7,
+	ITEMTYPE_PICKUPABLE = 1 << 8,
+	ITEMTYPE_HANGABLE = 1 << 9,
+	ITEMTYPE_GROUND = 1 << 10,
+	ITEMTYPE_SPLASH = 1 << 11,
+	ITEMTYPE_FLUID_CONTAINER = 1 << 12,
+	ITEMTYPE_MAGIC_FIELD = 1 << 13,
+	ITEMTYPE_DOOR = 1 << 14,
+	ITEMTYPE_BORDER = 1 << 15,
+	ITEMTYPE_OPTIONAL_BORDER = 1 << 16,
+	ITEMTYPE_WALL = 1 << 17,
+	ITEMTYPE_BRUSH_DOOR = 1 << 18,
+	ITEMTYPE_OPEN = 1 << 19,
+	ITEMTYPE_TABLE = 1 << 20,
+	ITEMTYPE_CARPET = 1 << 21,
+	ITEMTYPE_META = 1 << 22,
+	ITEMTYPE_HAS_LIGHT = 1 << 23,
+	ITEMTYPE_FLOOR_CHANGE = 1 << 24,
+};
+
 enum slotsOTB_t {
 	OTB_SLOT_DEFAULT,
 	OTB_SLOT_HEAD,
@@ -408,6 +437,26 @@ public:
 
 	bool isValidID(uint16_t id) const;
 
+	// The properties tile updates, drawing and the brushes test all the time, packed by id.
+	// Brushes flag item types while the materials load, so this is built after them;
+	// until then, and for ids outside the table, the answers come from the ItemType.
+	void buildPropertyTable();
+	uint32_t getFlags(uint16_t id) const noexcept {
+		return id < type_flags.size() ? type_flags[id] : computeFlags(id);
+	}
+	bool hasFlag(uint16_t id, uint32_t flag) const noexcept {
+		return (getFlags(id) & flag) != 0;
+	}
+	int getTopOrder(uint16_t id) const noexcept {
+		return id < top_orders.size() ? top_orders[id] : computeTopOrder(id);
+	}
+	uint8_t getMiniMapColor(uint16_t id) const noexcept {
+		return id < minimap_colors.size() ? minimap_colors[id] : computeMiniMapColor(id);
+	}
+	size_t getPropertyTableMemsize() const noexcept {
+		return type_flags.capacity() * sizeof(uint32_t) + top_orders.capacity() + minimap_colors.capacity();
+	}
+
 	bool loadFromOtb(const FileName &datafile, wxString &error, wxArrayString &warnings);
 	bool loadFromGameXml(const FileName &datafile, wxString &error, wxArrayString &warnings);
 	bool loadItemFromGameXml(pugi::xml_node itemNode, uint16_t id);
@@ -432,9 +481,18 @@ protected:
 
 	bool loadFromOtb(BinaryNode* itemNode, wxString &error, wxArrayString &warnings);
 
+	const ItemType* findItemType(uint16_t id) const;
+	uint32_t computeFlags(uint16_t id) const noexcept;
+	int computeTopOrder(uint16_t id) const noexcept;
+	uint8_t computeMiniMapColor(uint16_t id) const noexcept;
+
 protected:
 	ItemMap items;
 
+	std::vector<uint32_t> type_flags;
+	std::vector<uint8_t> top_orders;
+	std::vector<uint8_t> minimap_colors;
+
 	// Count of GameSprite types
 	uint16_t item_count;
 	uint16_t effect_count;
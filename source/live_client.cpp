@@ -203,6 +203,10 @@ void LiveClient::send(NetworkMessage &message) {
 	});
 }
 
+size_t LiveClient::getBufferMemsize() const {
+	return LiveSocket::getBufferMemsize() + readMessage.buffer.capacity();
+}
+
 void LiveClient::updateCursor(const Position &position) {
 	LiveCursor cursor;
 	cursor.id = 77; // Unimportant, server fixes it for us
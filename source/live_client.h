@@ -49,6 +49,8 @@ public:
 	//
 	void updateCursor(const Position &position);
 
+	size_t getBufferMemsize() const override;
+
 	LiveLogTab* createLogWindow(wxWindow* parent);
 	MapTab* createEditorWindow();
 
@@ -102,6 +102,10 @@ void LivePeer::send(NetworkMessage &message) {
 	});
 }
 
+size_t LivePeer::getBufferMemsize() const {
+	return LiveSocket::getBufferMemsize() + readMessage.buffer.capacity();
+}
+
 void LivePeer::parseLoginPacket(NetworkMessage message) {
 	uint8_t packetType;
 	while (message.position < message.buffer.size()) {
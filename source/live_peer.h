@@ -55,6 +55,8 @@ public:
 	//
 	void updateCursor(const Position &position) { }
 
+	size_t getBufferMemsize() const override;
+
 protected:
 	void parseLoginPacket(NetworkMessage message);
 	void parseEditorPacket(NetworkMessage message);
@@ -126,6 +126,14 @@ void LiveServer::removeClient(uint32_t id) {
 	updateClientList();
 }
 
+size_t LiveServer::getBufferMemsize() const {
+	size_t mem = LiveSocket::getBufferMemsize();
+	for (const auto &clientEntry : clients) {
+		mem += clientEntry.second->getBufferMemsize();
+	}
+	return mem;
+}
+
 void LiveServer::updateCursor(const Position &position) {
 	LiveCursor cursor;
 	cursor.id = 0;
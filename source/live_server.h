@@ -47,6 +47,9 @@ public:
 	void updateCursor(const Position &position);
 	void updateClientList() const;
 
+	// Includes the buffers of every connected peer
+	size_t getBufferMemsize() const override;
+
 	//
 	LiveLogTab* createLogWindow(wxWindow* parent);
 
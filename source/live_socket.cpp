@@ -82,6 +82,10 @@ std::vector<LiveCursor> LiveSocket::getCursorList() const {
 	return cursorList;
 }
 
+size_t LiveSocket::getBufferMemsize() const {
+	return mapWriter.getCapacity();
+}
+
 void LiveSocket::logMessage(const wxString &message) {
 	wxTheApp->CallAfter([this, message]() {
 		if (log) {
@@ -198,7 +202,8 @@ void LiveSocket::sendFloor(NetworkMessage &message, Floor* floor) {
 		for (uint_fast8_t y = 0; y < 4; ++y) {
 			uint_fast8_t index = (x * 4) + y;
 
-			Tile* tile = floor->locs[index].get();
+			const TileLocation* location = floor->getLocation(index);
+			const Tile* tile = location ? location->get() : nullptr;
 			if (tile && tile->size() > 0) {
 				tileBits |= (1 << index);
 			}
@@ -215,7 +220,7 @@ void LiveSocket::sendFloor(NetworkMessage &message, Floor* floor) {
 		for (uint_fast8_t y = 0; y < 4; ++y) {
 			uint_fast8_t index = (x * 4) + y;
 			if (testFlags(tileBits, static_cast<uint64_t>(1) << index)) {
-				sendTile(mapWriter, floor->locs[index].get(), nullptr);
+				sendTile(mapWriter, floor->getLocation(index)->get(), nullptr);
 			}
 		}
 	}
@@ -264,9 +269,9 @@ void LiveSocket::sendTile(MemoryNodeFileWriteHandle &writer, Tile* tile, const P
 		}
 	}
 
-	for (Item* item : tile->items) {
-		item->serializeItemNode_OTBM(mapVersion, writer);
-	}
+	tile->items.forEach([&](const Item &item) {
+		item.serializeItemNode_OTBM(mapVersion, writer);
+	});
 
 	writer.endNode();
 }
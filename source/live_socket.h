@@ -65,6 +65,9 @@ public:
 	//
 	virtual void updateCursor(const Position &position) = 0;
 
+	// Bytes held in serialization and network buffers
+	virtual size_t getBufferMemsize() const;
+
 protected:
 	// receive / send methods
 	void receiveNode(NetworkMessage &message, Editor &editor, Action* action, int32_t ndx, int32_t ndy, bool underground);
@@ -35,6 +35,8 @@
 #include "items.h"
 #include "editor.h"
 #include "materials.h"
+#include "map_traversal.h"
+#include "memory_report.h"
 #include "live_client.h"
 #include "live_server.h"
 
@@ -118,12 +120,14 @@ MainMenuBar::MainMenuBar(MainFrame* frame) :
 	MAKE_ACTION(MAP_REMOVE_ITEMS, wxITEM_NORMAL, OnMapRemoveItems);
 	MAKE_ACTION(MAP_REMOVE_CORPSES, wxITEM_NORMAL, OnMapRemoveCorpses);
 	MAKE_ACTION(MAP_REMOVE_UNREACHABLE_TILES, wxITEM_NORMAL, OnMapRemoveUnreachable);
+	MAKE_ACTION(MAP_HIGHLIGHT_ISOLATED_AREAS, wxITEM_CHECK, OnMapHighlightIsolatedAreas);
 	MAKE_ACTION(MAP_REMOVE_EMPTY_MONSTERS_SPAWNS, wxITEM_NORMAL, OnMapRemoveEmptyMonsterSpawns);
 	MAKE_ACTION(MAP_REMOVE_EMPTY_NPCS_SPAWNS, wxITEM_NORMAL, OnMapRemoveEmptyNpcSpawns);
 	MAKE_ACTION(MAP_CLEANUP, wxITEM_NORMAL, OnMapCleanup);
 	MAKE_ACTION(MAP_CLEAN_HOUSE_ITEMS, wxITEM_NORMAL, OnMapCleanHouseItems);
 	MAKE_ACTION(MAP_PROPERTIES, wxITEM_NORMAL, OnMapProperties);
 	MAKE_ACTION(MAP_STATISTICS, wxITEM_NORMAL, OnMapStatistics);
+	MAKE_ACTION(MAP_MEMORY_REPORT, wxITEM_NORMAL, OnMapMemoryReport);
 
 	MAKE_ACTION(VIEW_TOOLBARS_BRUSHES, wxITEM_CHECK, OnToolbars);
 	MAKE_ACTION(VIEW_TOOLBARS_POSITION, wxITEM_CHECK, OnToolbars);
@@ -382,6 +386,8 @@ void MainMenuBar::Update() {
 	EnableItem(MAP_REMOVE_ITEMS, is_host);
 	EnableItem(MAP_REMOVE_CORPSES, is_local);
 	EnableItem(MAP_REMOVE_UNREACHABLE_TILES, is_local);
+	EnableItem(MAP_HIGHLIGHT_ISOLATED_AREAS, has_map);
+	CheckItem(MAP_HIGHLIGHT_ISOLATED_AREAS, has_map && editor->getMap().getIsolatedAreas());
 	EnableItem(MAP_REMOVE_EMPTY_MONSTERS_SPAWNS, is_local);
 	EnableItem(MAP_REMOVE_EMPTY_NPCS_SPAWNS, is_local);
 	EnableItem(CLEAR_INVALID_HOUSES, is_local);
@@ -394,6 +400,7 @@ void MainMenuBar::Update() {
 	EnableItem(MAP_CLEANUP, is_local);
 	EnableItem(MAP_PROPERTIES, is_local);
 	EnableItem(MAP_STATISTICS, is_local);
+	EnableItem(MAP_MEMORY_REPORT, has_map);
 
 	EnableItem(NEW_VIEW, has_map);
 	EnableItem(ZOOM_IN, has_map);
@@ -919,19 +926,30 @@ namespace OnSearchForItem {
 			return result.size() >= (size_t)maxCount;
 		}
 
-		void operator()(Map &map, Tile* tile, Item* item, long long done) {
-			if (result.size() >= (size_t)maxCount) {
-				return;
+		// Reads the item where it lies, only an item with the id is built and handed to operator()
+		bool wants(Map &map, Tile* tile, const Item &item, long long done) {
+			if (limitReached()) {
+				return false;
 			}
 
 			if (done % 0x8000 == 0) {
 				g_gui.SetLoadDone((unsigned int)(100 * done / map.getTileCount()));
 			}
 
-			if (item->getID() == itemId) {
-				result.push_back(std::make_pair(tile, item));
+			if (item.getID() == itemId) {
+				return true;
 			}
 
+			addTile(tile);
+			return false;
+		}
+
+		void operator()(Map &map, Tile* tile, Item* item, long long done) {
+			result.push_back(std::make_pair(tile, item));
+			addTile(tile);
+		}
+
+		void addTile(Tile* tile) {
 			if (!findTile) {
 				return;
 			}
@@ -987,7 +1005,11 @@ void MainMenuBar::OnSearchForItem(wxCommandEvent &WXUNUSED(event)) {
 
 		g_gui.CreateLoadBar("Searching map...");
 
-		foreach_ItemOnMap(g_gui.GetCurrentMap(), finder, false);
+		if (dialog.getSearchMode() == FindItemDialog::SearchMode::TileTypes) {
+			foreach_ItemOnMap(g_gui.GetCurrentMap(), finder, false);
+		} else {
+			foreach_ItemWithIdOnMap(g_gui.GetCurrentMap(), dialog.getResultID(), finder, false);
+		}
 		std::vector<std::pair<Tile*, Item*>> &result = finder.result;
 
 		g_gui.DestroyLoadBar();
@@ -1054,14 +1076,17 @@ namespace OnSearchForStuff {
 		bool search_writeable;
 		std::vector<std::pair<Tile*, Item*>> found;
 
-		void operator()(Map &map, Tile* tile, Item* item, long long done) {
+		// Reads the item where it lies, only the matches are built and handed to operator()
+		bool wants(Map &map, Tile* tile, const Item &item, long long done) {
 			if (done % 0x8000 == 0) {
 				g_gui.SetLoadDone((unsigned int)(100 * done / map.getTileCount()));
 			}
-			Container* container;
-			if ((search_unique && item->getUniqueID() > 0) || (search_action && item->getActionID() > 0) || (search_container && ((container = dynamic_cast<Container*>(item)) && container->getItemCount())) || (search_writeable && item && item->getText().length() > 0)) {
-				found.push_back(std::make_pair(tile, item));
-			}
+			const Container* container;
+			return (search_unique && item.getUniqueID() > 0) || (search_action && item.getActionID() > 0) || (search_container && ((container = dynamic_cast<const Container*>(&item)) && container->getItemCount())) || (search_writeable && item.getText().length() > 0);
+		}
+
+		void operator()(Map &map, Tile* tile, Item* item, long long done) {
+			found.push_back(std::make_pair(tile, item));
 		}
 
 		wxString desc(Item* item) {
@@ -1159,7 +1184,7 @@ void MainMenuBar::OnSearchForItemOnSelection(wxCommandEvent &WXUNUSED(event)) {
 		OnSearchForItem::Finder finder(dialog.getResultID(), (uint32_t)g_settings.getInteger(Config::REPLACE_SIZE));
 		g_gui.CreateLoadBar("Searching on selected area...");
 
-		foreach_ItemOnMap(g_gui.GetCurrentMap(), finder, true);
+		foreach_ItemWithIdOnMap(g_gui.GetCurrentMap(), dialog.getResultID(), finder, true);
 		std::vector<std::pair<Tile*, Item*>> &result = finder.result;
 
 		g_gui.DestroyLoadBar();
@@ -1452,52 +1477,25 @@ void MainMenuBar::OnMapRemoveCorpses(wxCommandEvent &WXUNUSED(event)) {
 }
 
 namespace OnMapRemoveUnreachable {
-	struct condition {
-		condition() { }
-
-		bool isReachable(Tile* tile) {
-			if (tile == nullptr) {
-				return false;
-			}
-			if (!tile->isBlocking()) {
-				return true;
-			}
-			return false;
+	// A tile stays when a player could stand close enough to see it
+	bool isUnreachable(const WalkabilityMap &walkability, const Position &pos) {
+		int sz, ez;
+		if (pos.z < 8) {
+			sz = 0;
+			ez = 9;
+		} else {
+			// underground
+			sz = std::max(pos.z - 2, rme::MapGroundLayer);
+			ez = std::min(pos.z + 2, rme::MapMaxLayer);
 		}
 
-		bool operator()(Map &map, Tile* tile, long long removed, long long done, long long total) {
-			if (done % 0x1000 == 0) {
-				g_gui.SetLoadDone((unsigned int)(100 * done / total));
-			}
-
-			const Position &pos = tile->getPosition();
-			int sx = std::max(pos.x - 10, 0);
-			int ex = std::min(pos.x + 10, 65535);
-			int sy = std::max(pos.y - 8, 0);
-			int ey = std::min(pos.y + 8, 65535);
-			int sz, ez;
-
-			if (pos.z < 8) {
-				sz = 0;
-				ez = 9;
-			} else {
-				// underground
-				sz = std::max(pos.z - 2, rme::MapGroundLayer);
-				ez = std::min(pos.z + 2, rme::MapMaxLayer);
-			}
-
-			for (int z = sz; z <= ez; ++z) {
-				for (int y = sy; y <= ey; ++y) {
-					for (int x = sx; x <= ex; ++x) {
-						if (isReachable(map.getTile(x, y, z))) {
-							return false;
-						}
-					}
-				}
+		for (int z = sz; z <= ez; ++z) {
+			if (walkability.anyWalkable(z, pos.x - 10, pos.y - 8, pos.x + 10, pos.y + 8)) {
+				return false;
 			}
-			return true;
 		}
-	};
+		return true;
+	}
 }
 
 void MainMenuBar::OnMapRemoveUnreachable(wxCommandEvent &WXUNUSED(event)) {
@@ -1511,22 +1509,65 @@ void MainMenuBar::OnMapRemoveUnreachable(wxCommandEvent &WXUNUSED(event)) {
 		g_gui.GetCurrentEditor()->getSelection().clear();
 		g_gui.GetCurrentEditor()->clearActions();
 
-		OnMapRemoveUnreachable::condition func;
 		g_gui.CreateLoadBar("Searching map for tiles to remove...");
 
-		long long removed = remove_if_TileOnMap(g_gui.GetCurrentMap(), func);
+		Map &map = g_gui.GetCurrentMap();
+		const WalkabilityMap &walkability = map.getWalkability();
+
+		// Only reads the walkability map, the tiles are removed once all workers are done
+		const auto collect = [&walkability](const Tile* tile, std::vector<Position> &positions) {
+			if (OnMapRemoveUnreachable::isUnreachable(walkability, tile->getPosition())) {
+				positions.push_back(tile->getPosition());
+			}
+		};
+		const auto merge = [](std::vector<Position> &into, const std::vector<Position> &from) {
+			into.insert(into.end(), from.begin(), from.end());
+		};
+		const std::vector<Position> unreachable = MapTraversal::reduce<std::vector<Position>>(map, collect, merge, [](uint64_t done, uint64_t total) {
+			g_gui.SetLoadDone((unsigned int)(int64_t(done) * 100ll / std::max<int64_t>(total, 1)));
+		});
+
+		for (const Position &position : unreachable) {
+			map.setTile(position, nullptr, true);
+		}
 
 		g_gui.DestroyLoadBar();
 
 		wxString msg;
-		msg << removed << " tiles deleted.";
+		msg << unreachable.size() << " tiles deleted.";
 
 		g_gui.PopupDialog("Search completed", msg, wxOK);
 
-		g_gui.GetCurrentMap().doChange();
+		map.doChange();
 	}
 }
 
+void MainMenuBar::OnMapHighlightIsolatedAreas(wxCommandEvent &WXUNUSED(event)) {
+	if (!g_gui.IsEditorOpen()) {
+		return;
+	}
+
+	Map &map = g_gui.GetCurrentMap();
+	if (!IsItemChecked(MenuBar::MAP_HIGHLIGHT_ISOLATED_AREAS)) {
+		map.clearIsolatedAreas();
+		g_gui.RefreshView();
+		return;
+	}
+
+	if (map.towns.count() == 0) {
+		g_gui.PopupDialog("Highlight Isolated Areas", "The map has no towns, isolated areas are found by walking from the temples.", wxOK);
+		CheckItem(MenuBar::MAP_HIGHLIGHT_ISOLATED_AREAS, false);
+		return;
+	}
+
+	const size_t isolated = map.findIsolatedAreas();
+	g_gui.RefreshView();
+
+	wxString msg;
+	msg << isolated << " walkable tiles can't be reached from any temple.";
+	g_gui.SetStatusText(msg);
+}
+
 void MainMenuBar::OnMapRemoveEmptyMonsterSpawns(wxCommandEvent &WXUNUSED(event)) {
 	if (!g_gui.IsEditorOpen()) {
 		return;
@@ -1760,26 +1801,30 @@ void MainMenuBar::OnMapStatistics(wxCommandEvent &WXUNUSED(event)) {
 
 	int load_counter = 0;
 
-	uint64_t tile_count = 0;
-	uint64_t detailed_tile_count = 0;
-	uint64_t blocking_tile_count = 0;
-	uint64_t walkable_tile_count = 0;
+	// Filled by the worker threads, one per worker and then summed up
+	struct TileStatistics {
+		uint64_t tile_count = 0;
+		uint64_t detailed_tile_count = 0;
+		uint64_t blocking_tile_count = 0;
+		uint64_t walkable_tile_count = 0;
+		uint64_t spawn_monster_count = 0;
+		uint64_t spawn_npc_count = 0;
+		uint64_t monster_count = 0;
+		uint64_t npc_count = 0;
+
+		uint64_t item_count = 0;
+		uint64_t loose_item_count = 0;
+		uint64_t depot_count = 0;
+		uint64_t action_item_count = 0;
+		uint64_t unique_item_count = 0;
+		uint64_t container_count = 0; // Only includes containers containing more than 1 item
+	};
+
 	double percent_pathable = 0.0;
 	double percent_detailed = 0.0;
-	uint64_t spawn_monster_count = 0;
-	uint64_t spawn_npc_count = 0;
-	uint64_t monster_count = 0;
-	uint64_t npc_count = 0;
 	double monsters_per_spawn = 0.0;
 	double npcs_per_spawn = 0.0;
 
-	uint64_t item_count = 0;
-	uint64_t loose_item_count = 0;
-	uint64_t depot_count = 0;
-	uint64_t action_item_count = 0;
-	uint64_t unique_item_count = 0;
-	uint64_t container_count = 0; // Only includes containers containing more than 1 item
-
 	int town_count = map->towns.count();
 	int house_count = map->houses.count();
 	std::map<uint32_t, uint32_t> town_sqm_count;
@@ -1792,40 +1837,35 @@ void MainMenuBar::OnMapStatistics(wxCommandEvent &WXUNUSED(event)) {
 	double sqm_per_house = 0.0;
 	double sqm_per_town = 0.0;
 
-	for (MapIterator mit = map->begin(); mit != map->end(); ++mit) {
-		Tile* tile = (*mit)->get();
-		if (load_counter % 8192 == 0) {
-			g_gui.SetLoadDone((unsigned int)(int64_t(load_counter) * 95ll / int64_t(map->getTileCount())));
-		}
-
+	const auto analyze = [](const Tile* tile, TileStatistics &stats) {
 		if (tile->empty()) {
-			continue;
+			return;
 		}
 
-		tile_count += 1;
+		stats.tile_count += 1;
 
 		bool is_detailed = false;
 #define ANALYZE_ITEM(_item)                                             \
 	{                                                                   \
-		item_count += 1;                                                \
+		stats.item_count += 1;                                          \
 		if (!(_item)->isGroundTile() && !(_item)->isBorder()) {         \
 			is_detailed = true;                                         \
 			const ItemType &it = g_items.getItemType((_item)->getID()); \
 			if (it.moveable) {                                          \
-				loose_item_count += 1;                                  \
+				stats.loose_item_count += 1;                            \
 			}                                                           \
 			if (it.isDepot()) {                                         \
-				depot_count += 1;                                       \
+				stats.depot_count += 1;                                 \
 			}                                                           \
 			if ((_item)->getActionID() > 0) {                           \
-				action_item_count += 1;                                 \
+				stats.action_item_count += 1;                           \
 			}                                                           \
 			if ((_item)->getUniqueID() > 0) {                           \
-				unique_item_count += 1;                                 \
+				stats.unique_item_count += 1;                           \
 			}                                                           \
 			if (Container* c = dynamic_cast<Container*>((_item))) {     \
 				if (c->getVector().size()) {                            \
-					container_count += 1;                               \
+					stats.container_count += 1;                         \
 				}                                                       \
 			}                                                           \
 		}                                                               \
@@ -1834,39 +1874,74 @@ void MainMenuBar::OnMapStatistics(wxCommandEvent &WXUNUSED(event)) {
 			ANALYZE_ITEM(tile->ground);
 		}
 
-		for (Item* item : tile->items) {
-			ANALYZE_ITEM(item);
-		}
+		tile->items.forEach([&](Item &item) {
+			ANALYZE_ITEM(&item);
+		});
 #undef ANALYZE_ITEM
 
 		if (tile->spawnMonster) {
-			spawn_monster_count += 1;
+			stats.spawn_monster_count += 1;
 		}
 
 		if (tile->spawnNpc) {
-			spawn_npc_count += 1;
+			stats.spawn_npc_count += 1;
 		}
 
 		if (tile->monster) {
-			monster_count += 1;
+			stats.monster_count += 1;
 		}
 
 		if (tile->npc) {
-			npc_count += 1;
+			stats.npc_count += 1;
 		}
 
 		if (tile->isBlocking()) {
-			blocking_tile_count += 1;
+			stats.blocking_tile_count += 1;
 		} else {
-			walkable_tile_count += 1;
+			stats.walkable_tile_count += 1;
 		}
 
 		if (is_detailed) {
-			detailed_tile_count += 1;
+			stats.detailed_tile_count += 1;
 		}
+	};
 
-		load_counter += 1;
-	}
+	const auto merge = [](TileStatistics &into, const TileStatistics &from) {
+		into.tile_count += from.tile_count;
+		into.detailed_tile_count += from.detailed_tile_count;
+		into.blocking_tile_count += from.blocking_tile_count;
+		into.walkable_tile_count += from.walkable_tile_count;
+		into.spawn_monster_count += from.spawn_monster_count;
+		into.spawn_npc_count += from.spawn_npc_count;
+		into.monster_count += from.monster_count;
+		into.npc_count += from.npc_count;
+		into.item_count += from.item_count;
+		into.loose_item_count += from.loose_item_count;
+		into.depot_count += from.depot_count;
+		into.action_item_count += from.action_item_count;
+		into.unique_item_count += from.unique_item_count;
+		into.container_count += from.container_count;
+	};
+
+	const TileStatistics stats = MapTraversal::reduce<TileStatistics>(*map, analyze, merge, [](uint64_t done, uint64_t total) {
+		g_gui.SetLoadDone((unsigned int)(int64_t(done) * 95ll / std::max<int64_t>(total, 1)));
+	});
+
+	const uint64_t tile_count = stats.tile_count;
+	const uint64_t detailed_tile_count = stats.detailed_tile_count;
+	const uint64_t blocking_tile_count = stats.blocking_tile_count;
+	const uint64_t walkable_tile_count = stats.walkable_tile_count;
+	const uint64_t spawn_monster_count = stats.spawn_monster_count;
+	const uint64_t spawn_npc_count = stats.spawn_npc_count;
+	const uint64_t monster_count = stats.monster_count;
+	const uint64_t npc_count = stats.npc_count;
+
+	const uint64_t item_count = stats.item_count;
+	const uint64_t loose_item_count = stats.loose_item_count;
+	const uint64_t depot_count = stats.depot_count;
+	const uint64_t action_item_count = stats.action_item_count;
+	const uint64_t unique_item_count = stats.unique_item_count;
+	const uint64_t container_count = stats.container_count;
 
 	monsters_per_spawn = (spawn_monster_count != 0 ? double(monster_count) / double(spawn_monster_count) : -1.0);
 	npcs_per_spawn = (spawn_npc_count != 0 ? double(npc_count) / double(spawn_npc_count) : -1.0);
@@ -1910,6 +1985,8 @@ void MainMenuBar::OnMapStatistics(wxCommandEvent &WXUNUSED(event)) {
 		}
 	}
 
+	const auto floor_usage = map->getFloorUsage();
+
 	g_gui.DestroyLoadBar();
 
 	std::ostringstream os;
@@ -1970,6 +2047,16 @@ void MainMenuBar::OnMapStatistics(wxCommandEvent &WXUNUSED(event)) {
 		os << "\t\tLargest House: \"" << largest_house->name << "\" (" << largest_house_size << " sqm)\n";
 	}
 
+	os << "\tFloor storage:\n";
+	for (int z = 0; z < rme::MapLayers; ++z) {
+		const BaseMap::FloorUsage &usage = floor_usage[z];
+		if (usage.floors == 0) {
+			continue;
+		}
+		os << "\t\tFloor " << z << ": " << usage.floors << " blocks (" << usage.dense_floors << " dense), ";
+		os << usage.locations << " locations, " << usage.bytes / 1024 << " KB\n";
+	}
+
 	os << "\n";
 	os << "Generated by Remere's Map Editor version " + __RME_VERSION__ + "\n";
 
@@ -1997,6 +2084,30 @@ void MainMenuBar::OnMapStatistics(wxCommandEvent &WXUNUSED(event)) {
 	}
 }
 
+void MainMenuBar::OnMapMemoryReport(wxCommandEvent &WXUNUSED(event)) {
+	Editor* editor = g_gui.GetCurrentEditor();
+	if (!editor) {
+		return;
+	}
+
+	MemoryReport report;
+	report.addEditor(*editor);
+	report.addItemPools();
+	report.addGraphics(g_gui.gfx);
+
+	wxDialog* dg = newd wxDialog(frame, wxID_ANY, "Memory Report", wxDefaultPosition, wxDefaultSize, wxRESIZE_BORDER | wxCAPTION | wxCLOSE_BOX);
+	wxSizer* topsizer = newd wxBoxSizer(wxVERTICAL);
+	wxTextCtrl* text_field = newd wxTextCtrl(dg, wxID_ANY, wxstr(report.toString()), wxDefaultPosition, wxDefaultSize, wxTE_MULTILINE | wxTE_READONLY | wxTE_DONTWRAP);
+	text_field->SetFont(wxFont(wxFontInfo(9).Family(wxFONTFAMILY_TELETYPE)));
+	text_field->SetMinSize(wxSize(500, 400));
+	topsizer->Add(text_field, wxSizerFlags(5).Expand());
+	topsizer->Add(newd wxButton(dg, wxID_OK, "OK"), wxSizerFlags(1).Center());
+	dg->SetSizerAndFit(topsizer);
+	dg->Centre(wxBOTH);
+	dg->ShowModal();
+	dg->Destroy();
+}
+
 void MainMenuBar::OnMapCleanup(wxCommandEvent &WXUNUSED(event)) {
 	int ok = g_gui.PopupDialog("Clean map", "Do you want to remove all invalid items from the map?", wxYES | wxNO);
 
@@ -2356,6 +2467,10 @@ void MainMenuBar::SearchItems(bool unique, bool action, bool container, bool wri
 
 	const auto searchType = onSelection ? "selected area" : "map";
 
+	Map &map = g_gui.GetCurrentMap();
+	// The id registry only knows the blocks read so far
+	map.loadRemainingTiles();
+
 	g_gui.CreateLoadBar(wxString::Format("Searching on %s...", searchType));
 
 	OnSearchForStuff::Searcher searcher;
@@ -2364,7 +2479,34 @@ void MainMenuBar::SearchItems(bool unique, bool action, bool container, bool wri
 	searcher.search_container = container;
 	searcher.search_writeable = writable;
 
-	foreach_ItemOnMap(g_gui.GetCurrentMap(), searcher, onSelection);
+	if (!onSelection && !container && !writable) {
+		// Only the tiles the id registry points at can match
+		const ItemIdRegistry &ids = map.getItemIds();
+		std::vector<Position> positions;
+		const auto collect = [&](const std::vector<uint16_t> &idList, bool isUnique) {
+			for (uint16_t id : idList) {
+				const ItemIdRegistry::Positions &idPositions = isUnique ? ids.getUniqueIdPositions(id) : ids.getActionIdPositions(id);
+				positions.insert(positions.end(), idPositions.begin(), idPositions.end());
+			}
+		};
+		if (unique) {
+			collect(ids.getUniqueIds(), true);
+		}
+		if (action) {
+			collect(ids.getActionIds(), false);
+		}
+		std::sort(positions.begin(), positions.end());
+		positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+
+		long long done = 0;
+		for (const Position &position : positions) {
+			if (Tile* tile = map.getTile(position)) {
+				foreach_ItemOnTile(map, tile, searcher, ++done);
+			}
+		}
+	} else {
+		foreach_ItemOnMap(map, searcher, onSelection);
+	}
 	searcher.sort();
 	std::vector<std::pair<Tile*, Item*>> &found = searcher.found;
 
@@ -2406,7 +2548,7 @@ namespace SearchDuplicatedItems {
 	struct condition {
 		std::unordered_set<Tile*> foundTiles;
 
-		void operator()(Map &map, Tile* tile, Item* item, long long done) {
+		void operator()(Map &map, Tile* tile, const Item* item, long long done) {
 			if (done % 0x8000 == 0) {
 				g_gui.SetLoadDone((unsigned int)(100 * done / map.getTileCount()));
 			}
@@ -2425,12 +2567,13 @@ namespace SearchDuplicatedItems {
 
 			if (foundTiles.count(tile) == 0) {
 				std::unordered_set<int> itemIDs;
-				for (Item* existingItem : tile->items) {
-					if (itemIDs.count(existingItem->getID()) > 0 && !existingItem->hasElevation()) {
+				for (size_t index = 0; index < tile->items.size(); ++index) {
+					const uint16_t existingId = tile->items.getID(index);
+					if (itemIDs.count(existingId) > 0 && !g_items.hasFlag(existingId, ITEMTYPE_HAS_ELEVATION)) {
 						foundTiles.insert(tile);
 						break;
 					}
-					itemIDs.insert(existingItem->getID());
+					itemIDs.insert(existingId);
 				}
 			}
 		}
@@ -2444,6 +2587,10 @@ void MainMenuBar::SearchDuplicatedItems(bool onSelection /* = false*/) {
 
 	const auto searchType = onSelection ? "selected area" : "map";
 
+	Map &map = g_gui.GetCurrentMap();
+	// map.begin() would read the rest of a lazily opened map with no progress shown, read it behind a load bar first
+	map.loadRemainingTiles();
+
 	g_gui.CreateLoadBar(wxString::Format("Searching on %s...", searchType));
 
 	SearchDuplicatedItems::condition finder;
@@ -2492,13 +2639,14 @@ namespace RemoveDuplicatesItems {
 			}
 
 			std::unordered_set<int> itemIDsDuplicates;
-			for (const auto &itemInTile : tile->items) {
-				if (itemInTile && itemInTile->getID() == item->getID()) {
-					if (itemIDsDuplicates.count(itemInTile->getID()) > 0) {
+			for (size_t index = 0; index < tile->items.size(); ++index) {
+				const uint16_t idInTile = tile->items.getID(index);
+				if (idInTile == item->getID()) {
+					if (itemIDsDuplicates.count(idInTile) > 0) {
 						itemIDsDuplicates.clear();
 						return true;
 					}
-					itemIDsDuplicates.insert(itemInTile->getID());
+					itemIDsDuplicates.insert(idInTile);
 				}
 			}
 
@@ -2560,13 +2708,14 @@ namespace SearchWallsUponWalls {
 			}
 
 			std::unordered_set<int> itemIDs;
-			for (const Item* itemInTile : tile->items) {
-				if (!itemInTile || (!itemInTile->isWall() && !itemInTile->isDoor())) {
+			for (size_t index = 0; index < tile->items.size(); ++index) {
+				const uint16_t idInTile = tile->items.getID(index);
+				if (!g_items.hasFlag(idInTile, ITEMTYPE_WALL) && !g_items.hasFlag(idInTile, ITEMTYPE_DOOR)) {
 					continue;
 				}
 
-				if (item->getID() != itemInTile->getID()) {
-					itemIDs.insert(itemInTile->getID());
+				if (item->getID() != idInTile) {
+					itemIDs.insert(idInTile);
 				}
 			}
 
@@ -2586,6 +2735,10 @@ void MainMenuBar::SearchWallsUponWalls(bool onSelection /* = false*/) {
 
 	const auto searchType = onSelection ? "selected area" : "map";
 
+	Map &map = g_gui.GetCurrentMap();
+	// Same as in SearchDuplicatedItems
+	map.loadRemainingTiles();
+
 	g_gui.CreateLoadBar(wxString::Format("Searching on %s...", searchType));
 
 	SearchWallsUponWalls::condition finder;
@@ -84,11 +84,13 @@ namespace MenuBar {
 		MAP_REMOVE_ITEMS,
 		MAP_REMOVE_CORPSES,
 		MAP_REMOVE_UNREACHABLE_TILES,
+		MAP_HIGHLIGHT_ISOLATED_AREAS,
 		MAP_REMOVE_EMPTY_MONSTERS_SPAWNS,
 		MAP_REMOVE_EMPTY_NPCS_SPAWNS,
 		MAP_CLEAN_HOUSE_ITEMS,
 		MAP_PROPERTIES,
 		MAP_STATISTICS,
+		MAP_MEMORY_REPORT,
 		VIEW_TOOLBARS_BRUSHES,
 		VIEW_TOOLBARS_POSITION,
 		VIEW_TOOLBARS_SIZES,
@@ -231,6 +233,7 @@ public:
 	void OnMapRemoveItems(wxCommandEvent &event);
 	void OnMapRemoveCorpses(wxCommandEvent &event);
 	void OnMapRemoveUnreachable(wxCommandEvent &event);
+	void OnMapHighlightIsolatedAreas(wxCommandEvent &event);
 	void OnMapRemoveEmptyMonsterSpawns(wxCommandEvent &event);
 	void OnMapRemoveEmptyNpcSpawns(wxCommandEvent &event);
 	void OnClearHouseTiles(wxCommandEvent &event);
@@ -268,6 +271,7 @@ public:
 	void OnMapCleanup(wxCommandEvent &event);
 	void OnMapProperties(wxCommandEvent &event);
 	void OnMapStatistics(wxCommandEvent &event);
+	void OnMapMemoryReport(wxCommandEvent &event);
 
 	// View Menu
 	void OnToolbars(wxCommandEvent &event);
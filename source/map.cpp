@@ -20,6 +20,8 @@
 #include "gui.h" // loadbar
 
 #include "map.h"
+#include "map_traversal.h"
+#include "content_hash.h"
 
 Map::Map() :
 	BaseMap(),
@@ -27,6 +29,8 @@ Map::Map() :
 	height(512),
 	houses(*this),
 	has_changed(false),
+	saved_hash(0),
+	saved_hash_pending(false),
 	unnamed(false),
 	waypoints(*this),
 	zones(*this) {
@@ -60,7 +64,10 @@ bool Map::open(const std::string file) {
 		return false;
 	}
 
-	has_changed = false;
+	// A lazily opened map knows its saved state once all of it was read
+	if (!hasPendingTiles()) {
+		clearChanges();
+	}
 
 	wxFileName fn = wxstr(file);
 	filename = fn.GetFullPath().mb_str(wxConvUTF8);
@@ -140,33 +147,60 @@ bool Map::convert(MapVersion to, bool showdialog) {
 	return true;
 }
 
+// Load bar updates for the map wide passes
+static MapTraversal::Progress getLoadProgress(bool showdialog) {
+	if (!showdialog) {
+		return nullptr;
+	}
+	return [](uint64_t done, uint64_t total) {
+		g_gui.SetLoadDone(int(done / double(std::max<uint64_t>(total, 1)) * 100.0));
+	};
+}
+
 bool Map::convert(const ConversionMap &rm, bool showdialog) {
 	if (showdialog) {
 		g_gui.CreateLoadBar("Converting map ...");
 	}
 
-	uint64_t tiles_done = 0;
-	std::vector<uint16_t> id_list;
-
 	// std::ofstream conversions("converted_items.txt");
 
-	for (MapIterator miter = begin(); miter != end(); ++miter) {
-		Tile* tile = (*miter)->get();
-		ASSERT(tile);
+	// Only tiles holding an id the conversion mentions can change
+	std::vector<bool> converted_ids(0x10000);
+	for (const auto &[ids, replacement] : rm.mtm) {
+		for (uint16_t id : ids) {
+			converted_ids[id] = true;
+		}
+	}
+	for (const auto &[id, replacement] : rm.stm) {
+		converted_ids[id] = true;
+	}
+	const auto matchTile = [&converted_ids](const Tile* tile) {
+		if (tile->ground && converted_ids[tile->ground->getID()]) {
+			return true;
+		}
+		for (size_t index = 0; index < tile->items.size(); ++index) {
+			if (converted_ids[tile->items.getID(index)]) {
+				return true;
+			}
+		}
+		return false;
+	};
 
+	// Every tile is converted on its own, so the work is spread over the worker threads
+	const auto convertTile = [&](Tile* tile) {
 		if (tile->size() == 0) {
-			continue;
+			return;
 		}
 
 		// id_list try MTM conversion
-		id_list.clear();
+		std::vector<uint16_t> id_list;
 
 		if (tile->ground) {
 			id_list.push_back(tile->ground->getID());
 		}
-		for (ItemVector::const_iterator item_iter = tile->items.begin(); item_iter != tile->items.end(); ++item_iter) {
-			if ((*item_iter)->isBorder()) {
-				id_list.push_back((*item_iter)->getID());
+		for (size_t index = 0; index < tile->items.size(); ++index) {
+			if (tile->items.visit(index, [](const Item &item) { return item.isBorder(); })) {
+				id_list.push_back(tile->items.getID(index));
 			}
 		}
 
@@ -189,14 +223,12 @@ bool Map::convert(const ConversionMap &rm, bool showdialog) {
 			const std::vector<uint16_t> &v = cfmtm->first;
 
 			if (tile->ground && std::find(v.begin(), v.end(), tile->ground->getID()) != v.end()) {
-				delete tile->ground;
-				tile->ground = nullptr;
+				tile->setGround(nullptr);
 			}
 
-			for (ItemVector::iterator item_iter = tile->items.begin(); item_iter != tile->items.end();) {
-				if (std::find(v.begin(), v.end(), (*item_iter)->getID()) != v.end()) {
-					delete *item_iter;
-					item_iter = tile->items.erase(item_iter);
+			for (auto item_iter = tile->items.begin(); item_iter != tile->items.end();) {
+				if (std::find(v.begin(), v.end(), tile->items.getID(item_iter.getIndex())) != v.end()) {
+					item_iter = tile->destroyItem(item_iter);
 				} else {
 					++item_iter;
 				}
@@ -206,9 +238,9 @@ bool Map::convert(const ConversionMap &rm, bool showdialog) {
 			for (std::vector<uint16_t>::const_iterator iit = new_items.begin(); iit != new_items.end(); ++iit) {
 				Item* item = Item::Create(*iit);
 				if (item->isGroundTile()) {
-					tile->ground = item;
+					tile->setGround(item);
 				} else {
-					tile->items.insert(tile->items.begin(), item);
+					tile->insertItem(tile->items.begin(), item);
 					++inserted_items;
 				}
 			}
@@ -219,8 +251,7 @@ bool Map::convert(const ConversionMap &rm, bool showdialog) {
 			if (cfstm != rm.stm.end()) {
 				uint16_t aid = tile->ground->getActionID();
 				uint16_t uid = tile->ground->getUniqueID();
-				delete tile->ground;
-				tile->ground = nullptr;
+				tile->setGround(nullptr);
 
 				const std::vector<uint16_t> &v = cfstm->second;
 				// conversions << "Converted " << tile->getX() << ":" << tile->getY() << ":" << tile->getZ() << " " << id << " -> ";
@@ -232,7 +263,7 @@ bool Map::convert(const ConversionMap &rm, bool showdialog) {
 						item->setUniqueID(uid);
 						tile->addItem(item);
 					} else {
-						tile->items.insert(tile->items.begin(), item);
+						tile->insertItem(tile->items.begin(), item);
 						++inserted_items;
 					}
 				}
@@ -240,18 +271,16 @@ bool Map::convert(const ConversionMap &rm, bool showdialog) {
 			}
 		}
 
-		for (ItemVector::iterator replace_item_iter = tile->items.begin() + inserted_items; replace_item_iter != tile->items.end();) {
-			uint16_t id = (*replace_item_iter)->getID();
+		for (auto replace_item_iter = tile->items.begin() + inserted_items; replace_item_iter != tile->items.end();) {
+			uint16_t id = tile->items.getID(replace_item_iter.getIndex());
 			ConversionMap::STM::const_iterator cf = rm.stm.find(id);
 			if (cf != rm.stm.end()) {
 				// uint16_t aid = (*replace_item_iter)->getActionID();
 				// uint16_t uid = (*replace_item_iter)->getUniqueID();
-				delete *replace_item_iter;
-
-				replace_item_iter = tile->items.erase(replace_item_iter);
+				replace_item_iter = tile->destroyItem(replace_item_iter);
 				const std::vector<uint16_t> &v = cf->second;
 				for (std::vector<uint16_t>::const_iterator iit = v.begin(); iit != v.end(); ++iit) {
-					replace_item_iter = tile->items.insert(replace_item_iter, Item::Create(*iit));
+					replace_item_iter = tile->insertItem(replace_item_iter, Item::Create(*iit));
 					// conversions << "Converted " << tile->getX() << ":" << tile->getY() << ":" << tile->getZ() << " " << id << " -> " << *iit << std::endl;
 					++replace_item_iter;
 				}
@@ -259,12 +288,8 @@ bool Map::convert(const ConversionMap &rm, bool showdialog) {
 				++replace_item_iter;
 			}
 		}
-
-		++tiles_done;
-		if (showdialog && tiles_done % 0x10000 == 0) {
-			g_gui.SetLoadDone(int(tiles_done / double(getTileCount()) * 100.0));
-		}
-	}
+	};
+	editTiles(matchTile, convertTile, getLoadProgress(showdialog));
 
 	if (showdialog) {
 		g_gui.DestroyLoadBar();
@@ -278,30 +303,24 @@ void Map::cleanInvalidTiles(bool showdialog) {
 		g_gui.CreateLoadBar("Removing invalid tiles...");
 	}
 
-	uint64_t tiles_done = 0;
-
-	for (MapIterator miter = begin(); miter != end(); ++miter) {
-		Tile* tile = (*miter)->get();
-		ASSERT(tile);
-
-		if (tile->size() == 0) {
-			continue;
+	const auto matchTile = [](const Tile* tile) {
+		for (size_t index = 0; index < tile->items.size(); ++index) {
+			if (!g_items.isValidID(tile->items.getID(index))) {
+				return true;
+			}
 		}
-
-		for (ItemVector::iterator item_iter = tile->items.begin(); item_iter != tile->items.end();) {
-			if (g_items.isValidID((*item_iter)->getID())) {
+		return false;
+	};
+	const auto cleanTile = [](Tile* tile) {
+		for (auto item_iter = tile->items.begin(); item_iter != tile->items.end();) {
+			if (g_items.isValidID(tile->items.getID(item_iter.getIndex()))) {
 				++item_iter;
 			} else {
-				delete *item_iter;
-				item_iter = tile->items.erase(item_iter);
+				item_iter = tile->destroyItem(item_iter);
 			}
 		}
-
-		++tiles_done;
-		if (showdialog && tiles_done % 0x10000 == 0) {
-			g_gui.SetLoadDone(int(tiles_done / double(getTileCount()) * 100.0));
-		}
-	}
+	};
+	editTiles(matchTile, cleanTile, getLoadProgress(showdialog));
 
 	if (showdialog) {
 		g_gui.DestroyLoadBar();
@@ -313,28 +332,21 @@ void Map::cleanDeletedZones(bool showdialog) {
 		g_gui.CreateLoadBar("Removing deleted zones...");
 	}
 
-	uint64_t tiles_done = 0;
-
-	for (MapIterator miter = begin(); miter != end(); ++miter) {
-		Tile* tile = (*miter)->get();
-		ASSERT(tile);
-
-		if (tile->size() == 0) {
+	// Only the tiles of the deleted zones are visited, the zone index keeps their positions
+	loadRemainingTiles();
+	for (const unsigned int zoneId : zone_index.getZoneIds()) {
+		if (zones.hasZone(zoneId)) {
 			continue;
 		}
 
-		for (auto iter = tile->zones.begin(); iter != tile->zones.end();) {
-			if (zones.hasZone(*iter)) {
-				++iter;
-			} else {
-				iter = tile->zones.erase(iter);
+		for (const Position &position : zone_index.getPositions(zoneId)) {
+			if (Tile* tile = getTile(position)) {
+				beforeTileChange(tile);
+				tile->removeZone(zoneId);
+				tileChanged(tile);
 			}
 		}
-
-		++tiles_done;
-		if (showdialog && tiles_done % 0x10000 == 0) {
-			g_gui.SetLoadDone(int(tiles_done / double(getTileCount()) * 100.0));
-		}
+		zone_index.eraseZone(zoneId);
 	}
 
 	if (showdialog) {
@@ -343,35 +355,80 @@ void Map::cleanDeletedZones(bool showdialog) {
 }
 
 Position Map::getZonePosition(unsigned int zoneId) {
-	Position pos;
-	for (MapIterator miter = begin(); miter != end(); ++miter) {
-		Tile* tile = (*miter)->get();
-		ASSERT(tile);
-
-		if (tile->size() == 0) {
-			continue;
-		}
-
-		if (tile->zones.find(zoneId) != tile->zones.end()) {
-			pos = tile->getPosition();
-			break;
+	loadRemainingTiles();
+	for (const Position &position : zone_index.getPositions(zoneId)) {
+		const Tile* tile = getTile(position);
+		if (tile && tile->size() != 0) {
+			return position;
 		}
 	}
-	return pos;
+	return Position();
 }
 
-bool Map::doChange() {
+bool Map::doChange(bool undoable /* = false*/) {
 	bool doupdate = !has_changed;
 	has_changed = true;
+	if (!undoable) {
+		saved_hash = 0;
+		saved_hash_pending = false;
+	}
 	return doupdate;
 }
 
 bool Map::clearChanges() {
 	bool doupdate = has_changed;
 	has_changed = false;
+	// Hashing the whole map here would stall every open and save
+	saved_hash = 0;
+	saved_hash_pending = true;
 	return doupdate;
 }
 
+void Map::updateSavedState() {
+	// Once the map was edited it is too late to hash what was saved
+	if (!saved_hash_pending || has_changed || hasPendingTiles()) {
+		return;
+	}
+	saved_hash = getStateHash();
+	saved_hash_pending = false;
+}
+
+bool Map::matchesSavedState() {
+	return saved_hash != 0 && getStateHash() == saved_hash;
+}
+
+uint64_t Map::getStateHash() {
+	ContentHash hash;
+	hash.add(getContentHash());
+	hash.add(description);
+	hash.add(width);
+	hash.add(height);
+	for (const auto &[id, town] : towns) {
+		const Position &temple = town->getTemplePosition();
+		hash.add(id);
+		hash.add(town->getName());
+		hash.add((uint64_t(temple.x) << 24) | (uint64_t(temple.y) << 8) | temple.z);
+	}
+	for (const auto &[id, house] : houses) {
+		const Position &exit = house->getExit();
+		hash.add(id);
+		hash.add(house->name);
+		hash.add(house->rent);
+		hash.add(house->townid);
+		hash.add(house->guildhall);
+		hash.add((uint64_t(exit.x) << 24) | (uint64_t(exit.y) << 8) | exit.z);
+	}
+	for (const auto &[name, waypoint] : waypoints) {
+		hash.add(name);
+		hash.add((uint64_t(waypoint->pos.x) << 24) | (uint64_t(waypoint->pos.y) << 8) | waypoint->pos.z);
+	}
+	for (const auto &[name, id] : zones) {
+		hash.add(name);
+		hash.add(id);
+	}
+	return hash.get();
+}
+
 void Map::setWidth(int new_width) {
 	if (new_width > 65000) {
 		width = 65000;
@@ -469,70 +526,34 @@ SpawnMonsterList Map::getSpawnMonsterList(const Tile* tile) const {
 		return list;
 	}
 
-	const TileLocation* location = tile->getLocation();
-	if (!location || location->getSpawnMonsterCount() == 0) {
-		return list;
+	for (const SpawnIndex::Area &area : spawnsMonster.getCovering(tile->getPosition())) {
+		const Tile* centerTile = getTile(area.center);
+		if (centerTile && centerTile->spawnMonster) {
+			list.push_back(centerTile->spawnMonster);
+		}
 	}
+	return list;
+}
 
-	uint32_t found = 0;
-	if (tile->spawnMonster) {
-		++found;
-		list.push_back(tile->spawnMonster);
+std::vector<Tile*> Map::getSpawnMonsterCreatures(const Position &center) {
+	std::vector<Tile*> tiles;
+	const int radius = spawnsMonster.getRadius(center);
+	if (radius < 0) {
+		return tiles;
 	}
 
-	// Scans the border tiles in an expanding square around the original spawn
-	const Position &position = tile->getPosition();
-	int start_x = position.x - 1;
-	int end_x = position.x + 1;
-	int start_y = position.y - 1;
-	int end_y = position.y + 1;
-
-	while (found != location->getSpawnMonsterCount()) {
-		for (int x = start_x; x <= end_x; ++x) {
-			const Tile* start_tile = getTile(x, start_y, position.z);
-			if (start_tile && start_tile->spawnMonster) {
-				list.push_back(start_tile->spawnMonster);
-				++found;
-			}
-
-			const Tile* end_tile = getTile(x, end_y, position.z);
-			if (end_tile && end_tile->spawnMonster) {
-				list.push_back(end_tile->spawnMonster);
-				++found;
-			}
-		}
-
-		for (int y = start_y + 1; y < end_y; ++y) {
-			const Tile* start_tile = getTile(start_x, y, position.z);
-			if (start_tile && start_tile->spawnMonster) {
-				list.push_back(start_tile->spawnMonster);
-				++found;
-			}
-			const Tile* end_tile = getTile(end_x, y, position.z);
-			if (end_tile && end_tile->spawnMonster) {
-				list.push_back(end_tile->spawnMonster);
-				++found;
-			}
+	visitRegion(center - Position(radius, radius, 0), center + Position(radius, radius, 0), [&](Tile* tile) {
+		if (tile->monster) {
+			tiles.push_back(tile);
 		}
-
-		for (int y = start_y + 1; y < end_y; ++y) {
-			const Tile* start_tile = getTile(start_x, y, position.z);
-			if (start_tile && start_tile->spawnMonster) {
-				list.push_back(start_tile->spawnMonster);
-				++found;
-			}
-			const Tile* end_tile = getTile(end_x, y, position.z);
-			if (end_tile && end_tile->spawnMonster) {
-				list.push_back(end_tile->spawnMonster);
-				++found;
-			}
+	});
+	std::sort(tiles.begin(), tiles.end(), [](const Tile* a, const Tile* b) {
+		if (a->getY() != b->getY()) {
+			return a->getY() < b->getY();
 		}
-		--start_x;
-		--start_y;
-		++end_x;
-		++end_y;
-	}
-	return list;
+		return a->getX() < b->getX();
+	});
+	return tiles;
 }
 
 SpawnMonsterList Map::getSpawnMonsterList(const Position &position) const {
@@ -599,57 +620,34 @@ SpawnNpcList Map::getSpawnNpcList(const Tile* tile) const {
 		return listNpc;
 	}
 
-	const TileLocation* location = tile->getLocation();
-	if (!location || location->getSpawnNpcCount() == 0) {
-		return listNpc;
+	for (const SpawnIndex::Area &area : spawnsNpc.getCovering(tile->getPosition())) {
+		const Tile* centerTile = getTile(area.center);
+		if (centerTile && centerTile->spawnNpc) {
+			listNpc.push_back(centerTile->spawnNpc);
+		}
 	}
+	return listNpc;
+}
 
-	uint32_t found = 0;
-	if (tile->spawnNpc) {
-		++found;
-		listNpc.push_back(tile->spawnNpc);
+std::vector<Tile*> Map::getSpawnNpcCreatures(const Position &center) {
+	std::vector<Tile*> tiles;
+	const int radius = spawnsNpc.getRadius(center);
+	if (radius < 0) {
+		return tiles;
 	}
 
-	// Scans the border tiles in an expanding square around the original spawn
-	const Position &position = tile->getPosition();
-	int start_x = position.x - 1;
-	int end_x = position.x + 1;
-	int start_y = position.y - 1;
-	int end_y = position.y + 1;
-
-	while (found != location->getSpawnNpcCount()) {
-		for (int x = start_x; x <= end_x; ++x) {
-			const Tile* start_tile = getTile(x, start_y, position.z);
-			if (start_tile && start_tile->spawnNpc) {
-				listNpc.push_back(start_tile->spawnNpc);
-				++found;
-			}
-
-			const Tile* end_tile = getTile(x, end_y, position.z);
-			if (end_tile && end_tile->spawnNpc) {
-				listNpc.push_back(end_tile->spawnNpc);
-				++found;
-			}
+	visitRegion(center - Position(radius, radius, 0), center + Position(radius, radius, 0), [&](Tile* tile) {
+		if (tile->npc) {
+			tiles.push_back(tile);
 		}
-
-		for (int y = start_y + 1; y < end_y; ++y) {
-			const Tile* start_tile = getTile(start_x, y, position.z);
-			if (start_tile && start_tile->spawnNpc) {
-				listNpc.push_back(start_tile->spawnNpc);
-				++found;
-			}
-			const Tile* end_tile = getTile(end_x, y, position.z);
-			if (end_tile && end_tile->spawnNpc) {
-				listNpc.push_back(end_tile->spawnNpc);
-				++found;
-			}
+	});
+	std::sort(tiles.begin(), tiles.end(), [](const Tile* a, const Tile* b) {
+		if (a->getY() != b->getY()) {
+			return a->getY() < b->getY();
 		}
-		--start_x;
-		--start_y;
-		++end_x;
-		++end_y;
-	}
-	return listNpc;
+		return a->getX() < b->getX();
+	});
+	return tiles;
 }
 
 SpawnNpcList Map::getSpawnNpcList(const Position &position) const {
@@ -725,9 +723,9 @@ bool Map::exportMinimap(FileName filename, int floor /*= rme::MapGroundLayer*/,
 			uint32_t pixelpos = (tile->getY() - min_y) * minimap_width + (tile->getX() - min_x);
 			uint8_t &pixel = pic[pixelpos];
 
-			for (ItemVector::const_reverse_iterator item_iter = tile->items.rbegin(); item_iter != tile->items.rend(); ++item_iter) {
-				if ((*item_iter)->getMiniMapColor()) {
-					pixel = (*item_iter)->getMiniMapColor();
+			for (size_t index = tile->items.size(); index-- > 0;) {
+				if (uint8_t color = g_items.getMiniMapColor(tile->items.getID(index))) {
+					pixel = color;
 					break;
 				}
 			}
@@ -820,63 +818,156 @@ bool Map::exportMinimap(FileName filename, int floor /*= rme::MapGroundLayer*/,
 	return true;
 }
 
-void Map::updateUniqueIds(Tile* old_tile, Tile* new_tile) {
-	if (old_tile && old_tile->hasUniqueItem()) {
-		if (old_tile->ground) {
-			uint16_t uid = old_tile->ground->getUniqueID();
-			if (uid != 0) {
-				removeUniqueId(uid);
+void Map::updateTileIndexes(Tile* old_tile, Tile* new_tile) {
+	// Both may be set, they share the position
+	const Position &position = new_tile ? new_tile->getPosition() : old_tile->getPosition();
+	if (old_tile) {
+		item_ids.removeTile(old_tile);
+		item_index.removeTile(old_tile);
+		zone_index.removeTile(old_tile);
+		if (old_tile->isHouseTile()) {
+			if (House* house = houses.getHouse(old_tile->getHouseID())) {
+				house->updateTile(position, new_tile);
 			}
 		}
-		for (const Item* item : old_tile->items) {
-			if (item) {
-				uint16_t uid = item->getUniqueID();
-				if (uid != 0) {
-					removeUniqueId(uid);
-				}
+	}
+	if (new_tile) {
+		item_ids.addTile(new_tile);
+		item_index.addTile(new_tile);
+		zone_index.addTile(new_tile);
+		if (new_tile->isHouseTile() && (!old_tile || old_tile->getHouseID() != new_tile->getHouseID())) {
+			if (House* house = houses.getHouse(new_tile->getHouseID())) {
+				house->updateTile(position, new_tile);
 			}
 		}
 	}
 
-	if (new_tile && new_tile->hasUniqueItem()) {
-		if (new_tile->ground) {
-			uint16_t uid = new_tile->ground->getUniqueID();
-			if (uid != 0) {
-				addUniqueId(uid);
-			}
+	walkability.updateTile(position, new_tile);
+	if (isolated_areas && !walkability.isWalkable(position)) {
+		isolated_areas->set(position, false);
+	}
+}
+
+void Map::beforeTileChange(Tile* tile) {
+	item_ids.removeTile(tile);
+	item_index.removeTile(tile);
+	zone_index.removeTile(tile);
+	if (tile->isHouseTile()) {
+		if (House* house = houses.getHouse(tile->getHouseID())) {
+			house->updateTile(tile->getPosition(), nullptr);
 		}
-		for (const Item* item : new_tile->items) {
-			if (item) {
-				uint16_t uid = item->getUniqueID();
-				if (uid != 0) {
-					addUniqueId(uid);
-				}
-			}
+	}
+}
+
+void Map::tileChanged(Tile* tile) {
+	item_ids.addTile(tile);
+	item_index.addTile(tile);
+	zone_index.addTile(tile);
+	if (tile->isHouseTile()) {
+		if (House* house = houses.getHouse(tile->getHouseID())) {
+			house->updateTile(tile->getPosition(), tile);
+		}
+	}
+
+	const Position &position = tile->getPosition();
+	walkability.updateTile(position, tile);
+	if (isolated_areas && !walkability.isWalkable(position)) {
+		isolated_areas->set(position, false);
+	}
+	invalidateContentHash(position);
+}
+
+void Map::editTiles(const std::function<bool(const Tile*)> &match, const std::function<void(Tile*)> &edit, const MapTraversal::Progress &progress) {
+	// Finding the tiles is the part that walks the whole map, most passes only change a few of them
+	const auto visit = [&match](const Tile* tile, std::vector<Position> &found) {
+		if (match(tile)) {
+			found.push_back(tile->getPosition());
+		}
+	};
+	const auto merge = [](std::vector<Position> &into, const std::vector<Position> &from) {
+		into.insert(into.end(), from.begin(), from.end());
+	};
+	const std::vector<Position> found = MapTraversal::reduce<std::vector<Position>>(*this, visit, merge, progress);
+
+	std::vector<Tile*> tiles;
+	tiles.reserve(found.size());
+	for (const Position &position : found) {
+		Tile* tile = getTile(position);
+		beforeTileChange(tile);
+		tiles.push_back(tile);
+	}
+	g_workers.run(tiles.size(), [&tiles, &edit](size_t index, size_t) {
+		edit(tiles[index]);
+	});
+	for (Tile* tile : tiles) {
+		tileChanged(tile);
+	}
+}
+
+void Map::loadRemainingTiles() {
+	if (!hasPendingTiles()) {
+		return;
+	}
+
+	// Under a load bar that is already up the blocks are read without one of their own
+	const bool showdialog = !g_gui.HasLoadBar();
+	if (showdialog) {
+		g_gui.CreateLoadBar("Loading the rest of the map...");
+	}
+
+	// Blocks read between load bar updates
+	const size_t step = 64;
+	const size_t total = pending_tiles->getPendingCount();
+	while (loadPendingTiles(step)) {
+		if (showdialog) {
+			g_gui.SetLoadDone(int((total - pending_tiles->getPendingCount()) / double(total) * 100.0));
 		}
 	}
+
+	if (showdialog) {
+		g_gui.DestroyLoadBar();
+	}
 }
 
-void Map::addUniqueId(uint16_t uid) {
-	auto it = std::find(uniqueIds.begin(), uniqueIds.end(), uid);
-	if (it == uniqueIds.end()) {
-		uniqueIds.push_back(uid);
+const ItemIndex* Map::getItemIndex() {
+	const uint64_t budget = uint64_t(g_settings.getInteger(Config::ITEM_INDEX_MEM_SIZE)) * 1024 * 1024;
+	if (budget == 0) {
+		item_index.clear();
+		return nullptr;
+	}
+
+	if (!item_index.isBuilt()) {
+		// Don't rebuild over and over for a budget that was already too small
+		if (item_index.isExhausted() && budget <= item_index.getBudget()) {
+			return nullptr;
+		}
+		loadRemainingTiles();
+		item_index.build(*this, budget);
 	}
+	return item_index.isBuilt() ? &item_index : nullptr;
 }
 
-void Map::removeUniqueId(uint16_t uid) {
-	auto it = std::find(uniqueIds.begin(), uniqueIds.end(), uid);
-	if (it != uniqueIds.end()) {
-		uniqueIds.erase(it);
+size_t Map::findIsolatedAreas() {
+	loadRemainingTiles();
+	std::vector<Position> temples;
+	for (const auto &[id, town] : towns) {
+		temples.push_back(town->getTemplePosition());
 	}
+
+	isolated_areas = std::make_unique<TileBitmap>(walkability.findIsolated(temples));
+	return isolated_areas->count();
+}
+
+void Map::clearIsolatedAreas() {
+	isolated_areas.reset();
 }
 
-bool Map::hasUniqueId(uint16_t uid) const {
-	if (uid < rme::MinUniqueId || uniqueIds.empty()) {
+bool Map::hasUniqueId(uint16_t uid) {
+	if (uid < rme::MinUniqueId) {
 		return false;
 	}
-
-	auto it = std::find(uniqueIds.begin(), uniqueIds.end(), uid);
-	return it != uniqueIds.end();
+	loadRemainingTiles();
+	return item_ids.hasUniqueId(uid);
 }
 
 int64_t RemoveMonstersOnMap(Map &map, bool selectedOnly) {
@@ -896,6 +987,7 @@ int64_t RemoveMonstersOnMap(Map &map, bool selectedOnly) {
 		if (tile->monster) {
 			delete tile->monster;
 			tile->monster = nullptr;
+			map.invalidateContentHash(tile->getPosition());
 			++removed;
 		}
 
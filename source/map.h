@@ -19,6 +19,7 @@
 #define RME_MAP_H_
 
 #include "basemap.h"
+#include "map_traversal.h"
 #include "tile.h"
 #include "town.h"
 #include "house.h"
@@ -28,6 +29,10 @@
 #include "zones.h"
 #include "templates.h"
 #include "spawn_npc.h"
+#include "item_id_registry.h"
+#include "item_index.h"
+#include "zone_index.h"
+#include "walkability.h"
 
 class Map : public BaseMap {
 public:
@@ -55,9 +60,14 @@ public:
 		return has_changed;
 	}
 	// Makes a change, doesn't matter what. Just so that it asks when saving (Also adds a * to the window title)
-	bool doChange();
-	// Clears any changes
+	// Changes made outside the action queue can't be undone, so they forget the saved state
+	bool doChange(bool undoable = false);
+	// Clears any changes, the saved state is hashed later by updateSavedState
 	bool clearChanges();
+	// Hashes the saved state if it is due, before the next edit or when idle
+	void updateSavedState();
+	// True when the map holds what was last opened or saved, e.g. after undoing every edit
+	bool matchesSavedState();
 
 	// Errors/warnings
 	bool hasWarnings() const {
@@ -84,6 +94,8 @@ public:
 	SpawnMonsterList getSpawnMonsterList(const Tile* tile) const;
 	SpawnMonsterList getSpawnMonsterList(const Position &position) const;
 	SpawnMonsterList getSpawnMonsterList(int x, int y, int z) const;
+	// Tiles holding a monster inside the spawn centred there, row by row
+	std::vector<Tile*> getSpawnMonsterCreatures(const Position &center);
 
 	// Mess with npc spawns
 	bool addSpawnNpc(Tile* spawnMonster);
@@ -96,6 +108,8 @@ public:
 	SpawnNpcList getSpawnNpcList(const Tile* tile) const;
 	SpawnNpcList getSpawnNpcList(const Position &position) const;
 	SpawnNpcList getSpawnNpcList(int x, int y, int z) const;
+	// Tiles holding an npc inside the spawn centred there, row by row
+	std::vector<Tile*> getSpawnNpcCreatures(const Position &center);
 
 	// Returns true if the map has been saved
 	// ie. it knows which file it should be saved to
@@ -148,7 +162,40 @@ public:
 		unnamed = false;
 	}
 
-	bool hasUniqueId(uint16_t uid) const;
+	// Tiles edited in place instead of through setTile: call beforeTileChange while the tile still
+	// holds what the indexes know about it, and tileChanged once the edit is done
+	void beforeTileChange(Tile* tile);
+	void tileChanged(Tile* tile);
+
+	// Reads what a lazily opened map still has pending behind a load bar, before a query of a
+	// whole map index. Until then the indexes only know the blocks read so far.
+	void loadRemainingTiles();
+
+	bool hasUniqueId(uint16_t uid);
+	// Call loadRemainingTiles first for the whole map
+	const ItemIdRegistry &getItemIds() const noexcept {
+		return item_ids;
+	}
+	// Where each item id is, built on first use. nullptr when the index is turned off
+	// or doesn't fit its memory budget, callers walk the map instead.
+	const ItemIndex* getItemIndex();
+	uint64_t getItemIndexMemsize() const noexcept {
+		return item_index.memsize();
+	}
+	const ZoneIndex &getZoneIndex() const noexcept {
+		return zone_index;
+	}
+	const WalkabilityMap &getWalkability() const noexcept {
+		return walkability;
+	}
+
+	// Walkable tiles that can't be walked to from any temple, highlighted by the drawer until cleared.
+	// Found once, later edits only take out the tiles that stop being walkable. Returns their count
+	size_t findIsolatedAreas();
+	void clearIsolatedAreas();
+	const TileBitmap* getIsolatedAreas() const noexcept {
+		return isolated_areas.get();
+	}
 
 protected:
 	// Loads a map
@@ -182,25 +229,116 @@ public:
 	SpawnsNpc spawnsNpc;
 
 protected:
-	void updateUniqueIds(Tile* old_tile, Tile* new_tile) override;
-	void addUniqueId(uint16_t uid);
-	void removeUniqueId(uint16_t uid);
+	void updateTileIndexes(Tile* old_tile, Tile* new_tile) override;
+	// Runs edit on the worker threads for the tiles match picks out of a parallel walk of the map,
+	// the tile indexes are only updated for those tiles
+	void editTiles(const std::function<bool(const Tile*)> &match, const std::function<void(Tile*)> &edit, const MapTraversal::Progress &progress);
+	// Content hash of the tiles combined with the towns, houses, waypoints and zones
+	uint64_t getStateHash();
 
 	bool has_changed; // If the map has changed
+	uint64_t saved_hash; // State hash when last opened or saved, 0 if unknown
+	bool saved_hash_pending; // If saved_hash is still to be computed for the unchanged map
 	bool unnamed; // If the map has yet to receive a name
 
 	friend class IOMapOTBM;
 	friend class IOMapOTMM;
 	friend class Editor;
+	friend class MemoryReport;
 
 public:
 	Waypoints waypoints;
 	Zones zones;
 
 private:
-	std::vector<uint16_t> uniqueIds;
+	ItemIdRegistry item_ids;
+	ItemIndex item_index;
+	ZoneIndex zone_index;
+	WalkabilityMap walkability;
+	std::unique_ptr<TileBitmap> isolated_areas;
 };
 
+// A callback may have a wants(map, tile, const Item&, done) that reads an item first,
+// it is then only called for the items wants accepts
+template <typename ForeachType>
+inline bool foreach_WantsItem(ForeachType &foreach, Map &map, Tile* tile, const Item &item, long long done) {
+	if constexpr (requires { foreach.wants(map, tile, item, done); }) {
+		return foreach.wants(map, tile, item, done);
+	} else {
+		return true;
+	}
+}
+
+// The items inside container and the containers inside it, breadth first
+template <typename ForeachType, typename ContainerType>
+inline void foreach_ItemInContainer(Map &map, Tile* tile, ContainerType* container, ForeachType &foreach, long long done) {
+	std::queue<ContainerType*> containers;
+	containers.push(container);
+	do {
+		container = containers.front();
+		for (auto* i : container->getVector()) {
+			if (foreach_WantsItem(foreach, map, tile, *i, done)) {
+				foreach (map, tile, i, done)
+					;
+			}
+			if (ContainerType* c = dynamic_cast<ContainerType*>(i)) {
+				containers.push(c);
+			}
+		}
+		containers.pop();
+	} while (containers.size());
+}
+
+// Callbacks taking a const Item* only read, they get the items where they lie (see TileItems::visit)
+// and must not keep hold of them. The others may keep or change the items they are handed, so
+// records and shared items on the tile are turned into items of the tile's own on the way, for the
+// items their wants accepts and for containers. Callers that only want one id pass it as itemId,
+// the other items are skipped unless they are containers.
+template <typename ForeachType>
+inline void foreach_ItemOnTile(Map &map, Tile* tile, ForeachType &foreach, long long done, uint16_t itemId = 0) {
+	if (tile->ground && foreach_WantsItem(foreach, map, tile, *tile->ground, done)) {
+		foreach (map, tile, tile->ground, done)
+			;
+	}
+
+	const auto skip = [itemId](const Item &item) {
+		return itemId != 0 && item.getID() != itemId && !dynamic_cast<const Container*>(&item);
+	};
+	for (size_t index = 0; index < tile->items.size(); ++index) {
+		if constexpr (std::is_invocable_v<ForeachType &, Map &, Tile*, const Item*, long long>) {
+			tile->items.visit(index, [&](const Item &item) {
+				if (skip(item)) {
+					return;
+				}
+				foreach (map, tile, &item, done)
+					;
+				if (const Container* container = dynamic_cast<const Container*>(&item)) {
+					foreach_ItemInContainer(map, tile, container, foreach, done);
+				}
+			});
+		} else {
+			bool wanted = false;
+			bool container = false;
+			tile->items.visit(index, [&](const Item &item) {
+				container = dynamic_cast<const Container*>(&item) != nullptr;
+				wanted = !skip(item) && foreach_WantsItem(foreach, map, tile, item, done);
+			});
+			if (!wanted && !container) {
+				continue;
+			}
+
+			Item* item = tile->items[index];
+			if (wanted) {
+				foreach (map, tile, item, done)
+					;
+			}
+			if (Container* c = dynamic_cast<Container*>(item)) {
+				foreach_ItemInContainer(map, tile, c, foreach, done);
+			}
+		}
+	}
+}
+
 template <typename ForeachType>
 inline void foreach_ItemOnMap(Map &map, ForeachType &foreach, bool selectedTiles) {
 	MapIterator tileiter = map.begin();
@@ -210,43 +348,34 @@ inline void foreach_ItemOnMap(Map &map, ForeachType &foreach, bool selectedTiles
 	while (tileiter != end) {
 		++done;
 		Tile* tile = (*tileiter)->get();
-		if (selectedTiles && !tile->isSelected()) {
-			++tileiter;
-			continue;
+		if (!selectedTiles || tile->isSelected()) {
+			foreach_ItemOnTile(map, tile, foreach, done);
 		}
+		++tileiter;
+	}
+}
 
-		if (tile->ground) {
-			foreach (map, tile, tile->ground, done)
-				;
-		}
+// Same as foreach_ItemOnMap for callers that only want one item id,
+// only the tiles the item index lists for it are visited when the index is available
+template <typename ForeachType>
+inline void foreach_ItemWithIdOnMap(Map &map, uint16_t itemId, ForeachType &foreach, bool selectedTiles) {
+	const ItemIndex* index = map.getItemIndex();
+	if (!index) {
+		foreach_ItemOnMap(map, foreach, selectedTiles);
+		return;
+	}
 
-		std::queue<Container*> containers;
-		for (ItemVector::iterator itemiter = tile->items.begin(); itemiter != tile->items.end(); ++itemiter) {
-			Item* item = *itemiter;
-			Container* container = dynamic_cast<Container*>(item);
-			foreach (map, tile, item, done)
-				;
-			if (container) {
-				containers.push(container);
-
-				do {
-					container = containers.front();
-					ItemVector &v = container->getVector();
-					for (ItemVector::iterator containeriter = v.begin(); containeriter != v.end(); ++containeriter) {
-						Item* i = *containeriter;
-						Container* c = dynamic_cast<Container*>(i);
-						foreach (map, tile, i, done)
-							;
-						if (c) {
-							containers.push(c);
-						}
-					}
-					containers.pop();
-				} while (containers.size());
+	long long done = 0;
+	index->forEachLeaf(itemId, [&](int leaf_x, int leaf_y, int z) {
+		for (int y = leaf_y; y < leaf_y + MapLeaf::Size; ++y) {
+			for (int x = leaf_x; x < leaf_x + MapLeaf::Size; ++x) {
+				Tile* tile = map.getTile(x, y, z);
+				if (tile && (!selectedTiles || tile->isSelected())) {
+					foreach_ItemOnTile(map, tile, foreach, ++done, itemId);
+				}
 			}
 		}
-		++tileiter;
-	}
+	});
 }
 
 template <typename ForeachType>
@@ -298,24 +427,38 @@ inline int64_t RemoveItemOnMap(Map &map, RemoveIfType &condition, bool selectedO
 			continue;
 		}
 
+		bool changed = false;
 		if (tile->ground) {
 			if (condition(map, tile->ground, removed, done)) {
-				delete tile->ground;
-				tile->ground = nullptr;
+				map.beforeTileChange(tile);
+				changed = true;
+				tile->setGround(nullptr);
 				++removed;
 			}
 		}
 
 		for (auto iit = tile->items.begin(); iit != tile->items.end();) {
-			Item* item = *iit;
-			if (condition(map, item, removed, done)) {
-				iit = tile->items.erase(iit);
-				delete item;
+			// The condition only reads the item, records are handed to it as a stand-in
+			const bool remove = tile->items.visit(iit.getIndex(), [&](Item &item) {
+				return condition(map, &item, removed, done);
+			});
+			if (remove) {
+				if (!changed) {
+					map.beforeTileChange(tile);
+					changed = true;
+				}
+				iit = tile->destroyItem(iit);
 				++removed;
 			} else {
 				++iit;
 			}
 		}
+		if (changed) {
+			// The removals kept the counted flags, the selection may have gone with them
+			tile->settleFlags();
+			ASSERT(tile->hasConsistentState());
+			map.tileChanged(tile);
+		}
 		++it;
 	}
 	return removed;
@@ -340,24 +483,37 @@ inline int64_t RemoveItemDuplicateOnMap(Map &map, RemoveIfType &condition, bool
 			continue;
 		}
 
+		bool changed = false;
 		if (tile->ground) {
 			if (condition(map, tile, tile->ground, removed, done)) {
-				delete tile->ground;
-				tile->ground = nullptr;
+				map.beforeTileChange(tile);
+				changed = true;
+				tile->setGround(nullptr);
 				++removed;
 			}
 		}
 
 		for (auto iit = tile->items.begin(); iit != tile->items.end();) {
-			Item* item = *iit;
-			if (condition(map, tile, item, removed, done)) {
-				iit = tile->items.erase(iit);
-				delete item;
+			const bool remove = tile->items.visit(iit.getIndex(), [&](Item &item) {
+				return condition(map, tile, &item, removed, done);
+			});
+			if (remove) {
+				if (!changed) {
+					map.beforeTileChange(tile);
+					changed = true;
+				}
+				iit = tile->destroyItem(iit);
 				++removed;
 			} else {
 				++iit;
 			}
 		}
+		if (changed) {
+			// The removals kept the counted flags, the selection may have gone with them
+			tile->settleFlags();
+			ASSERT(tile->hasConsistentState());
+			map.tileChanged(tile);
+		}
 		++it;
 	}
 	return removed;
@@ -0,0 +1,147 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "map_allocator.h"
+
+#include <new>
+#include <type_traits>
+
+namespace {
+	constexpr size_t BlockAlignment = alignof(std::max_align_t);
+
+	constexpr size_t alignUp(size_t size) noexcept {
+		return (size + BlockAlignment - 1) & ~(BlockAlignment - 1);
+	}
+}
+
+//**************** SlabPool **********************
+
+SlabPool::SlabPool(size_t objectSize) :
+	object_size(alignUp(std::max(objectSize, sizeof(FreeBlock)))),
+	free_list(nullptr),
+	slabs(nullptr),
+	bump(nullptr),
+	bump_end(nullptr),
+	slab_count(0),
+	live_count(0),
+	peak_count(0),
+	released(false) {
+	ASSERT(object_size + alignUp(sizeof(Slab)) <= SlabSize);
+}
+
+SlabPool::~SlabPool() {
+	freeSlabs();
+}
+
+void* SlabPool::allocate() {
+	lock();
+	void* block;
+	if (free_list) {
+		block = free_list;
+		free_list = free_list->next;
+	} else {
+		if (bump + object_size > bump_end) {
+			grow();
+		}
+		block = bump;
+		bump += object_size;
+	}
+
+	if (++live_count > peak_count) {
+		peak_count = live_count;
+	}
+	unlock();
+	return block;
+}
+
+void SlabPool::deallocate(void* block) {
+	ASSERT(getOwner(block) == this);
+
+	lock();
+	ASSERT(live_count > 0);
+	FreeBlock* freed = static_cast<FreeBlock*>(block);
+	freed->next = free_list;
+	free_list = freed;
+
+	bool orphaned = --live_count == 0 && released;
+	unlock();
+
+	if (orphaned) {
+		delete this;
+	}
+}
+
+void SlabPool::release() {
+	lock();
+	released = true;
+	bool empty = live_count == 0;
+	unlock();
+
+	if (empty) {
+		delete this;
+	}
+}
+
+void SlabPool::grow() {
+	void* memory = ::operator new(SlabSize, std::align_val_t(SlabSize));
+
+	Slab* slab = static_cast<Slab*>(memory);
+	slab->pool = this;
+	slab->next = slabs;
+	slabs = slab;
+	++slab_count;
+
+	bump = static_cast<char*>(memory) + alignUp(sizeof(Slab));
+	bump_end = static_cast<char*>(memory) + SlabSize;
+}
+
+void SlabPool::freeSlabs() {
+	while (slabs) {
+		Slab* next = slabs->next;
+		::operator delete(slabs, std::align_val_t(SlabSize));
+		slabs = next;
+	}
+	slab_count = 0;
+	free_list = nullptr;
+	bump = bump_end = nullptr;
+}
+
+//**************** MapAllocator **********************
+
+MapAllocator::MapAllocator() :
+	tile_pool(newd SlabPool(sizeof(Tile))),
+	floor_pool(newd SlabPool(sizeof(Floor))),
+	location_pool(newd SlabPool(sizeof(TileLocation) * Floor::SparseLimit)),
+	dense_location_pool(newd SlabPool(sizeof(TileLocation) * (rme::MapLayers - Floor::SparseLimit))),
+	node_pool(newd SlabPool(sizeof(QTreeNode))) {
+	////
+}
+
+MapAllocator::~MapAllocator() {
+	static_assert(std::is_trivially_destructible_v<Floor> && std::is_trivially_destructible_v<TileLocation>);
+
+	// The root released the tiles, nothing else below it needs destroying,
+	// so floors, locations and nodes are dropped with their slabs.
+	delete node_pool;
+	delete floor_pool;
+	delete dense_location_pool;
+	delete location_pool;
+	// Tiles kept alive elsewhere keep their pool until the last one is deleted.
+	tile_pool->release();
+}
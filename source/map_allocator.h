@@ -21,13 +21,99 @@
 #include "tile.h"
 #include "map_region.h"
 
+#include <atomic>
+
 class BaseMap;
 
-class MapAllocator {
+// Hands out fixed size blocks carved from large slabs.
+// Slabs are aligned to their own size, so the pool that owns any block
+// can be found from the block address alone (see getOwner).
+// Selection threads copy tiles concurrently, so every call takes a spin lock.
+class SlabPool {
+public:
+	static constexpr size_t SlabSize = 256 * 1024;
+
+	explicit SlabPool(size_t objectSize);
+	~SlabPool();
+
+	SlabPool(const SlabPool &) = delete;
+	SlabPool &operator=(const SlabPool &) = delete;
 
+	void* allocate();
+	void deallocate(void* block);
+
+	// The pool that handed out this block
+	static SlabPool* getOwner(void* block) noexcept {
+		return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(block) & ~(SlabSize - 1))->pool;
+	}
+
+	// Called by the owner instead of delete, the slabs are released in one go
+	// once every block has been returned (tiles may still live in the undo history)
+	void release();
+
+	size_t getObjectSize() const noexcept {
+		return object_size;
+	}
+	size_t getLiveCount() const noexcept {
+		return live_count;
+	}
+	size_t getPeakCount() const noexcept {
+		return peak_count;
+	}
+	size_t getSlabCount() const noexcept {
+		return slab_count;
+	}
+	size_t getReservedBytes() const noexcept {
+		return slab_count * SlabSize;
+	}
+
+private:
+	struct Slab {
+		SlabPool* pool;
+		Slab* next;
+	};
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	void grow();
+	void freeSlabs();
+
+	void lock() noexcept {
+		while (guard.test_and_set(std::memory_order_acquire)) { }
+	}
+	void unlock() noexcept {
+		guard.clear(std::memory_order_release);
+	}
+
+	std::atomic_flag guard = ATOMIC_FLAG_INIT;
+	size_t object_size;
+	FreeBlock* free_list;
+	Slab* slabs;
+	// Untouched space at the end of the newest slab
+	char* bump;
+	char* bump_end;
+
+	size_t slab_count;
+	size_t live_count;
+	size_t peak_count;
+	bool released;
+};
+
+class MapAllocator {
 public:
-	MapAllocator() { }
-	~MapAllocator() { }
+	struct Stats {
+		size_t live;
+		size_t peak;
+		size_t reserved;
+		size_t used; // live blocks times the block size
+	};
+
+	MapAllocator();
+	~MapAllocator();
+
+	MapAllocator(const MapAllocator &) = delete;
+	MapAllocator &operator=(const MapAllocator &) = delete;
 
 	// shorthands for tiles
 	Tile* operator()(TileLocation* location) {
@@ -38,29 +124,60 @@ public:
 		freeTile(t);
 	}
 
-	//
+	// Tiles can be freed with plain delete, they find their way back to the pool
 	Tile* allocateTile(TileLocation* location) {
-		return newd Tile(*location);
+		return new (tile_pool->allocate()) Tile(*location);
+	}
+	// A tile that is built off the map, setLocation places it later
+	Tile* allocateTile() {
+		return new (tile_pool->allocate()) Tile(0, 0, 0);
 	}
 	void freeTile(Tile* t) {
 		delete t;
 	}
 
-	//
+	// Floors, locations and nodes are never freed one by one, they stay until the map is closed
 	Floor* allocateFloor(int x, int y, int z) {
-		return newd Floor(x, y, z);
+		return new (floor_pool->allocate()) Floor(x, y, z);
 	}
-	void freeFloor(Floor* f) {
-		delete f;
+
+	// Raw storage for the first locations of a floor, or for the rest of them once it turns dense.
+	// Floors construct the locations themselves and return the chunks through SlabPool::getOwner.
+	void* allocateLocations(bool dense) {
+		return dense ? dense_location_pool->allocate() : location_pool->allocate();
 	}
 
 	//
 	QTreeNode* allocateNode(BaseMap &map) {
-		return newd QTreeNode(map);
+		return new (node_pool->allocate()) QTreeNode(map);
+	}
+
+	Stats getTileStats() const noexcept {
+		return getStats(tile_pool);
+	}
+	Stats getFloorStats() const noexcept {
+		return getStats(floor_pool);
 	}
-	void freeNode(QTreeNode* qt) {
-		delete qt;
+	Stats getNodeStats() const noexcept {
+		return getStats(node_pool);
 	}
+	// Location chunks are counted in blocks, a floor holds one or two of them
+	Stats getLocationStats() const noexcept {
+		const Stats sparse = getStats(location_pool);
+		const Stats dense = getStats(dense_location_pool);
+		return { sparse.live + dense.live, sparse.peak + dense.peak, sparse.reserved + dense.reserved, sparse.used + dense.used };
+	}
+
+private:
+	static Stats getStats(const SlabPool* pool) noexcept {
+		return { pool->getLiveCount(), pool->getPeakCount(), pool->getReservedBytes(), pool->getLiveCount() * pool->getObjectSize() };
+	}
+
+	SlabPool* tile_pool;
+	SlabPool* floor_pool;
+	SlabPool* location_pool;
+	SlabPool* dense_location_pool;
+	SlabPool* node_pool;
 };
 
 #endif
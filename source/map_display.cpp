@@ -420,23 +420,27 @@ void MapCanvas::UpdatePositionStatus(int x, int y) {
 		} else if (tile->npc && g_settings.getInteger(Config::SHOW_NPCS)) {
 			ss << ("NPC");
 			ss << " \"" << wxstr(tile->npc->getName()) << "\" spawntime: " << tile->npc->getSpawnNpcTime();
-		} else if (Item* item = tile->getTopItem()) {
-			ss << "Item \"" << wxstr(item->getName()) << "\"";
-			ss << " id:" << item->getID();
-			ss << " cid:" << item->getClientID();
-			if (item->getUniqueID()) {
-				ss << " uid:" << item->getUniqueID();
-			}
-			if (item->getActionID()) {
-				ss << " aid:" << item->getActionID();
-			}
-			if (item->hasWeight()) {
-				wxString s;
-				s.Printf("%.2f", item->getWeight());
-				ss << " weight: " << s;
-			}
 		} else {
-			ss << "Nothing";
+			// Read where it lies, hovering doesn't build items
+			const bool hasItem = tile->visitTopItem([&ss](const Item &item) {
+				ss << "Item \"" << wxstr(item.getName()) << "\"";
+				ss << " id:" << item.getID();
+				ss << " cid:" << item.getClientID();
+				if (item.getUniqueID()) {
+					ss << " uid:" << item.getUniqueID();
+				}
+				if (item.getActionID()) {
+					ss << " aid:" << item.getActionID();
+				}
+				if (item.isPickupable()) {
+					wxString s;
+					s.Printf("%.2f", item.getWeight());
+					ss << " weight: " << s;
+				}
+			});
+			if (!hasItem) {
+				ss << "Nothing";
+			}
 		}
 	} else {
 		ss << "Nothing";
@@ -640,6 +644,8 @@ void MapCanvas::OnMouseLeftDoubleClick(wxMouseEvent &event) {
 
 		int ret = dialog->ShowModal();
 		if (ret != 0) {
+			// The dialog edits the item in place, count the tile again
+			new_tile->update();
 			Action* action = editor.createAction(ACTION_CHANGE_PROPERTIES);
 			action->addChange(newd Change(new_tile));
 			editor.addAction(action);
@@ -1169,6 +1175,10 @@ void MapCanvas::OnMouseActionRelease(wxMouseEvent &event) {
 					ASSERT(cleared == width);
 					ASSERT(remainder == 0);
 
+					// The threads must not read pending tiles in behind each other's back,
+					// compensated selection reaches one tile further per floor
+					editor.getMap().loadPendingTiles(Position(start_x, start_y, end_z), Position(end_x + rme::MapLayers, end_y + rme::MapLayers, start_z));
+
 					selection.start(); // Start a selection session
 					for (SelectionThread* thread : threads) {
 						thread->Execute();
@@ -2089,6 +2099,8 @@ void MapCanvas::OnBrowseTile(wxCommandEvent &WXUNUSED(event)) {
 
 	int ret = w->ShowModal();
 	if (ret != 0) {
+		// Items may have been reordered or edited in place, count the tile again
+		new_tile->update();
 		Action* action = editor.createAction(ACTION_DELETE_TILES);
 		action->addChange(newd Change(new_tile));
 		editor.addAction(action);
@@ -2125,7 +2137,7 @@ void MapCanvas::OnRotateItem(wxCommandEvent &WXUNUSED(event)) {
 	Action* action = editor.createAction(ACTION_ROTATE_ITEM);
 	Tile* new_tile = tile->deepCopy(editor.getMap());
 	Item* new_item = new_tile->getSelectedItems().front();
-	new_item->doRotate();
+	new_tile->changeItem(new_item, [](Item* item) { item->doRotate(); });
 	action->addChange(new Change(new_tile));
 
 	editor.addAction(action);
@@ -2167,7 +2179,7 @@ void MapCanvas::OnSwitchDoor(wxCommandEvent &WXUNUSED(event)) {
 	ItemVector selected_items = new_tile->getSelectedItems();
 	ASSERT(selected_items.size() > 0);
 
-	DoorBrush::switchDoor(selected_items.front());
+	new_tile->changeItem(selected_items.front(), DoorBrush::switchDoor);
 
 	action->addChange(newd Change(new_tile));
 
@@ -2421,6 +2433,8 @@ void MapCanvas::OnProperties(wxCommandEvent &WXUNUSED(event)) {
 
 	int ret = w->ShowModal();
 	if (ret != 0) {
+		// The dialog edits the item in place, count the tile again
+		new_tile->update();
 		Action* action = editor.createAction(ACTION_CHANGE_PROPERTIES);
 		action->addChange(newd Change(new_tile));
 		editor.addAction(action);
@@ -327,21 +327,23 @@ void MapDrawer::DrawMap() {
 					}
 
 					if (!live_client || nd->isVisible(map_z > rme::MapGroundLayer)) {
-						for (int map_x = 0; map_x < 4; ++map_x) {
-							for (int map_y = 0; map_y < 4; ++map_y) {
-								TileLocation* location = nd->getTile(map_x, map_y, map_z);
-								DrawTile(location);
-								// draw light, but only if not zoomed too far
-								if (location && options.show_lights && zoom <= 10) {
-									AddLight(location);
-								}
+						// The spawn and zone overlays are tints DrawTile puts on the tile in this same pass,
+						// so they follow the floor's own locations rather than a separate visitRegion walk.
+						// Slots go x major like the old 4x4 loop, the drawing order stays the same.
+						Floor* floor = nd->getFloor(map_z);
+						if (!floor) {
+							continue;
+						}
+						for (TileLocation &location : *floor) {
+							DrawTile(&location);
+							// draw light, but only if not zoomed too far
+							if (options.show_lights && zoom <= 10) {
+								AddLight(&location);
 							}
 						}
 						if (tile_indicators) {
-							for (int map_x = 0; map_x < 4; ++map_x) {
-								for (int map_y = 0; map_y < 4; ++map_y) {
-									DrawTileIndicators(nd->getTile(map_x, map_y, map_z));
-								}
+							for (TileLocation &location : *floor) {
+								DrawTileIndicators(&location);
 							}
 						}
 					} else {
@@ -464,13 +466,13 @@ void MapDrawer::DrawSecondaryMap(int map_z) {
 
 			// Draw items
 			if (!hidden && !tile->items.empty()) {
-				for (const Item* item : tile->items) {
-					if (item->isBorder()) {
-						BlitItem(draw_x, draw_y, tile, item, true, 160, r, g, b);
+				tile->items.forEach([&](const Item &item) {
+					if (item.isBorder()) {
+						BlitItem(draw_x, draw_y, tile, &item, true, 160, r, g, b);
 					} else {
-						BlitItem(draw_x, draw_y, tile, item, true, 160, 160, 160, 160);
+						BlitItem(draw_x, draw_y, tile, &item, true, 160, 160, 160, 160);
 					}
-				}
+				});
 			}
 
 			// Monsters
@@ -656,9 +658,9 @@ void MapDrawer::DrawHigherFloors() {
 
 			bool hidden = options.hide_items_when_zoomed && zoom > 10.f;
 			if (!hidden && !tile->items.empty()) {
-				for (const Item* item : tile->items) {
-					BlitItem(draw_x, draw_y, tile, item, false, 255, 255, 255, 96);
-				}
+				tile->items.forEach([&](const Item &item) {
+					BlitItem(draw_x, draw_y, tile, &item, false, 255, 255, 255, 96);
+				});
 			}
 		}
 	}
@@ -1507,8 +1509,14 @@ void MapDrawer::DrawTile(TileLocation* location) {
 				b = b / 3 * 2;
 			}
 
+			const TileBitmap* isolated_areas = canvas->editor.getMap().getIsolatedAreas();
+			if (isolated_areas && isolated_areas->test(position)) {
+				g = g / 3 * 2;
+				b /= 3;
+			}
+
 			int item_count = tile->items.size();
-			if (options.highlight_items && item_count > 0 && !tile->items.back()->isBorder()) {
+			if (options.highlight_items && item_count > 0 && !tile->items.visit(item_count - 1, [](const Item &item) { return item.isBorder(); })) {
 				static const float factor[5] = { 0.75f, 0.6f, 0.48f, 0.40f, 0.33f };
 				int idx = (item_count < 5 ? item_count : 5) - 1;
 				g = int(g * factor[idx]);
@@ -1596,21 +1604,22 @@ void MapDrawer::DrawTile(TileLocation* location) {
 	bool hidden = only_colors || (options.hide_items_when_zoomed && zoom > 10.f);
 
 	if (!hidden && !tile->items.empty()) {
-		for (Item* item : tile->items) {
+		// Records are drawn through a stand-in item, no full item is built for them
+		tile->items.forEach([&](Item &item) {
 			if (show_tooltips && position.z == floor) {
-				WriteTooltip(item, tooltip);
+				WriteTooltip(&item, tooltip);
 			}
 
 			if (options.show_preview && zoom <= 2.0) {
-				item->animate();
+				item.animate();
 			}
 
-			if (item->isBorder()) {
-				BlitItem(draw_x, draw_y, tile, item, false, r, g, b);
+			if (item.isBorder()) {
+				BlitItem(draw_x, draw_y, tile, &item, false, r, g, b);
 			} else {
-				BlitItem(draw_x, draw_y, tile, item);
+				BlitItem(draw_x, draw_y, tile, &item);
 			}
-		}
+		});
 	}
 
 	if (!hidden && options.show_monsters && tile->monster) {
@@ -1745,19 +1754,21 @@ void MapDrawer::DrawTileIndicators(TileLocation* location) {
 			blue = 0x00;
 		}
 
-		for (const Item* item : tile->items) {
-			const ItemType &type = g_items.getItemType(item->getID());
-			if ((type.pickupable && options.show_pickupables) || (type.moveable && options.show_moveables)) {
-				if (type.pickupable && options.show_pickupables && type.moveable && options.show_moveables) {
+		for (size_t index = 0; index < tile->items.size(); ++index) {
+			const uint32_t flags = g_items.getFlags(tile->items.getID(index));
+			const bool pickupable = (flags & ITEMTYPE_PICKUPABLE) != 0;
+			const bool moveable = (flags & ITEMTYPE_MOVEABLE) != 0;
+			if ((pickupable && options.show_pickupables) || (moveable && options.show_moveables)) {
+				if (pickupable && options.show_pickupables && moveable && options.show_moveables) {
 					DrawIndicator(x, y, EDITOR_SPRITE_PICKUPABLE_MOVEABLE_ITEM, red, green, blue);
-				} else if (type.pickupable && options.show_pickupables) {
+				} else if (pickupable && options.show_pickupables) {
 					DrawIndicator(x, y, EDITOR_SPRITE_PICKUPABLE_ITEM, red, green, blue);
-				} else if (type.moveable && options.show_moveables) {
+				} else if (moveable && options.show_moveables) {
 					DrawIndicator(x, y, EDITOR_SPRITE_MOVEABLE_ITEM, red, green, blue);
 				}
 			}
 
-			if (type.blockPathfinder && options.show_avoidables) {
+			if ((flags & ITEMTYPE_BLOCK_PATHFINDER) && options.show_avoidables) {
 				DrawIndicator(x, y, EDITOR_SPRITE_AVOIDABLE_ITEM, red, green, blue);
 			}
 		}
@@ -1974,11 +1985,11 @@ void MapDrawer::AddLight(TileLocation* location) {
 
 	bool hidden = options.hide_items_when_zoomed && zoom > 10.f;
 	if (!hidden && !tile->items.empty()) {
-		for (auto item : tile->items) {
-			if (item->hasLight()) {
-				light_drawer->addLight(position.x, position.y, position.z, item->getLight());
+		tile->items.forEach([&](const Item &item) {
+			if (item.hasLight()) {
+				light_drawer->addLight(position.x, position.y, position.z, item.getLight());
 			}
-		}
+		});
 	}
 }
 
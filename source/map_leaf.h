@@ -0,0 +1,39 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_MAP_LEAF_H
+#define RME_MAP_LEAF_H
+
+#include "position.h"
+
+// Map leaves are the 4x4 tile blocks of one floor the map is stored in. The indexes that
+// keep something per leaf name it by one key: the floor in the top 4 bits, then y and x
+// over the leaf size in 14 bits each, so keys sort by floor, then row, then column.
+namespace MapLeaf {
+	constexpr int Size = 4;
+
+	inline uint32_t key(const Position &position) noexcept {
+		return (uint32_t(position.z) << 28) | (uint32_t(position.y / Size) << 14) | uint32_t(position.x / Size);
+	}
+	// Top left tile of the leaf
+	inline Position corner(uint32_t key) noexcept {
+		return Position(int(key & 0x3FFF) * Size, int((key >> 14) & 0x3FFF) * Size, int(key >> 28));
+	}
+}
+
+#endif
@@ -18,27 +18,24 @@
 #include "main.h"
 
 #include "map_region.h"
+#include "map_allocator.h"
 #include "basemap.h"
 #include "position.h"
 #include "tile.h"
+#include "content_hash.h"
 
 //**************** Tile Location **********************
 
 TileLocation::TileLocation() :
 	tile(nullptr),
+	house_exits(nullptr),
 	position(0, 0, 0),
 	spawn_monster_count(0),
 	spawn_npc_count(0),
-	waypoint_count(0),
-	house_exits(nullptr) {
+	waypoint_count(0) {
 	////
 }
 
-TileLocation::~TileLocation() {
-	delete tile;
-	delete house_exits;
-}
-
 int TileLocation::size() const {
 	if (tile) {
 		return tile->size();
@@ -59,22 +56,89 @@ HouseExitList* TileLocation::createHouseExits() {
 
 //**************** Floor **********************
 
-Floor::Floor(int sx, int sy, int z) {
-	sx = sx & ~3;
-	sy = sy & ~3;
+Floor::Floor(int sx, int sy, int z) :
+	x(sx & ~3),
+	y(sy & ~3),
+	z(z),
+	count(0),
+	mask(0),
+	order(0),
+	sparse(nullptr),
+	dense(nullptr),
+	content_hash(0) {
+	////
+}
 
-	for (int i = 0; i < rme::MapLayers; ++i) {
-		locs[i].position.x = sx + (i >> 2);
-		locs[i].position.y = sy + (i & 3);
-		locs[i].position.z = z;
+void Floor::releaseTiles() noexcept {
+	for (TileLocation &location : *this) {
+		delete location.tile;
+		delete location.house_exits;
+	}
+}
+
+TileLocation* Floor::createLocation(MapAllocator &allocator, int index) {
+	if (TileLocation* location = getLocation(index)) {
+		return location;
+	}
+
+	TileLocation* location;
+	if (count < SparseLimit) {
+		if (!sparse) {
+			sparse = static_cast<TileLocation*>(allocator.allocateLocations(false));
+		}
+		location = new (&sparse[count]) TileLocation();
+	} else {
+		if (!dense) {
+			dense = static_cast<TileLocation*>(allocator.allocateLocations(true));
+		}
+		location = new (&dense[count - SparseLimit]) TileLocation();
+	}
+	location->position = Position(x + (index >> 2), y + (index & 3), z);
+
+	order |= static_cast<uint64_t>(count) << (index * 4);
+	mask |= 1 << index;
+	++count;
+	return location;
+}
+
+size_t Floor::memsize() const noexcept {
+	size_t mem = sizeof(*this);
+	if (sparse) {
+		mem += sizeof(TileLocation) * SparseLimit;
+	}
+	if (dense) {
+		mem += sizeof(TileLocation) * (rme::MapLayers - SparseLimit);
 	}
+	return mem;
+}
+
+uint64_t Floor::getContentHash() {
+	if (content_hash != 0) {
+		return content_hash;
+	}
+
+	ContentHash hash;
+	bool empty = true;
+	for (TileLocation &location : *this) {
+		const Tile* tile = location.get();
+		const uint64_t tile_hash = tile ? tile->getContentHash() : ContentHash::Empty;
+		if (tile_hash != ContentHash::Empty) {
+			hash.add(((location.getX() & 3) << 2) | (location.getY() & 3));
+			hash.add(tile_hash);
+			empty = false;
+		}
+	}
+	content_hash = empty ? ContentHash::Empty : hash.get();
+	return content_hash;
 }
 
 //**************** QTreeNode **********************
 
 QTreeNode::QTreeNode(BaseMap &map) :
 	map(map),
+	parent(nullptr),
 	visible(0),
+	content_hash(0),
 	isLeaf(false) {
 	// Doesn't matter if we're leaf or node
 	for (int i = 0; i < rme::MapLayers; ++i) {
@@ -83,13 +147,19 @@ QTreeNode::QTreeNode(BaseMap &map) :
 }
 
 QTreeNode::~QTreeNode() {
-	if (isLeaf) {
-		for (int i = 0; i < rme::MapLayers; ++i) {
-			delete array[i];
-		}
-	} else {
-		for (int i = 0; i < rme::MapLayers; ++i) {
-			delete child[i];
+	// Only the root is destroyed, along with the map. Everything below it lives in the
+	// slabs of the map allocator, which drops them wholesale once the root is gone.
+	releaseTiles();
+}
+
+void QTreeNode::releaseTiles() noexcept {
+	for (int i = 0; i < rme::MapLayers; ++i) {
+		if (isLeaf) {
+			if (array[i]) {
+				array[i]->releaseTiles();
+			}
+		} else if (child[i]) {
+			child[i]->releaseTiles();
 		}
 	}
 }
@@ -128,12 +198,11 @@ QTreeNode* QTreeNode::getLeafForce(int x, int y) {
 			}
 
 		} else {
+			qt = map.allocator.allocateNode(map);
+			qt->parent = node;
 			if (level == 0) {
-				qt = newd QTreeNode(map);
 				qt->isLeaf = true;
 				return qt;
-			} else {
-				qt = newd QTreeNode(map);
 			}
 		}
 		node = node->child[index];
@@ -145,10 +214,61 @@ QTreeNode* QTreeNode::getLeafForce(int x, int y) {
 	return nullptr;
 }
 
+uint64_t QTreeNode::getContentHash() {
+	if (content_hash != 0) {
+		return content_hash;
+	}
+
+	ContentHash hash;
+	bool empty = true;
+	for (int i = 0; i < rme::MapLayers; ++i) {
+		uint64_t child_hash = ContentHash::Empty;
+		if (isLeaf) {
+			if (array[i]) {
+				child_hash = array[i]->getContentHash();
+			}
+		} else if (child[i]) {
+			child_hash = child[i]->getContentHash();
+		}
+
+		if (child_hash != ContentHash::Empty) {
+			hash.add(i);
+			hash.add(child_hash);
+			empty = false;
+		}
+	}
+	content_hash = empty ? ContentHash::Empty : hash.get();
+	return content_hash;
+}
+
+void QTreeNode::invalidateContentHash(int z) {
+	ASSERT(isLeaf);
+	if (Floor* floor = array[z]) {
+		floor->invalidateContentHash();
+	}
+	// At most eight nodes up to the root
+	for (QTreeNode* node = this; node; node = node->parent) {
+		node->content_hash = 0;
+	}
+}
+
+void QTreeNode::clearContentHashes() {
+	content_hash = 0;
+	for (int i = 0; i < rme::MapLayers; ++i) {
+		if (isLeaf) {
+			if (array[i]) {
+				array[i]->invalidateContentHash();
+			}
+		} else if (child[i]) {
+			child[i]->clearContentHashes();
+		}
+	}
+}
+
 Floor* QTreeNode::createFloor(int x, int y, int z) {
 	ASSERT(isLeaf);
 	if (!array[z]) {
-		array[z] = newd Floor(x, y, z);
+		array[z] = map.allocator.allocateFloor(x, y, z);
 	}
 	return array[z];
 }
@@ -223,13 +343,13 @@ TileLocation* QTreeNode::getTile(int x, int y, int z) {
 	if (!f) {
 		return nullptr;
 	}
-	return &f->locs[(x & 3) * 4 + (y & 3)];
+	return f->getLocation((x & 3) * 4 + (y & 3));
 }
 
 TileLocation* QTreeNode::createTile(int x, int y, int z) {
 	ASSERT(isLeaf);
 	Floor* f = createFloor(x, y, z);
-	return &f->locs[(x & 3) * 4 + (y & 3)];
+	return f->createLocation(map.allocator, (x & 3) * 4 + (y & 3));
 }
 
 Tile* QTreeNode::setTile(int x, int y, int z, Tile* newtile) {
@@ -239,9 +359,10 @@ Tile* QTreeNode::setTile(int x, int y, int z, Tile* newtile) {
 	int offset_x = x & 3;
 	int offset_y = y & 3;
 
-	TileLocation* tmp = &f->locs[offset_x * 4 + offset_y];
+	TileLocation* tmp = f->createLocation(map.allocator, offset_x * 4 + offset_y);
 	Tile* oldtile = tmp->tile;
 	tmp->tile = newtile;
+	invalidateContentHash(z);
 
 	if (newtile && !oldtile) {
 		++map.tilecount;
@@ -259,7 +380,63 @@ void QTreeNode::clearTile(int x, int y, int z) {
 	int offset_x = x & 3;
 	int offset_y = y & 3;
 
-	TileLocation* tmp = &f->locs[offset_x * 4 + offset_y];
+	TileLocation* tmp = f->createLocation(map.allocator, offset_x * 4 + offset_y);
 	delete tmp->tile;
 	tmp->tile = map.allocator(tmp);
+	invalidateContentHash(z);
+}
+
+//**************** SectorTable **********************
+
+SectorTable::SectorTable() :
+	sectors(nullptr),
+	sector_count(0),
+	last_sector(nullptr) {
+	////
+}
+
+SectorTable::~SectorTable() {
+	if (sectors) {
+		for (int i = 0; i < SectorSide * SectorSide; ++i) {
+			delete sectors[i];
+		}
+		delete[] sectors;
+	} else {
+		for (size_t i = 0; i < sector_count; ++i) {
+			delete listed[i];
+		}
+	}
+}
+
+void SectorTable::setLeaf(int x, int y, QTreeNode* leaf) {
+	const uint32_t index = getSectorIndex(x, y);
+	Sector* sector = nullptr;
+	if (sectors) {
+		sector = sectors[index];
+	} else {
+		for (size_t i = 0; i < sector_count; ++i) {
+			if (listed[i]->index == index) {
+				sector = listed[i];
+				break;
+			}
+		}
+	}
+
+	if (!sector) {
+		sector = newd Sector();
+		sector->index = index;
+		if (!sectors && sector_count == ListedSectors) {
+			sectors = newd Sector*[SectorSide * SectorSide]();
+			for (Sector* moved : listed) {
+				sectors[moved->index] = moved;
+			}
+		}
+		if (sectors) {
+			sectors[index] = sector;
+		} else {
+			listed[sector_count] = sector;
+		}
+		++sector_count;
+	}
+	sector->leaves[getLeafIndex(x, y)] = leaf;
 }
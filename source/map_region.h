@@ -21,26 +21,30 @@
 #include "const.h"
 #include "position.h"
 
+#include <atomic>
+#include <bit>
+
 class Tile;
 class Floor;
 class BaseMap;
+class MapAllocator;
 
+// Nothing but plain fields, the floor frees the tile and the house exits (see Floor::releaseTiles)
 class TileLocation {
 	TileLocation();
 
 public:
-	~TileLocation();
-
 	TileLocation(const TileLocation &) = delete;
 	TileLocation &operator=(const TileLocation &) = delete;
 
 protected:
 	Tile* tile;
-	Position position;
-	size_t spawn_monster_count;
-	size_t spawn_npc_count;
-	size_t waypoint_count;
 	HouseExitList* house_exits; // Any house exits pointing here
+	Position position;
+	// How many spawns / waypoints cover this location, packed behind the position
+	uint16_t spawn_monster_count;
+	uint16_t spawn_npc_count;
+	uint16_t waypoint_count;
 
 public:
 	// Access tile
@@ -68,6 +72,8 @@ public:
 		return position.z;
 	}
 
+	// How many spawn areas cover the location, only kept for drawing them,
+	// everything else asks the spawn index of the map
 	size_t getSpawnMonsterCount() const noexcept {
 		return spawn_monster_count;
 	}
@@ -107,12 +113,94 @@ public:
 	friend class Waypoints;
 };
 
+// The locations of one 4x4 block on one floor, slot i holds the location at x + (i >> 2), y + (i & 3).
+// Locations are only created when asked for, since most blocks away from the main floors only
+// hold a few tiles. The first SparseLimit go into a small chunk, past that the rest of the block
+// is allocated in one go. Locations never move once created, tiles keep pointers to them.
 class Floor {
 public:
+	static constexpr int SparseLimit = 4;
+
 	Floor(int x, int y, int z);
-	TileLocation locs[rme::MapLayers];
+
+	Floor(const Floor &) = delete;
+	Floor &operator=(const Floor &) = delete;
+
+	TileLocation* getLocation(int index) noexcept; // Might return nullptr
+	TileLocation* createLocation(MapAllocator &allocator, int index);
+
+	// One bit per slot that has a location
+	uint16_t getMask() const noexcept {
+		return mask;
+	}
+	int getLocationCount() const noexcept {
+		return count;
+	}
+	bool isDense() const noexcept {
+		return count > SparseLimit;
+	}
+	size_t memsize() const noexcept;
+
+	// Deletes the tiles and house exits, the only parts owning memory outside the map allocator.
+	// The floor and its locations are never destroyed one by one, they go with the slabs.
+	void releaseTiles() noexcept;
+
+	// Hash of the tiles, cached until one of them is replaced
+	uint64_t getContentHash();
+	void invalidateContentHash() noexcept {
+		content_hash = 0;
+	}
+
+	// Walks the existing locations in slot order
+	class Iterator {
+	public:
+		Iterator(Floor* floor, uint32_t remaining) noexcept :
+			floor(floor), remaining(remaining) { }
+
+		TileLocation &operator*() const noexcept {
+			return *floor->getLocation(std::countr_zero(remaining));
+		}
+		Iterator &operator++() noexcept {
+			remaining &= remaining - 1;
+			return *this;
+		}
+		bool operator!=(const Iterator &other) const noexcept {
+			return remaining != other.remaining;
+		}
+
+	private:
+		Floor* floor;
+		uint32_t remaining;
+	};
+	Iterator begin() noexcept {
+		return Iterator(this, mask);
+	}
+	Iterator end() noexcept {
+		return Iterator(this, 0);
+	}
+
+private:
+	uint16_t x;
+	uint16_t y;
+	uint8_t z;
+	uint8_t count;
+	uint16_t mask;
+	// 4 bits per slot, the order in which the location was created.
+	// The first SparseLimit live in sparse, the others in dense.
+	uint64_t order;
+	TileLocation* sparse;
+	TileLocation* dense;
+	uint64_t content_hash; // 0 until computed
 };
 
+inline TileLocation* Floor::getLocation(int index) noexcept {
+	if (!testFlags(mask, 1 << index)) {
+		return nullptr;
+	}
+	const uint32_t created = (order >> (index * 4)) & 0xF;
+	return created < SparseLimit ? &sparse[created] : &dense[created - SparseLimit];
+}
+
 // This is not a QuadTree, but a HexTree (16 child nodes to every node), so the name is abit misleading
 class QTreeNode {
 public:
@@ -149,9 +237,20 @@ public:
 	bool isVisible(bool underground);
 	bool isRequested(bool underground);
 
+	// Merkle hash over the children (or the floors of a leaf), cached until a tile below is replaced
+	uint64_t getContentHash();
+	// Drops the cached hash of floor z of this leaf and of the nodes above it
+	void invalidateContentHash(int z);
+	// Drops every cached hash below, for changes made to the tiles in place
+	void clearContentHashes();
+
 protected:
+	void releaseTiles() noexcept;
+
 	BaseMap &map;
+	QTreeNode* parent; // nullptr for the root
 	uint32_t visible;
+	uint64_t content_hash; // 0 until computed
 
 	bool isLeaf;
 
@@ -165,6 +264,110 @@ protected:
 
 	friend class BaseMap;
 	friend class MapIterator;
+	friend class MapTraversal;
 };
 
+// Flat two level index over the hextree leaves, turns a leaf lookup into two array reads
+// instead of walking seven levels of nodes. The hextree still owns the leaves.
+// A sector covers 256x256 tiles and keeps one slot for every 4x4 leaf inside it.
+// Coordinates wrap at 16 bits, the same way the hextree treats them.
+class SectorTable {
+public:
+	SectorTable();
+	~SectorTable();
+
+	SectorTable(const SectorTable &) = delete;
+	SectorTable &operator=(const SectorTable &) = delete;
+
+	QTreeNode* getLeaf(int x, int y) const noexcept; // Might return nullptr
+	void setLeaf(int x, int y, QTreeNode* leaf);
+	// Calls func(QTreeNode*) for every leaf, sector by sector, without touching the inner nodes
+	template <typename Func>
+	void forEachLeaf(Func &&func) const;
+
+	size_t getSectorCount() const noexcept {
+		return sector_count;
+	}
+	size_t memsize() const noexcept {
+		return sector_count * sizeof(Sector) + (sectors ? sizeof(Sector*) * SectorSide * SectorSide : 0);
+	}
+	// True once the map spans enough sectors to get the full top level
+	bool hasTopLevel() const noexcept {
+		return sectors != nullptr;
+	}
+
+private:
+	static constexpr int SectorShift = 8;
+	static constexpr int SectorSide = 1 << (16 - SectorShift);
+	static constexpr int LeafSide = 1 << (SectorShift - 2);
+
+	struct Sector {
+		uint32_t index;
+		QTreeNode* leaves[LeafSide * LeafSide];
+	};
+
+	static uint32_t getSectorIndex(int x, int y) noexcept {
+		return ((static_cast<uint32_t>(x) & 0xFFFF) >> SectorShift) * SectorSide + ((static_cast<uint32_t>(y) & 0xFFFF) >> SectorShift);
+	}
+	static uint32_t getLeafIndex(int x, int y) noexcept {
+		constexpr uint32_t mask = (1 << SectorShift) - 1;
+		return ((static_cast<uint32_t>(x) & mask) >> 2) * LeafSide + ((static_cast<uint32_t>(y) & mask) >> 2);
+	}
+
+	// Copy buffers and scratch maps only touch a few sectors, those are searched in a short list.
+	// The 512 KiB top level is allocated once a map outgrows it.
+	static constexpr size_t ListedSectors = 8;
+	Sector* listed[ListedSectors];
+	Sector** sectors;
+	size_t sector_count;
+	// The last sector looked up, neighbouring lookups nearly always land in the same one.
+	// Sectors are never freed while the table lives, so a stale pointer is still valid.
+	mutable std::atomic<Sector*> last_sector;
+};
+
+template <typename Func>
+void SectorTable::forEachLeaf(Func &&func) const {
+	const auto visitSector = [&func](const Sector* sector) {
+		for (QTreeNode* leaf : sector->leaves) {
+			if (leaf) {
+				func(leaf);
+			}
+		}
+	};
+	if (sectors) {
+		for (int i = 0; i < SectorSide * SectorSide; ++i) {
+			if (sectors[i]) {
+				visitSector(sectors[i]);
+			}
+		}
+	} else {
+		for (size_t i = 0; i < sector_count; ++i) {
+			visitSector(listed[i]);
+		}
+	}
+}
+
+inline QTreeNode* SectorTable::getLeaf(int x, int y) const noexcept {
+	const uint32_t index = getSectorIndex(x, y);
+	Sector* sector = last_sector.load(std::memory_order_relaxed);
+	if (!sector || sector->index != index) {
+		if (sectors) {
+			sector = sectors[index];
+		} else {
+			sector = nullptr;
+			for (size_t i = 0; i < sector_count; ++i) {
+				if (listed[i]->index == index) {
+					sector = listed[i];
+					break;
+				}
+			}
+		}
+		if (!sector) {
+			return nullptr;
+		}
+		last_sector.store(sector, std::memory_order_relaxed);
+	}
+	return sector->leaves[getLeafIndex(x, y)];
+}
+
 #endif
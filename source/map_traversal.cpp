@@ -0,0 +1,88 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "map_traversal.h"
+
+std::vector<QTreeNode*> MapTraversal::split(BaseMap &map) {
+	// A few pieces per worker, so one dense subtree doesn't leave the others idle
+	const size_t wanted = g_workers.getThreadCount() * 16;
+	// The workers must not read pending tiles in behind each other's back
+	map.loadAllPendingTiles();
+
+	std::vector<QTreeNode*> nodes = { &map.root };
+	std::vector<QTreeNode*> next;
+	while (nodes.size() < wanted) {
+		bool expanded = false;
+		next.clear();
+		for (QTreeNode* node : nodes) {
+			if (node->isLeaf) {
+				next.push_back(node);
+				continue;
+			}
+			expanded = true;
+			for (QTreeNode* child : node->child) {
+				if (child) {
+					next.push_back(child);
+				}
+			}
+		}
+		nodes.swap(next);
+		if (!expanded) {
+			break;
+		}
+	}
+	return nodes;
+}
+
+std::vector<QTreeNode*> MapTraversal::getNodes(BaseMap &map, int side) {
+	map.loadAllPendingTiles();
+	std::vector<QTreeNode*> nodes = { &map.root };
+	std::vector<QTreeNode*> next;
+	// The root covers the whole 16 bit coordinate range
+	for (int node_side = 0x10000; node_side > side; node_side /= 4) {
+		next.clear();
+		for (QTreeNode* node : nodes) {
+			ASSERT(!node->isLeaf);
+			for (QTreeNode* child : node->child) {
+				if (child) {
+					next.push_back(child);
+				}
+			}
+		}
+		nodes.swap(next);
+	}
+	return nodes;
+}
+
+void MapTraversal::run(BaseMap &map, const SubtreeTask &task, const Progress &progress) {
+	std::vector<QTreeNode*> subtrees = split(map);
+	const uint64_t total = map.getTileCount();
+	std::atomic<uint64_t> done(0);
+
+	g_workers.run(
+		subtrees.size(), [&](size_t index, size_t worker) {
+			done += task(subtrees[index], worker);
+		},
+		[&]() {
+			if (progress) {
+				progress(done.load(), total);
+			}
+		}
+	);
+}
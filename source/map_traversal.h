@@ -0,0 +1,123 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MAP_TRAVERSAL_H
+#define RME_MAP_TRAVERSAL_H
+
+#include "basemap.h"
+#include "worker_pool.h"
+
+#include <atomic>
+
+// Whole map walks spread over the worker pool. The hextree is cut into subtrees
+// that are handed out to the workers, every tile is visited exactly once.
+// progress(done, total) is called on the calling thread while the workers run.
+class MapTraversal {
+public:
+	using Progress = std::function<void(uint64_t done, uint64_t total)>;
+
+	// Read-only walk, visit(const Tile*, Accumulator&) fills one accumulator per worker.
+	// The accumulators are folded together at the end with merge(Accumulator& into, const Accumulator& from).
+	template <typename Accumulator, typename Visit, typename Merge>
+	static Accumulator reduce(BaseMap &map, Visit visit, Merge merge, const Progress &progress = nullptr);
+
+	// Mutating walk, visit(Tile*) may change the tile it is given and its items,
+	// but nothing shared: no other tiles, no setTile or createTile, no map wide lists.
+	template <typename Visit>
+	static void forEach(BaseMap &map, Visit visit, const Progress &progress = nullptr);
+
+	// Disjoint subtrees covering the whole map, a few per worker.
+	// They come in MapIterator order, so walking them one after another walks the map in that order.
+	static std::vector<QTreeNode*> split(BaseMap &map);
+
+	// Calls func(Tile*) for the tiles below node in MapIterator order, returns how many there were
+	template <typename Func>
+	static uint64_t visitSubtree(QTreeNode* node, Func &func);
+
+	// The nodes covering side x side tiles that exist, in MapIterator order.
+	// side is a power of 4 from a leaf (4) up to the children of the root (16384).
+	static std::vector<QTreeNode*> getNodes(BaseMap &map, int side);
+
+private:
+	using SubtreeTask = std::function<uint64_t(QTreeNode* subtree, size_t worker)>;
+	static void run(BaseMap &map, const SubtreeTask &task, const Progress &progress);
+};
+
+template <typename Accumulator, typename Visit, typename Merge>
+Accumulator MapTraversal::reduce(BaseMap &map, Visit visit, Merge merge, const Progress &progress) {
+	// Padded so workers don't fight over the same cache line
+	struct alignas(64) Slot {
+		Accumulator value {};
+	};
+	std::vector<Slot> slots(g_workers.getThreadCount());
+
+	run(
+		map, [&](QTreeNode* subtree, size_t worker) {
+			Accumulator &accumulator = slots[worker].value;
+			auto func = [&](Tile* tile) {
+				visit(static_cast<const Tile*>(tile), accumulator);
+			};
+			return visitSubtree(subtree, func);
+		},
+		progress
+	);
+
+	Accumulator result = std::move(slots[0].value);
+	for (size_t i = 1; i < slots.size(); ++i) {
+		merge(result, slots[i].value);
+	}
+	return result;
+}
+
+template <typename Visit>
+void MapTraversal::forEach(BaseMap &map, Visit visit, const Progress &progress) {
+	run(
+		map, [&](QTreeNode* subtree, size_t) {
+			return visitSubtree(subtree, visit);
+		},
+		progress
+	);
+	// The tiles were changed in place, behind the back of the cached hashes
+	map.clearContentHashes();
+}
+
+template <typename Func>
+uint64_t MapTraversal::visitSubtree(QTreeNode* node, Func &func) {
+	uint64_t tiles = 0;
+	if (node->isLeaf) {
+		for (Floor* floor : node->array) {
+			if (!floor) {
+				continue;
+			}
+			for (TileLocation &location : *floor) {
+				if (Tile* tile = location.get()) {
+					func(tile);
+					++tiles;
+				}
+			}
+		}
+	} else {
+		for (QTreeNode* child : node->child) {
+			if (child) {
+				tiles += visitSubtree(child, func);
+			}
+		}
+	}
+	return tiles;
+}
+
+#endif
@@ -0,0 +1,308 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "memory_report.h"
+
+#include "map_traversal.h"
+#include "map.h"
+#include "editor.h"
+#include "action.h"
+#include "complexitem.h"
+#include "monster.h"
+#include "npc.h"
+#include "spawn_monster.h"
+#include "spawn_npc.h"
+#include "house.h"
+#include "town.h"
+#include "graphics.h"
+#include "live_server.h"
+#include "live_client.h"
+
+#include <iomanip>
+
+namespace {
+	// Rough size of a std::map / std::set node on top of its value
+	constexpr uint64_t MemoryTreeNodeOverhead = 4 * sizeof(void*);
+
+	uint64_t stringHeapBytes(const std::string &str) {
+		// Short strings are stored inline, their data points into the string itself
+		const char* data = str.data();
+		const char* self = reinterpret_cast<const char*>(&str);
+		const bool inline_data = data >= self && data < self + sizeof(std::string);
+		return inline_data ? 0 : str.capacity() + 1;
+	}
+
+	// Items are handed out in 16 byte size classes, see Item::operator new
+	constexpr uint64_t pooledItemSize(size_t size) {
+		return (size + 15) & ~static_cast<size_t>(15);
+	}
+
+	enum MemoryItemKind {
+		MEMORY_ITEM_PLAIN,
+		MEMORY_ITEM_CONTAINER,
+		MEMORY_ITEM_TELEPORT,
+		MEMORY_ITEM_DOOR,
+		MEMORY_ITEM_DEPOT,
+		MEMORY_ITEM_KINDS
+	};
+
+	const char* const MemoryItemKindNames[MEMORY_ITEM_KINDS] = {
+		"Items",
+		"Items (containers)",
+		"Items (teleports)",
+		"Items (doors)",
+		"Items (depots)",
+	};
+
+	// Filled per worker while walking the tiles
+	struct TileMemory {
+		uint64_t tiles = 0;
+		uint64_t tile_heap_bytes = 0;
+		uint64_t items[MEMORY_ITEM_KINDS] = {};
+		uint64_t item_bytes[MEMORY_ITEM_KINDS] = {};
+		uint64_t records = 0;
+		uint64_t shared = 0;
+		uint64_t shared_bytes = 0;
+		uint64_t attribute_lists = 0;
+		uint64_t attribute_bytes = 0;
+		uint64_t monsters = 0;
+		uint64_t monster_bytes = 0;
+		uint64_t npcs = 0;
+		uint64_t npc_bytes = 0;
+		uint64_t spawns = 0;
+		uint64_t spawn_bytes = 0;
+	};
+
+	void addItemMemory(const Item* item, TileMemory &memory) {
+		MemoryItemKind kind = MEMORY_ITEM_PLAIN;
+		size_t size = sizeof(Item);
+		if (const Container* container = dynamic_cast<const Container*>(item)) {
+			kind = MEMORY_ITEM_CONTAINER;
+			size = sizeof(Container);
+			memory.item_bytes[kind] += container->getVector().getHeapBytes();
+			for (const Item* content : container->getVector()) {
+				addItemMemory(content, memory);
+			}
+		} else if (dynamic_cast<const Teleport*>(item)) {
+			kind = MEMORY_ITEM_TELEPORT;
+			size = sizeof(Teleport);
+		} else if (dynamic_cast<const Door*>(item)) {
+			kind = MEMORY_ITEM_DOOR;
+			size = sizeof(Door);
+		} else if (dynamic_cast<const Depot*>(item)) {
+			kind = MEMORY_ITEM_DEPOT;
+			size = sizeof(Depot);
+		}
+
+		memory.items[kind] += 1;
+		memory.item_bytes[kind] += pooledItemSize(size);
+		if (const size_t attributes = item->getAttributesMemsize()) {
+			memory.attribute_lists += 1;
+			memory.attribute_bytes += attributes;
+		}
+	}
+}
+
+void MemoryReport::add(const std::string &category, uint64_t count, uint64_t bytes) {
+	for (Entry &entry : entries) {
+		if (entry.category == category) {
+			entry.count += count;
+			entry.bytes += bytes;
+			return;
+		}
+	}
+	entries.push_back({ category, count, bytes });
+}
+
+void MemoryReport::addMap(Map &map) {
+	const MapAllocator::Stats nodes = map.allocator.getNodeStats();
+	const MapAllocator::Stats floors = map.allocator.getFloorStats();
+	const MapAllocator::Stats locations = map.allocator.getLocationStats();
+	const MapAllocator::Stats tiles = map.allocator.getTileStats();
+
+	uint64_t location_count = 0;
+	for (const BaseMap::FloorUsage &usage : map.getFloorUsage()) {
+		location_count += usage.locations;
+	}
+
+	add("Hextree nodes", nodes.live, nodes.used);
+	add("Sector table", 0, map.getSectorTableMemsize());
+	add("Floors", floors.live, floors.used);
+	add("Tile locations", location_count, locations.used);
+
+	const auto visit = [](const Tile* tile, TileMemory &memory) {
+		memory.tiles += 1;
+		memory.tile_heap_bytes += tile->items.getHeapBytes() + tile->zones.getHeapBytes();
+		if (tile->ground) {
+			addItemMemory(tile->ground, memory);
+		}
+		// Records live in the slots already counted with the tile, shared items are split over
+		// the tiles holding them
+		memory.records += tile->items.getRecordCount();
+		memory.shared += tile->items.getSharedCount();
+		memory.shared_bytes += tile->items.getSharedBytes();
+		for (size_t index = 0; index < tile->items.size(); ++index) {
+			if (!tile->items.isRecord(index) && !tile->items.isShared(index)) {
+				addItemMemory(tile->items[index], memory);
+			}
+		}
+		if (tile->monster) {
+			memory.monsters += 1;
+			memory.monster_bytes += sizeof(Monster);
+		}
+		if (tile->npc) {
+			memory.npcs += 1;
+			memory.npc_bytes += sizeof(Npc);
+		}
+		if (tile->spawnMonster) {
+			memory.spawns += 1;
+			memory.spawn_bytes += sizeof(SpawnMonster);
+		}
+		if (tile->spawnNpc) {
+			memory.spawns += 1;
+			memory.spawn_bytes += sizeof(SpawnNpc);
+		}
+	};
+	const auto merge = [](TileMemory &into, const TileMemory &from) {
+		into.tiles += from.tiles;
+		into.tile_heap_bytes += from.tile_heap_bytes;
+		for (int kind = 0; kind < MEMORY_ITEM_KINDS; ++kind) {
+			into.items[kind] += from.items[kind];
+			into.item_bytes[kind] += from.item_bytes[kind];
+		}
+		into.records += from.records;
+		into.shared += from.shared;
+		into.shared_bytes += from.shared_bytes;
+		into.attribute_lists += from.attribute_lists;
+		into.attribute_bytes += from.attribute_bytes;
+		into.monsters += from.monsters;
+		into.monster_bytes += from.monster_bytes;
+		into.npcs += from.npcs;
+		into.npc_bytes += from.npc_bytes;
+		into.spawns += from.spawns;
+		into.spawn_bytes += from.spawn_bytes;
+	};
+	const TileMemory memory = MapTraversal::reduce<TileMemory>(map, visit, merge);
+
+	// The map allocator also hands out the tiles of the undo history, those are counted there
+	add("Tiles", memory.tiles, memory.tiles * sizeof(Tile) + memory.tile_heap_bytes);
+	add(
+		"Map pools, unused reserve", 0,
+		(nodes.reserved - nodes.used) + (floors.reserved - floors.used) + (locations.reserved - locations.used) + (tiles.reserved - tiles.used)
+	);
+
+	for (int kind = 0; kind < MEMORY_ITEM_KINDS; ++kind) {
+		add(MemoryItemKindNames[kind], memory.items[kind], memory.item_bytes[kind]);
+	}
+	add("Items (inline records)", memory.records, 0);
+	add("Items (shared)", memory.shared, memory.shared_bytes);
+	add("Item attributes", memory.attribute_lists, memory.attribute_bytes);
+	add("Monsters", memory.monsters, memory.monster_bytes);
+	add("Npcs", memory.npcs, memory.npc_bytes);
+
+	const uint64_t spawn_positions = map.spawnsMonster.size() + map.spawnsNpc.size();
+	add("Spawns", memory.spawns, memory.spawn_bytes + spawn_positions * (sizeof(Position) + MemoryTreeNodeOverhead));
+	add("Spawn index", spawn_positions, map.spawnsMonster.getIndexMemsize() + map.spawnsNpc.getIndexMemsize());
+
+	uint64_t house_bytes = 0;
+	for (const auto &[id, house] : map.houses) {
+		house_bytes += sizeof(House) + MemoryTreeNodeOverhead + sizeof(std::pair<const uint32_t, House*>);
+		house_bytes += stringHeapBytes(house->name);
+		house_bytes += house->getListBytes();
+	}
+	add("Houses", map.houses.count(), house_bytes);
+
+	uint64_t town_bytes = 0;
+	for (const auto &[id, town] : map.towns) {
+		town_bytes += sizeof(Town) + MemoryTreeNodeOverhead + sizeof(std::pair<const uint32_t, Town*>);
+		town_bytes += stringHeapBytes(town->getName());
+	}
+	add("Towns", map.towns.count(), town_bytes);
+
+	uint64_t waypoint_bytes = 0;
+	for (const auto &[name, waypoint] : map.waypoints) {
+		waypoint_bytes += sizeof(Waypoint) + MemoryTreeNodeOverhead + sizeof(std::pair<const std::string, Waypoint*>);
+		waypoint_bytes += stringHeapBytes(name) + stringHeapBytes(waypoint->name);
+	}
+	add("Waypoints", map.waypoints.waypoints.size(), waypoint_bytes);
+
+	uint64_t zone_bytes = 0;
+	uint64_t zone_count = 0;
+	for (const auto &[name, id] : map.zones) {
+		zone_bytes += MemoryTreeNodeOverhead + sizeof(std::pair<const std::string, unsigned int>) + stringHeapBytes(name);
+		++zone_count;
+	}
+	add("Zones", zone_count, zone_bytes);
+
+	const ItemIdRegistry &ids = map.getItemIds();
+	add("Unique and action ids", ids.uniqueIdCount() + ids.actionIdCount(), ids.memsize());
+	add("Item index", 0, map.getItemIndexMemsize());
+	add("Zone index", map.getZoneIndex().size(), map.getZoneIndex().memsize());
+	add("Walkability map", map.getWalkability().getWalkable().count(), map.getWalkability().memsize());
+}
+
+void MemoryReport::addEditor(Editor &editor) {
+	addMap(editor.getMap());
+
+	if (const ActionQueue* history = editor.getHistoryActions()) {
+		add("Undo history", history->size(), history->getMemoryUsage());
+	}
+	if (const LiveServer* server = editor.GetLiveServer()) {
+		add("Live session buffers", 1, server->getBufferMemsize());
+	}
+	if (const LiveClient* client = editor.GetLiveClient()) {
+		add("Live session buffers", 1, client->getBufferMemsize());
+	}
+}
+
+void MemoryReport::addGraphics(const GraphicManager &gfx) {
+	const GraphicManager::CacheUsage usage = gfx.getCacheUsage();
+	add("Sprites", usage.sprites, usage.sprites * sizeof(GameSprite));
+	add("Sprite images", usage.images, usage.image_bytes);
+	add("Textures (driver memory)", usage.textures, usage.texture_bytes);
+}
+
+void MemoryReport::addItemPools() {
+	add("Item pools, unused reserve", 0, Item::getReservedBytes() - Item::getUsedBytes());
+	add("Item property table", g_items.getMaxID(), g_items.getPropertyTableMemsize());
+}
+
+uint64_t MemoryReport::getTotalBytes() const noexcept {
+	uint64_t total = 0;
+	for (const Entry &entry : entries) {
+		total += entry.bytes;
+	}
+	return total;
+}
+
+std::string MemoryReport::toString() const {
+	std::ostringstream os;
+	os << std::left << std::setw(32) << "Category" << std::right << std::setw(12) << "Count" << std::setw(14) << "KB" << "\n";
+	for (const Entry &entry : entries) {
+		os << std::left << std::setw(32) << entry.category << std::right << std::setw(12);
+		if (entry.count > 0) {
+			os << entry.count;
+		} else {
+			os << "";
+		}
+		os << std::setw(14) << entry.bytes / 1024 << "\n";
+	}
+	os << std::left << std::setw(32) << "Total" << std::right << std::setw(12) << "" << std::setw(14) << getTotalBytes() / 1024 << "\n";
+	return os.str();
+}
@@ -0,0 +1,59 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MEMORY_REPORT_H
+#define RME_MEMORY_REPORT_H
+
+class Map;
+class Editor;
+class GraphicManager;
+
+// Breakdown of the memory held by the editor, by category.
+// Sizes are computed from the data structures, allocator overhead of the heap is not included,
+// the slab pools report the memory they reserved on top of what is in use.
+class MemoryReport {
+public:
+	struct Entry {
+		std::string category;
+		uint64_t count = 0;
+		uint64_t bytes = 0;
+	};
+
+	// Adds to the category if it is already in the report
+	void add(const std::string &category, uint64_t count, uint64_t bytes);
+
+	// Hextree, tiles, items by type, attributes, creatures and the map wide lists
+	void addMap(Map &map);
+	// The map plus the undo history and the live session buffers
+	void addEditor(Editor &editor);
+	// Sprite metadata and texture caches
+	void addGraphics(const GraphicManager &gfx);
+	// Item pools are shared by every map, the undo history and the copy buffer
+	void addItemPools();
+
+	const std::vector<Entry> &getEntries() const noexcept {
+		return entries;
+	}
+	uint64_t getTotalBytes() const noexcept;
+
+	std::string toString() const;
+
+private:
+	std::vector<Entry> entries;
+};
+
+#endif
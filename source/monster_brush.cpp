@@ -23,6 +23,7 @@
 #include "monster.h"
 #include "basemap.h"
 #include "spawn_monster.h"
+#include "map.h"
 
 //=============================================================================
 // Monster brush
@@ -49,10 +50,16 @@ std::string MonsterBrush::getName() const {
 	return "Monster Brush";
 }
 
+// Spawn areas are looked up in the map's spawn index, a scratch map has no spawns
+static bool isInMonsterSpawn(BaseMap* map, const Position &position) {
+	const Map* real_map = dynamic_cast<Map*>(map);
+	return real_map && real_map->spawnsMonster.isCovered(position);
+}
+
 bool MonsterBrush::canDraw(BaseMap* map, const Position &position) const {
 	Tile* tile = map->getTile(position);
 	if (monster_type && tile && !tile->isBlocking()) {
-		if (tile->getLocation()->getSpawnMonsterCount() != 0 || g_settings.getInteger(Config::AUTO_CREATE_SPAWN_MONSTER)) {
+		if (isInMonsterSpawn(map, position) || g_settings.getInteger(Config::AUTO_CREATE_SPAWN_MONSTER)) {
 			if (tile->isPZ()) {
 				return false;
 			} else {
@@ -86,7 +93,7 @@ void MonsterBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 	if (canDraw(map, tile->getPosition())) {
 		undraw(map, tile);
 		if (monster_type) {
-			if (tile->spawnMonster == nullptr && tile->getLocation()->getSpawnMonsterCount() == 0) {
+			if (tile->spawnMonster == nullptr && !isInMonsterSpawn(map, tile->getPosition())) {
 				// manually place spawnMonster on location
 				tile->spawnMonster = newd SpawnMonster(1);
 			}
@@ -0,0 +1,140 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#include "main.h"
+
+#include "name_index.h"
+
+uint32_t NameIndex::add(const std::string &name) {
+	const uint32_t handle = names.size();
+	names.push_back(as_lower_str(name));
+
+	const std::string &folded = names.back();
+	for (size_t i = 0; i + 3 <= folded.size(); ++i) {
+		std::vector<uint32_t> &handles = trigrams[trigram(folded.data() + i)];
+		// A name repeating a trigram is only listed once
+		if (handles.empty() || handles.back() != handle) {
+			handles.push_back(handle);
+		}
+	}
+
+	last_text.clear();
+	last_matches.clear();
+	return handle;
+}
+
+void NameIndex::clear() {
+	names.clear();
+	trigrams.clear();
+	last_text.clear();
+	last_matches.clear();
+}
+
+std::vector<uint32_t> NameIndex::findCandidates(const std::string &text) const {
+	std::vector<uint32_t> candidates;
+	if (!last_text.empty() && text.find(last_text) != std::string::npos) {
+		// Whatever contains the new text also contained the previous one
+		candidates = last_matches;
+	} else if (text.size() >= 3) {
+		// Start from the rarest trigram, the others can only shrink it
+		std::vector<const std::vector<uint32_t>*> lists;
+		for (size_t i = 0; i + 3 <= text.size(); ++i) {
+			auto it = trigrams.find(trigram(text.data() + i));
+			if (it == trigrams.end()) {
+				return candidates;
+			}
+			lists.push_back(&it->second);
+		}
+		std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) {
+			return a->size() < b->size();
+		});
+
+		candidates = *lists.front();
+		for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+			std::vector<uint32_t> both;
+			std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(), std::back_inserter(both));
+			candidates.swap(both);
+		}
+	} else {
+		candidates.resize(names.size());
+		for (uint32_t handle = 0; handle < names.size(); ++handle) {
+			candidates[handle] = handle;
+		}
+	}
+	return candidates;
+}
+
+std::vector<uint32_t> NameIndex::find(const std::string &text) const {
+	const std::string folded = as_lower_str(text);
+	if (folded.empty()) {
+		return {};
+	}
+
+	// The trigrams only say a name may match, the order of them is checked here
+	std::vector<uint32_t> matches;
+	std::vector<std::pair<uint8_t, uint32_t>> ranked;
+	for (const uint32_t handle : findCandidates(folded)) {
+		const std::string &name = names[handle];
+		const size_t offset = name.find(folded);
+		if (offset == std::string::npos) {
+			continue;
+		}
+
+		uint8_t rank = 3;
+		if (offset == 0) {
+			rank = name.size() == folded.size() ? 0 : 1;
+		} else if (!isalnum(uint8_t(name[offset - 1]))) {
+			rank = 2;
+		} else {
+			// A later occurrence may still start a word
+			for (size_t next = name.find(folded, offset + 1); next != std::string::npos; next = name.find(folded, next + 1)) {
+				if (!isalnum(uint8_t(name[next - 1]))) {
+					rank = 2;
+					break;
+				}
+			}
+		}
+		matches.push_back(handle);
+		ranked.emplace_back(rank, handle);
+	}
+
+	last_text = folded;
+	last_matches = std::move(matches);
+
+	std::stable_sort(ranked.begin(), ranked.end(), [](const auto &a, const auto &b) {
+		return a.first < b.first;
+	});
+
+	std::vector<uint32_t> result;
+	result.reserve(ranked.size());
+	for (const auto &[rank, handle] : ranked) {
+		result.push_back(handle);
+	}
+	return result;
+}
+
+uint64_t NameIndex::memsize() const {
+	uint64_t mem = sizeof(*this) + names.capacity() * sizeof(std::string);
+	for (const std::string &name : names) {
+		mem += name.capacity();
+	}
+	for (const auto &[key, handles] : trigrams) {
+		mem += sizeof(key) + sizeof(handles) + handles.capacity() * sizeof(uint32_t);
+	}
+	return mem;
+}
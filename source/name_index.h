@@ -0,0 +1,64 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_NAME_INDEX_H
+#define RME_NAME_INDEX_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Case folded substring search over a fixed list of names, built once when the
+// data is loaded. Queries of three or more characters only look at the names
+// sharing all of their trigrams, and a query typed on top of the previous one
+// only filters the previous matches.
+class NameIndex {
+public:
+	// Returns the handle of the name, handles count up from 0 in insertion order
+	uint32_t add(const std::string &name);
+	void clear();
+
+	// Handles of the names containing text, best first: the whole name, a prefix,
+	// the start of a word and then anywhere. Ties keep the insertion order.
+	std::vector<uint32_t> find(const std::string &text) const;
+
+	size_t size() const noexcept {
+		return names.size();
+	}
+	bool empty() const noexcept {
+		return names.empty();
+	}
+
+	uint64_t memsize() const;
+
+private:
+	static uint32_t trigram(const char* text) noexcept {
+		return (uint32_t(uint8_t(text[0])) << 16) | (uint32_t(uint8_t(text[1])) << 8) | uint8_t(text[2]);
+	}
+
+	std::vector<uint32_t> findCandidates(const std::string &text) const;
+
+	std::vector<std::string> names; // Lower case
+	std::unordered_map<uint32_t, std::vector<uint32_t>> trigrams; // Sorted handles per trigram
+
+	// Matches of the last query in handle order, to narrow down while typing
+	mutable std::string last_text;
+	mutable std::vector<uint32_t> last_matches;
+};
+
+#endif
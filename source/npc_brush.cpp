@@ -23,6 +23,7 @@
 #include "npc.h"
 #include "basemap.h"
 #include "spawn_npc.h"
+#include "map.h"
 
 //=============================================================================
 // Npc brush
@@ -48,10 +49,16 @@ std::string NpcBrush::getName() const {
 	return "Npc Brush";
 }
 
+// Spawn areas are looked up in the map's spawn index, a scratch map has no spawns
+static bool isInNpcSpawn(BaseMap* map, const Position &position) {
+	const Map* real_map = dynamic_cast<Map*>(map);
+	return real_map && real_map->spawnsNpc.isCovered(position);
+}
+
 bool NpcBrush::canDraw(BaseMap* map, const Position &position) const {
 	Tile* tile = map->getTile(position);
 	if (npc_type && tile && !tile->isBlocking()) {
-		if (tile->getLocation()->getSpawnNpcCount() != 0 || g_settings.getInteger(Config::AUTO_CREATE_SPAWN_NPC)) {
+		if (isInNpcSpawn(map, position) || g_settings.getInteger(Config::AUTO_CREATE_SPAWN_NPC)) {
 			if (tile->isPZ()) {
 				return true;
 			} else {
@@ -73,7 +80,7 @@ void NpcBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 	if (canDraw(map, tile->getPosition())) {
 		undraw(map, tile);
 		if (npc_type) {
-			if (tile->spawnNpc == nullptr && tile->getLocation()->getSpawnNpcCount() == 0) {
+			if (tile->spawnNpc == nullptr && !isInNpcSpawn(map, tile->getPosition())) {
 				// manually place npc spawn on location
 				tile->spawnNpc = newd SpawnNpc(1);
 			}
@@ -112,6 +112,11 @@ void HousePalettePanel::SetMap(Map* m) {
 
 void HousePalettePanel::OnSwitchIn() {
 	PalettePanel::OnSwitchIn();
+	// The houses of a lazily opened map are only all known once every tile was read
+	if (map && map->hasPendingTiles()) {
+		map->loadRemainingTiles();
+		OnUpdate();
+	}
 	// Extremely ugly hack to fix layout issue
 	if (do_resize_on_display) {
 		fix_size_timer.Start(100, true);
@@ -329,12 +334,15 @@ void HousePalettePanel::OnListBoxDoubleClick(wxCommandEvent &event) {
 			return;
 		}
 
-		// find a valid tile position
-		for (const Position &tilePosition : house->getTiles()) {
-			if (tilePosition.isValid()) {
-				g_gui.SetScreenCenterPosition(tilePosition);
-				break;
-			}
+		// Middle of the house on its lowest floor, or its first tile when that is outside the house
+		const Position &minBound = house->getMinBound();
+		const Position &maxBound = house->getMaxBound();
+		Position center((minBound.x + maxBound.x) / 2, (minBound.y + maxBound.y) / 2, maxBound.z);
+		if (!house->hasTile(center) && !house->getTiles().empty()) {
+			center = house->getTiles().begin()->first;
+		}
+		if (center.isValid()) {
+			g_gui.SetScreenCenterPosition(center);
 		}
 	}
 }
@@ -354,6 +362,9 @@ void HousePalettePanel::OnClickAddHouse(wxCommandEvent &event) {
 		return;
 	}
 
+	// A house of a block that wasn't read yet could get the same id
+	map->loadRemainingTiles();
+
 	House* new_house = newd House(*map);
 	new_house->id = map->houses.getEmptyID();
 
@@ -372,6 +383,21 @@ void HousePalettePanel::OnClickAddHouse(wxCommandEvent &event) {
 	refresh_timer.Start(300, true);
 }
 
+House* HousePalettePanel::LoadRemainingHouses(House* house) {
+	if (!house || !map->hasPendingTiles()) {
+		return house;
+	}
+
+	// The house file is read with the last block, and drops the houses without a town
+	const uint32_t id = house->id;
+	map->loadRemainingTiles();
+	house = map->houses.getHouse(id);
+	if (!house) {
+		OnUpdate();
+	}
+	return house;
+}
+
 void HousePalettePanel::OnClickEditHouse(wxCommandEvent &event) {
 	if (house_list->GetCount() == 0) {
 		return;
@@ -380,7 +406,7 @@ void HousePalettePanel::OnClickEditHouse(wxCommandEvent &event) {
 		return;
 	}
 	int selection = house_list->GetSelection();
-	House* house = reinterpret_cast<House*>(house_list->GetClientData(selection));
+	House* house = LoadRemainingHouses(reinterpret_cast<House*>(house_list->GetClientData(selection)));
 	if (house) {
 		wxDialog* d = newd EditHouseDialog(g_gui.root, map, house);
 		int ret = d->ShowModal();
@@ -396,8 +422,12 @@ void HousePalettePanel::OnClickEditHouse(wxCommandEvent &event) {
 void HousePalettePanel::OnClickRemoveHouse(wxCommandEvent &event) {
 	int selection = house_list->GetSelection();
 	if (selection != wxNOT_FOUND) {
-		House* house = reinterpret_cast<House*>(house_list->GetClientData(selection));
+		House* house = LoadRemainingHouses(reinterpret_cast<House*>(house_list->GetClientData(selection)));
+		if (!house) {
+			return;
+		}
 		map->houses.removeHouse(house);
+		map->doChange();
 		house_list->Delete(selection);
 		refresh_timer.Start(300, true);
 
@@ -54,6 +54,8 @@ protected:
 	void SelectHouse(size_t index);
 
 	House* GetCurrentlySelectedHouse() const;
+	// Reads the rest of a lazily opened map before house is edited, nullptr if it was dropped then
+	House* LoadRemainingHouses(House* house);
 
 	void SelectHouseBrush();
 	void SelectExitBrush();
@@ -18,8 +18,12 @@
 #ifndef __POSITION_HPP__
 #define __POSITION_HPP__
 
+#include "const.h"
+
+#include <istream>
 #include <ostream>
 #include <cstdint>
+#include <functional>
 #include <vector>
 #include <list>
 
@@ -94,6 +98,16 @@ public:
 	}
 };
 
+template <>
+struct std::hash<Position> {
+	size_t operator()(const Position &pos) const noexcept {
+		// Map coordinates fit in 16 bits, floors in 4. The floor is folded into the low bits
+		// as well, so it still counts where size_t is 32 bits
+		const uint64_t key = uint64_t(static_cast<uint16_t>(pos.x)) | uint64_t(static_cast<uint16_t>(pos.y)) << 16 | uint64_t(pos.z & 0xF) << 32;
+		return static_cast<size_t>(key ^ (key >> 32));
+	}
+};
+
 inline std::ostream &operator<<(std::ostream &os, const Position &pos) {
 	os << pos.x << ':' << pos.y << ':' << pos.z;
 	return os;
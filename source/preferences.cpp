@@ -106,6 +106,16 @@ wxNotebookPage* PreferencesWindow::CreateGeneralPage() {
 	grid_sizer->Add(undo_mem_size_spin, 0);
 	SetWindowToolTip(tmptext, undo_mem_size_spin, "The approximite limit for the memory usage of the undo queue.");
 
+	grid_sizer->Add(tmptext = newd wxStaticText(general_page, wxID_ANY, "Item index maximum memory size (MB): "), 0);
+	item_index_mem_size_spin = newd wxSpinCtrl(general_page, wxID_ANY, i2ws(g_settings.getInteger(Config::ITEM_INDEX_MEM_SIZE)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 4096);
+	grid_sizer->Add(item_index_mem_size_spin, 0);
+	SetWindowToolTip(tmptext, item_index_mem_size_spin, "Memory the index used to find and replace items quickly may take. Larger maps need more, 0 turns the index off and every search walks the whole map.");
+
+	grid_sizer->Add(tmptext = newd wxStaticText(general_page, wxID_ANY, "Open maps lazily from size (MB): "), 0);
+	lazy_load_map_size_spin = newd wxSpinCtrl(general_page, wxID_ANY, i2ws(g_settings.getInteger(Config::LAZY_LOAD_MAP_SIZE)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 65536);
+	grid_sizer->Add(lazy_load_map_size_spin, 0);
+	SetWindowToolTip(tmptext, lazy_load_map_size_spin, "Maps this large open right away and read their tiles as you look at them, the rest is read in the background. Houses and spawns show up once everything was read. 0 always reads the whole map before opening it.");
+
 	grid_sizer->Add(tmptext = newd wxStaticText(general_page, wxID_ANY, "Worker Threads: "), 0);
 	worker_threads_spin = newd wxSpinCtrl(general_page, wxID_ANY, i2ws(g_settings.getInteger(Config::WORKER_THREADS)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 1, 64);
 	grid_sizer->Add(worker_threads_spin, 0);
@@ -619,6 +629,8 @@ void PreferencesWindow::Apply() {
 	g_settings.setInteger(Config::ONLY_ONE_INSTANCE, only_one_instance_chkbox->GetValue());
 	g_settings.setInteger(Config::UNDO_SIZE, undo_size_spin->GetValue());
 	g_settings.setInteger(Config::UNDO_MEM_SIZE, undo_mem_size_spin->GetValue());
+	g_settings.setInteger(Config::ITEM_INDEX_MEM_SIZE, item_index_mem_size_spin->GetValue());
+	g_settings.setInteger(Config::LAZY_LOAD_MAP_SIZE, lazy_load_map_size_spin->GetValue());
 	g_settings.setInteger(Config::WORKER_THREADS, worker_threads_spin->GetValue());
 	g_settings.setInteger(Config::REPLACE_SIZE, replace_size_spin->GetValue());
 	g_settings.setInteger(Config::DELETE_BACKUP_DAYS, delete_backup_days_spin->GetValue());
@@ -49,6 +49,8 @@ protected:
 	wxCheckBox* enable_tileset_editing_chkbox;
 	wxSpinCtrl* undo_size_spin;
 	wxSpinCtrl* undo_mem_size_spin;
+	wxSpinCtrl* item_index_mem_size_spin;
+	wxSpinCtrl* lazy_load_map_size_spin;
 	wxSpinCtrl* worker_threads_spin;
 	wxSpinCtrl* replace_size_spin;
 	wxSpinCtrl* delete_backup_days_spin;
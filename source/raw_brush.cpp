@@ -61,14 +61,12 @@ std::string RAWBrush::getName() const {
 
 void RAWBrush::undraw(BaseMap* map, Tile* tile) {
 	if (tile->ground && tile->ground->getID() == itemtype->id) {
-		delete tile->ground;
-		tile->ground = nullptr;
+		tile->setGround(nullptr);
 	}
-	for (ItemVector::iterator iter = tile->items.begin(); iter != tile->items.end();) {
+	for (TileItems::iterator iter = tile->items.begin(); iter != tile->items.end();) {
 		Item* item = *iter;
 		if (item->getID() == itemtype->id) {
-			delete item;
-			iter = tile->items.erase(iter);
+			iter = tile->destroyItem(iter);
 		} else {
 			++iter;
 		}
@@ -82,11 +80,10 @@ void RAWBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 
 	bool b = parameter ? *reinterpret_cast<bool*>(parameter) : false;
 	if ((g_settings.getInteger(Config::RAW_LIKE_SIMONE) && !b) && itemtype->alwaysOnBottom && itemtype->alwaysOnTopOrder == 2) {
-		for (ItemVector::iterator iter = tile->items.begin(); iter != tile->items.end();) {
+		for (TileItems::iterator iter = tile->items.begin(); iter != tile->items.end();) {
 			Item* item = *iter;
 			if (item->getTopOrder() == itemtype->alwaysOnTopOrder) {
-				delete item;
-				iter = tile->items.erase(iter);
+				iter = tile->destroyItem(iter);
 			} else {
 				++iter;
 			}
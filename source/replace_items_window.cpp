@@ -335,7 +335,7 @@ void ReplaceItemsDialog::OnExecuteButtonClicked(wxCommandEvent &WXUNUSED(event))
 		ItemFinder finder(info.replaceId, (uint32_t)g_settings.getInteger(Config::REPLACE_SIZE));
 
 		// search on map
-		foreach_ItemOnMap(editor->getMap(), finder, selectionOnly);
+		foreach_ItemWithIdOnMap(editor->getMap(), info.replaceId, finder, selectionOnly);
 
 		uint32_t total = 0;
 		const auto &result = finder.result;
@@ -51,10 +51,12 @@ class Brush;
 
 #include <unordered_set>
 
+#include "small_vector.h"
+
 typedef std::vector<uint32_t> HouseExitList;
 typedef std::vector<Tile*> TileVector;
 typedef std::unordered_set<Tile*> TileSet;
-typedef std::vector<Item*> ItemVector;
+typedef SmallVector<Item*, 3> ItemVector; // Most tiles carry no more than a few items
 typedef std::vector<Brush*> BrushVector;
 
 #endif
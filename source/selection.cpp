@@ -384,16 +384,9 @@ wxThread::ExitCode SelectionThread::Entry() {
 	selection.start(Selection::SUBTHREAD);
 	bool compesated = g_settings.getInteger(Config::COMPENSATED_SELECT);
 	for (int z = start.z; z >= end.z; --z) {
-		for (int x = start.x; x <= end.x; ++x) {
-			for (int y = start.y; y <= end.y; ++y) {
-				Tile* tile = editor.getMap().getTile(x, y, z);
-				if (!tile) {
-					continue;
-				}
-
-				selection.add(tile);
-			}
-		}
+		editor.getMap().visitRegion(Position(start.x, start.y, z), Position(end.x, end.y, z), [&](Tile* tile) {
+			selection.add(tile);
+		});
 		if (compesated && z <= rme::MapGroundLayer) {
 			++start.x;
 			++start.y;
@@ -235,6 +235,8 @@ void Settings::IO(IOMode mode) {
 	Int(MERGE_PASTE, 0);
 	Int(UNDO_SIZE, 400);
 	Int(UNDO_MEM_SIZE, 40);
+	Int(ITEM_INDEX_MEM_SIZE, 256);
+	Int(LAZY_LOAD_MAP_SIZE, 0);
 	Int(GROUP_ACTIONS, 1);
 	Int(SELECTION_TYPE, SELECT_CURRENT_FLOOR);
 	Int(COMPENSATED_SELECT, 1);
@@ -72,6 +72,8 @@ namespace Config {
 		ZOOM_SPEED,
 		UNDO_SIZE,
 		UNDO_MEM_SIZE,
+		ITEM_INDEX_MEM_SIZE,
+		LAZY_LOAD_MAP_SIZE,
 		MERGE_PASTE,
 		SELECTION_TYPE,
 		COMPENSATED_SELECT,
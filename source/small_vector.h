@@ -0,0 +1,311 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_SMALL_VECTOR_H
+#define RME_SMALL_VECTOR_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+// Drop-in for std::vector that keeps up to N elements inside the object itself and only
+// allocates once it grows past that. Meant for the millions of short lists hanging off tiles,
+// so it is limited to trivially copyable elements and moves them around with memcpy.
+// Iterators are plain pointers and are invalidated like std::vector's, and also by moving the vector.
+template <typename T, uint32_t N>
+class SmallVector {
+	static_assert(std::is_trivially_copyable_v<T>, "SmallVector only holds trivially copyable types");
+	static_assert(N > 0, "SmallVector needs some inline room");
+
+public:
+	using value_type = T;
+	using size_type = size_t;
+	using difference_type = std::ptrdiff_t;
+	using reference = T &;
+	using const_reference = const T &;
+	using pointer = T*;
+	using const_pointer = const T*;
+	using iterator = T*;
+	using const_iterator = const T*;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	SmallVector() noexcept :
+		count(0), room(N) { }
+	SmallVector(std::initializer_list<T> list) :
+		SmallVector() {
+		insert(end(), list.begin(), list.end());
+	}
+	template <typename Iter, typename = std::enable_if_t<!std::is_integral_v<Iter>>>
+	SmallVector(Iter first, Iter last) :
+		SmallVector() {
+		insert(end(), first, last);
+	}
+	SmallVector(const SmallVector &other) :
+		SmallVector() {
+		*this = other;
+	}
+	SmallVector(SmallVector &&other) noexcept :
+		SmallVector() {
+		*this = std::move(other);
+	}
+	~SmallVector() {
+		release();
+	}
+
+	SmallVector &operator=(const SmallVector &other) {
+		if (this != &other) {
+			count = 0;
+			reserve(other.count);
+			std::memcpy(data(), other.data(), other.count * sizeof(T));
+			count = other.count;
+		}
+		return *this;
+	}
+	SmallVector &operator=(SmallVector &&other) noexcept {
+		if (this != &other) {
+			release();
+			if (other.isInline()) {
+				std::memcpy(local, other.local, other.count * sizeof(T));
+			} else {
+				heap = other.heap;
+				room = other.room;
+				other.room = N;
+			}
+			count = other.count;
+			other.count = 0;
+		}
+		return *this;
+	}
+
+	bool operator==(const SmallVector &other) const {
+		return std::equal(begin(), end(), other.begin(), other.end());
+	}
+	bool operator!=(const SmallVector &other) const {
+		return !(*this == other);
+	}
+
+	// Access
+	T* data() noexcept {
+		return isInline() ? local : heap;
+	}
+	const T* data() const noexcept {
+		return isInline() ? local : heap;
+	}
+	T &operator[](size_t index) noexcept {
+		return data()[index];
+	}
+	const T &operator[](size_t index) const noexcept {
+		return data()[index];
+	}
+	T &at(size_t index) {
+		if (index >= count) {
+			throw std::out_of_range("SmallVector::at");
+		}
+		return data()[index];
+	}
+	const T &at(size_t index) const {
+		if (index >= count) {
+			throw std::out_of_range("SmallVector::at");
+		}
+		return data()[index];
+	}
+	T &front() noexcept {
+		return data()[0];
+	}
+	const T &front() const noexcept {
+		return data()[0];
+	}
+	T &back() noexcept {
+		return data()[count - 1];
+	}
+	const T &back() const noexcept {
+		return data()[count - 1];
+	}
+
+	// Iterators
+	iterator begin() noexcept {
+		return data();
+	}
+	const_iterator begin() const noexcept {
+		return data();
+	}
+	const_iterator cbegin() const noexcept {
+		return data();
+	}
+	iterator end() noexcept {
+		return data() + count;
+	}
+	const_iterator end() const noexcept {
+		return data() + count;
+	}
+	const_iterator cend() const noexcept {
+		return data() + count;
+	}
+	reverse_iterator rbegin() noexcept {
+		return reverse_iterator(end());
+	}
+	const_reverse_iterator rbegin() const noexcept {
+		return const_reverse_iterator(end());
+	}
+	reverse_iterator rend() noexcept {
+		return reverse_iterator(begin());
+	}
+	const_reverse_iterator rend() const noexcept {
+		return const_reverse_iterator(begin());
+	}
+
+	// Size
+	bool empty() const noexcept {
+		return count == 0;
+	}
+	size_t size() const noexcept {
+		return count;
+	}
+	size_t capacity() const noexcept {
+		return room;
+	}
+	// True while the elements still fit inside the object
+	bool isInline() const noexcept {
+		return room == N;
+	}
+	// Memory held outside the object
+	size_t getHeapBytes() const noexcept {
+		return isInline() ? 0 : room * sizeof(T);
+	}
+
+	void reserve(size_t wanted) {
+		if (wanted > room) {
+			grow(wanted);
+		}
+	}
+	void shrink_to_fit() {
+		if (!isInline() && count <= N) {
+			T* old = heap;
+			std::memcpy(local, old, count * sizeof(T));
+			::operator delete(old);
+			room = N;
+		}
+	}
+	void resize(size_t wanted, const T &value = T()) {
+		if (wanted > count) {
+			const T copy = value;
+			reserve(wanted);
+			std::fill(data() + count, data() + wanted, copy);
+		}
+		count = static_cast<uint32_t>(wanted);
+	}
+
+	// Changes
+	void clear() noexcept {
+		count = 0;
+	}
+	void push_back(const T &value) {
+		if (count == room) {
+			const T copy = value; // May live in the storage that is about to move
+			grow(count + 1);
+			data()[count++] = copy;
+		} else {
+			data()[count++] = value;
+		}
+	}
+	template <typename... Args>
+	T &emplace_back(Args &&... args) {
+		push_back(T(std::forward<Args>(args)...));
+		return back();
+	}
+	void pop_back() noexcept {
+		--count;
+	}
+
+	iterator insert(const_iterator position, const T &value) {
+		const size_t index = position - begin();
+		const T copy = value;
+		reserve(count + 1);
+		T* at = data() + index;
+		std::memmove(at + 1, at, (count - index) * sizeof(T));
+		*at = copy;
+		++count;
+		return at;
+	}
+	template <typename Iter, typename = std::enable_if_t<!std::is_integral_v<Iter>>>
+	iterator insert(const_iterator position, Iter first, Iter last) {
+		if constexpr (std::is_pointer_v<Iter>) {
+			// A range out of this vector moves while making room, insert a copy of it instead
+			std::less<const T*> before;
+			if (first != last && !before(first, data()) && before(first, data() + count)) {
+				const SmallVector copy(first, last);
+				return insert(position, copy.begin(), copy.end());
+			}
+		}
+		const size_t index = position - begin();
+		const size_t added = std::distance(first, last);
+		reserve(count + added);
+		T* at = data() + index;
+		std::memmove(at + added, at, (count - index) * sizeof(T));
+		std::copy(first, last, at);
+		count += static_cast<uint32_t>(added);
+		return at;
+	}
+	iterator erase(const_iterator position) {
+		return erase(position, position + 1);
+	}
+	iterator erase(const_iterator first, const_iterator last) {
+		T* at = begin() + (first - begin());
+		const size_t removed = last - first;
+		std::memmove(at, at + removed, (end() - at - removed) * sizeof(T));
+		count -= static_cast<uint32_t>(removed);
+		return at;
+	}
+
+	void swap(SmallVector &other) noexcept {
+		SmallVector moved(std::move(other));
+		other = std::move(*this);
+		*this = std::move(moved);
+	}
+
+private:
+	void grow(size_t wanted) {
+		const size_t next = std::max<size_t>(wanted, room * 2);
+		T* storage = static_cast<T*>(::operator new(next * sizeof(T)));
+		std::memcpy(storage, data(), count * sizeof(T));
+		release();
+		heap = storage;
+		room = static_cast<uint32_t>(next);
+	}
+	void release() noexcept {
+		if (!isInline()) {
+			::operator delete(heap);
+			room = N;
+		}
+	}
+
+	union {
+		T local[N];
+		T* heap;
+	};
+	uint32_t count;
+	uint32_t room; // N while the elements are kept inline
+};
+
+#endif
@@ -0,0 +1,126 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#include "main.h"
+
+#include "spawn_index.h"
+
+template <typename Func>
+void SpawnIndex::forEachCell(const Area &area, Func func) {
+	const int startX = cellOf(area.center.x - area.radius);
+	const int endX = cellOf(area.center.x + area.radius);
+	const int startY = cellOf(area.center.y - area.radius);
+	const int endY = cellOf(area.center.y + area.radius);
+	for (int y = startY; y <= endY; ++y) {
+		for (int x = startX; x <= endX; ++x) {
+			func(cellKey(x, y, area.center.z));
+		}
+	}
+}
+
+void SpawnIndex::insert(const Position &center, int radius) {
+	erase(center);
+
+	const Area area { center, radius };
+	radii.emplace(centerKey(center), radius);
+	forEachCell(area, [&](uint64_t key) {
+		cells[key].push_back(area);
+	});
+}
+
+void SpawnIndex::erase(const Position &center) {
+	auto it = radii.find(centerKey(center));
+	if (it == radii.end()) {
+		return;
+	}
+
+	const Area area { center, it->second };
+	radii.erase(it);
+	forEachCell(area, [&](uint64_t key) {
+		auto cell = cells.find(key);
+		if (cell == cells.end()) {
+			return;
+		}
+
+		std::vector<Area> &areas = cell->second;
+		for (auto iter = areas.begin(); iter != areas.end(); ++iter) {
+			if (iter->center == center) {
+				*iter = areas.back();
+				areas.pop_back();
+				break;
+			}
+		}
+		if (areas.empty()) {
+			cells.erase(cell);
+		}
+	});
+}
+
+void SpawnIndex::clear() {
+	cells.clear();
+	radii.clear();
+}
+
+int SpawnIndex::getRadius(const Position &center) const {
+	auto it = radii.find(centerKey(center));
+	return it != radii.end() ? it->second : -1;
+}
+
+std::vector<SpawnIndex::Area> SpawnIndex::getCovering(const Position &position) const {
+	std::vector<Area> covering;
+	auto cell = cells.find(cellKey(cellOf(position.x), cellOf(position.y), position.z));
+	if (cell == cells.end()) {
+		return covering;
+	}
+
+	for (const Area &area : cell->second) {
+		if (area.covers(position)) {
+			covering.push_back(area);
+		}
+	}
+
+	std::sort(covering.begin(), covering.end(), [&position](const Area &a, const Area &b) {
+		const int distanceA = a.distance(position);
+		const int distanceB = b.distance(position);
+		if (distanceA != distanceB) {
+			return distanceA < distanceB;
+		}
+		return a.center < b.center;
+	});
+	return covering;
+}
+
+bool SpawnIndex::isCovered(const Position &position) const {
+	auto cell = cells.find(cellKey(cellOf(position.x), cellOf(position.y), position.z));
+	if (cell == cells.end()) {
+		return false;
+	}
+	return std::any_of(cell->second.begin(), cell->second.end(), [&position](const Area &area) {
+		return area.covers(position);
+	});
+}
+
+uint64_t SpawnIndex::memsize() const {
+	constexpr uint64_t HashNodeOverhead = 2 * sizeof(void*);
+	uint64_t bytes = (cells.bucket_count() + radii.bucket_count()) * sizeof(void*);
+	bytes += radii.size() * (HashNodeOverhead + sizeof(std::pair<const uint64_t, int>));
+	for (const auto &[key, areas] : cells) {
+		bytes += HashNodeOverhead + sizeof(std::pair<const uint64_t, std::vector<Area>>) + areas.capacity() * sizeof(Area);
+	}
+	return bytes;
+}
@@ -0,0 +1,80 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_SPAWN_INDEX_H_
+#define RME_SPAWN_INDEX_H_
+
+#include "position.h"
+
+#include <unordered_map>
+
+// Grid over the squares covered by spawns, so the spawns around a position
+// are found without walking the map. A spawn is listed in every cell its square touches.
+class SpawnIndex {
+public:
+	static constexpr int CellSize = 32;
+
+	struct Area {
+		Position center;
+		int radius;
+
+		bool covers(const Position &position) const noexcept {
+			return position.z == center.z && std::abs(position.x - center.x) <= radius && std::abs(position.y - center.y) <= radius;
+		}
+		int distance(const Position &position) const noexcept {
+			return std::max(std::abs(position.x - center.x), std::abs(position.y - center.y));
+		}
+	};
+
+	// Replaces the area if a spawn is already centred there
+	void insert(const Position &center, int radius);
+	void erase(const Position &center);
+	void clear();
+
+	// -1 when no spawn is centred there
+	int getRadius(const Position &center) const;
+
+	// Every spawn whose square contains the position, nearest first
+	std::vector<Area> getCovering(const Position &position) const;
+	// True if any spawn's square contains the position
+	bool isCovered(const Position &position) const;
+
+	size_t size() const noexcept {
+		return radii.size();
+	}
+	uint64_t memsize() const;
+
+private:
+	static uint64_t cellKey(int cellX, int cellY, int z) noexcept {
+		return (static_cast<uint64_t>(z) << 40) | (static_cast<uint64_t>(static_cast<uint32_t>(cellY) & 0xFFFFF) << 20) | (static_cast<uint32_t>(cellX) & 0xFFFFF);
+	}
+	static uint64_t centerKey(const Position &center) noexcept {
+		return cellKey(center.x, center.y, center.z);
+	}
+	static int cellOf(int coordinate) noexcept {
+		return coordinate >= 0 ? coordinate / CellSize : (coordinate - CellSize + 1) / CellSize;
+	}
+
+	template <typename Func>
+	static void forEachCell(const Area &area, Func func);
+
+	std::unordered_map<uint64_t, std::vector<Area>> cells;
+	std::unordered_map<uint64_t, int> radii;
+};
+
+#endif
@@ -18,6 +18,8 @@
 #ifndef RME_SPAWN_MONSTER_H_
 #define RME_SPAWN_MONSTER_H_
 
+#include "spawn_index.h"
+
 class Tile;
 
 class SpawnMonster {
@@ -78,15 +80,36 @@ public:
 	SpawnMonsterPositionList::const_iterator end() const noexcept {
 		return spawnsMonster.end();
 	}
-	void erase(SpawnMonsterPositionList::iterator iter) noexcept {
+	void erase(SpawnMonsterPositionList::iterator iter) {
+		index.erase(*iter);
 		spawnsMonster.erase(iter);
 	}
 	SpawnMonsterPositionList::iterator find(Position &pos) {
 		return spawnsMonster.find(pos);
 	}
 
+	size_t size() const noexcept {
+		return spawnsMonster.size();
+	}
+
+	// Centres and radii of the spawns whose area contains the position, nearest first
+	std::vector<SpawnIndex::Area> getCovering(const Position &position) const {
+		return index.getCovering(position);
+	}
+	bool isCovered(const Position &position) const {
+		return index.isCovered(position);
+	}
+	// -1 when no spawn is centred there
+	int getRadius(const Position &center) const {
+		return index.getRadius(center);
+	}
+	uint64_t getIndexMemsize() const {
+		return index.memsize();
+	}
+
 private:
 	SpawnMonsterPositionList spawnsMonster;
+	SpawnIndex index;
 };
 
 #endif
@@ -18,6 +18,8 @@
 #ifndef RME_SPAWN_NPC_H_
 #define RME_SPAWN_NPC_H_
 
+#include "spawn_index.h"
+
 class Tile;
 
 class SpawnNpc {
@@ -78,15 +80,36 @@ public:
 	SpawnNpcPositionList::const_iterator end() const noexcept {
 		return spawnsNpc.end();
 	}
-	void erase(SpawnNpcPositionList::iterator iter) noexcept {
+	void erase(SpawnNpcPositionList::iterator iter) {
+		index.erase(*iter);
 		spawnsNpc.erase(iter);
 	}
 	SpawnNpcPositionList::iterator find(Position &pos) {
 		return spawnsNpc.find(pos);
 	}
 
+	size_t size() const noexcept {
+		return spawnsNpc.size();
+	}
+
+	// Centres and radii of the spawns whose area contains the position, nearest first
+	std::vector<SpawnIndex::Area> getCovering(const Position &position) const {
+		return index.getCovering(position);
+	}
+	bool isCovered(const Position &position) const {
+		return index.isCovered(position);
+	}
+	// -1 when no spawn is centred there
+	int getRadius(const Position &center) const {
+		return index.getRadius(center);
+	}
+	uint64_t getIndexMemsize() const {
+		return index.memsize();
+	}
+
 private:
 	SpawnNpcPositionList spawnsNpc;
+	SpawnIndex index;
 };
 
 #endif
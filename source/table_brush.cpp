@@ -115,13 +115,12 @@ bool TableBrush::canDraw(BaseMap* map, const Position &position) const {
 }
 
 void TableBrush::undraw(BaseMap* map, Tile* t) {
-	ItemVector::iterator it = t->items.begin();
+	TileItems::iterator it = t->items.begin();
 	while (it != t->items.end()) {
 		if ((*it)->isTable()) {
 			TableBrush* tb = (*it)->getTableBrush();
 			if (tb == this) {
-				delete *it;
-				it = t->items.erase(it);
+				it = t->destroyItem(it);
 			} else {
 				++it;
 			}
@@ -160,7 +159,7 @@ bool hasMatchingTableBrushAtTile(BaseMap* map, TableBrush* table_brush, uint32_t
 		return false;
 	}
 
-	ItemVector::const_iterator it = t->items.begin();
+	TileItems::const_iterator it = t->items.begin();
 	for (; it != t->items.end(); ++it) {
 		TableBrush* tb = (*it)->getTableBrush();
 		if (tb == table_brush) {
@@ -258,7 +257,7 @@ void TableBrush::doTables(BaseMap* map, Tile* tile) {
 		}
 
 		if (id != 0) {
-			item->setID(id);
+			tile->changeItem(item, [id](Item* table) { table->setID(id); });
 		}
 	}
 }
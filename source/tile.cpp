@@ -30,6 +30,12 @@
 #include "table_brush.h"
 #include "npc.h"
 #include "spawn_npc.h"
+#include "content_hash.h"
+
+// There are millions of these on a large map, keep them from quietly growing
+static_assert(sizeof(void*) != 8 || sizeof(Tile) <= 112, "Tile layout grew, check member order and padding");
+static_assert(sizeof(void*) != 8 || sizeof(TileLocation) <= 40, "TileLocation layout grew, check member order and padding");
+static_assert(sizeof(TileItems) == sizeof(uint64_t) * 3 + 2 * sizeof(uint32_t), "TileItems should not need more room than its inline slots");
 
 Tile::Tile(int x, int y, int z) :
 	location(nullptr),
@@ -41,7 +47,8 @@ Tile::Tile(int x, int y, int z) :
 	house_id(0),
 	mapflags(0),
 	statflags(0),
-	minimapColor(INVALID_MINIMAP_COLOR) {
+	minimapColor(INVALID_MINIMAP_COLOR),
+	state_counts {} {
 	////
 }
 
@@ -55,15 +62,12 @@ Tile::Tile(TileLocation &loc) :
 	house_id(0),
 	mapflags(0),
 	statflags(0),
-	minimapColor(INVALID_MINIMAP_COLOR) {
+	minimapColor(INVALID_MINIMAP_COLOR),
+	state_counts {} {
 	////
 }
 
 Tile::~Tile() {
-	while (!items.empty()) {
-		delete items.back();
-		items.pop_back();
-	}
 	delete monster;
 	// printf("%d,%d,%d,%p\n", tilePos.x, tilePos.y, tilePos.z, ground);
 	delete ground;
@@ -72,9 +76,24 @@ Tile::~Tile() {
 	delete spawnNpc;
 }
 
+void* Tile::operator new(size_t size) {
+	// Tiles that are not created through a map allocator share this pool
+	static SlabPool* pool = newd SlabPool(sizeof(Tile));
+	ASSERT(size == sizeof(Tile));
+	return pool->allocate();
+}
+
+void Tile::operator delete(void* block) {
+	if (block) {
+		SlabPool::getOwner(block)->deallocate(block);
+	}
+}
+
 Tile* Tile::deepCopy(BaseMap &map) const {
 	Tile* copy = map.allocator.allocateTile(location);
 	copy->flags = flags;
+	copy->minimapColor = minimapColor;
+	std::copy(std::begin(state_counts), std::end(state_counts), copy->state_counts);
 	copy->house_id = house_id;
 	if (spawnMonster) {
 		copy->spawnMonster = spawnMonster->deepCopy();
@@ -93,12 +112,8 @@ Tile* Tile::deepCopy(BaseMap &map) const {
 		copy->ground = ground->deepCopy();
 	}
 
-	for (const Item* item : items) {
-		copy->items.push_back(item->deepCopy());
-	}
-	for (unsigned int zone : zones) {
-		copy->zones.insert(zone);
-	}
+	copy->items.copyFrom(items);
+	copy->zones = zones;
 	return copy;
 }
 
@@ -108,13 +123,49 @@ uint32_t Tile::memsize() const {
 		mem += ground->memsize();
 	}
 
-	for (const Item* item : items) {
-		mem += item->memsize();
+	mem += items.memsize();
+	mem += zones.getHeapBytes();
+
+	return mem;
+}
+
+uint64_t Tile::getContentHash() const {
+	if (!ground && items.empty() && !monster && !spawnMonster && !npc && !spawnNpc && zones.empty() && house_id == 0 && getMapFlags() == 0) {
+		return ContentHash::Empty;
 	}
 
-	mem += sizeof(Item*) * items.capacity();
+	ContentHash hash;
+	hash.add(house_id);
+	hash.add(getMapFlags());
+	hash.add(zones.size());
+	for (const unsigned int zone : zones) {
+		hash.add(zone);
+	}
 
-	return mem;
+	hash.add(ground != nullptr);
+	if (ground) {
+		ground->hashContent(hash);
+	}
+	hash.add(items.size());
+	items.forEach([&hash](const Item &item) {
+		item.hashContent(hash);
+	});
+
+	hash.add(monster != nullptr);
+	if (monster) {
+		hash.add(monster->getName());
+		hash.add(monster->getSpawnMonsterTime());
+		hash.add(monster->getDirection());
+	}
+	hash.add(npc != nullptr);
+	if (npc) {
+		hash.add(npc->getName());
+		hash.add(npc->getSpawnNpcTime());
+		hash.add(npc->getDirection());
+	}
+	hash.add(spawnMonster ? spawnMonster->getSize() + 1 : 0);
+	hash.add(spawnNpc ? spawnNpc->getSize() + 1 : 0);
+	return hash.get();
 }
 
 int Tile::size() const {
@@ -166,9 +217,7 @@ void Tile::merge(Tile* other) {
 	}
 
 	if (other->ground) {
-		delete ground;
-		ground = other->ground;
-		other->ground = nullptr;
+		setGround(other->releaseGround());
 	}
 
 	if (other->monster) {
@@ -211,6 +260,7 @@ void Tile::merge(Tile* other) {
 		addItem(item);
 	}
 	other->items.clear();
+	other->update();
 }
 
 bool Tile::hasProperty(enum ITEMPROPERTY prop) const {
@@ -222,8 +272,8 @@ bool Tile::hasProperty(enum ITEMPROPERTY prop) const {
 		return true;
 	}
 
-	for (const Item* item : items) {
-		if (item->hasProperty(prop)) {
+	for (size_t index = 0; index < items.size(); ++index) {
+		if (items.visit(index, [prop](const Item &item) { return item.hasProperty(prop); })) {
 			return true;
 		}
 	}
@@ -251,18 +301,14 @@ int Tile::getIndexOf(Item* item) const {
 		index++;
 	}
 
-	if (!items.empty()) {
-		auto it = std::find(items.begin(), items.end(), item);
-		if (it != items.end()) {
-			index += (it - items.begin());
-			return index;
-		}
+	if (const int found = items.indexOf(item); found >= 0) {
+		return index + found;
 	}
 	return wxNOT_FOUND;
 }
 
 Item* Tile::getTopItem() const {
-	if (!items.empty() && !items.back()->isMetaItem()) {
+	if (!items.empty() && !items.visit(items.size() - 1, [](const Item &item) { return item.isMetaItem(); })) {
 		return items.back();
 	}
 	if (ground && !ground->isMetaItem()) {
@@ -282,7 +328,7 @@ Item* Tile::getItemAt(int index) const {
 		index--;
 	}
 	if (!items.empty() && index >= 0 && index < items.size()) {
-		return items.at(index);
+		return items[index];
 	}
 	return nullptr;
 }
@@ -293,44 +339,155 @@ void Tile::addItem(Item* item) {
 	}
 	if (item->isGroundTile()) {
 		// printf("ADDING GROUND\n");
-		delete ground;
-		ground = item;
+		setGround(item);
 		return;
 	}
 
-	ItemVector::iterator it;
+	size_t index;
 
 	uint16_t gid = item->getGroundEquivalent();
 	if (gid != 0) {
-		delete ground;
-		ground = Item::Create(gid);
+		setGround(Item::Create(gid));
 		// At the very bottom!
-		it = items.begin();
+		index = 0;
 	} else {
 		if (item->isAlwaysOnBottom()) {
-			it = items.begin();
-			while (true) {
-				if (it == items.end()) {
-					break;
-				} else if ((*it)->isAlwaysOnBottom()) {
-					if (item->getTopOrder() < (*it)->getTopOrder()) {
-						break;
-					}
-				} else { // Always on top
+			const int topOrder = item->getTopOrder();
+			index = 0;
+			while (index < items.size()) {
+				const bool below = items.visit(index, [topOrder](const Item &other) {
+					// Stops at the first item that is not on the bottom or sorts above this one
+					return other.isAlwaysOnBottom() && topOrder >= other.getTopOrder();
+				});
+				if (!below) {
 					break;
 				}
-				++it;
+				++index;
 			}
 		} else {
-			it = items.end();
+			index = items.size();
 		}
 	}
 
-	items.insert(it, item);
+	insertItem(items.begin() + index, item);
+}
+
+TileItems::iterator Tile::insertItem(TileItems::iterator position, Item* item) {
+	const size_t index = position.getIndex();
+	position = items.insert(position, item);
 
+	// The minimap shows the topmost coloured item
+	bool topmost = true;
+	for (size_t above = index + 1; above < items.size() && topmost; ++above) {
+		topmost = g_items.getMiniMapColor(items.getID(above)) == 0;
+	}
+	addItemState(item, false, topmost);
+	return position;
+}
+
+TileItems::iterator Tile::eraseItem(TileItems::iterator position) {
+	const bool recount = items.visit(position.getIndex(), [this](const Item &item) { return removeItemState(&item, false); });
+	position = items.erase(position);
+	if (recount) {
+		update();
+	}
+	return position;
+}
+
+TileItems::iterator Tile::destroyItem(TileItems::iterator position) {
+	const bool recount = items.visit(position.getIndex(), [this](const Item &item) { return removeItemState(&item, false); });
+	position = items.destroy(position);
+	if (recount) {
+		update();
+	}
+	return position;
+}
+
+void Tile::setGround(Item* item) {
+	delete releaseGround();
+	ground = item;
+	if (ground) {
+		bool topmost = true;
+		for (size_t above = 0; above < items.size() && topmost; ++above) {
+			topmost = g_items.getMiniMapColor(items.getID(above)) == 0;
+		}
+		addItemState(ground, true, topmost);
+	}
+}
+
+Item* Tile::releaseGround() {
+	Item* old_ground = ground;
+	if (old_ground) {
+		const bool recount = removeItemState(old_ground, true);
+		ground = nullptr;
+		if (recount) {
+			update();
+		}
+	}
+	return old_ground;
+}
+
+uint16_t Tile::getItemState(const Item* item, bool isGround) {
+	uint16_t state = 0;
 	if (item->isSelected()) {
-		statflags |= TILESTATE_SELECTED;
+		state |= TILESTATE_SELECTED;
+	}
+	if (item->getUniqueID() != 0) {
+		state |= TILESTATE_UNIQUE;
+	}
+
+	const uint32_t flags = g_items.getFlags(item->getID());
+	if (flags & ITEMTYPE_UNPASSABLE) {
+		state |= TILESTATE_BLOCKING;
+	}
+	if (isGround) {
+		return state;
+	}
+	if (flags & ITEMTYPE_OPTIONAL_BORDER) {
+		state |= TILESTATE_OP_BORDER;
+	}
+	if (flags & ITEMTYPE_TABLE) {
+		state |= TILESTATE_HAS_TABLE;
 	}
+	if (flags & ITEMTYPE_CARPET) {
+		state |= TILESTATE_HAS_CARPET;
+	}
+	return state;
+}
+
+void Tile::addItemState(const Item* item, bool isGround, bool topmost) {
+	const uint16_t state = getItemState(item, isGround);
+	statflags |= state;
+	for (size_t index = 0; index < CountedStateCount; ++index) {
+		if ((state & CountedStates[index]) && state_counts[index] != std::numeric_limits<uint8_t>::max()) {
+			++state_counts[index];
+		}
+	}
+	if (topmost) {
+		if (uint8_t color = item->getMiniMapColor(); color != 0) {
+			minimapColor = color;
+		}
+	}
+}
+
+bool Tile::removeItemState(const Item* item, bool isGround) {
+	const uint16_t state = getItemState(item, isGround);
+	bool recount = false;
+	for (size_t index = 0; index < CountedStateCount; ++index) {
+		if (!(state & CountedStates[index])) {
+			continue;
+		}
+		if (state_counts[index] == std::numeric_limits<uint8_t>::max()) {
+			recount = true;
+		} else if (state_counts[index] > 0 && --state_counts[index] == 0) {
+			statflags &= ~CountedStates[index];
+		}
+	}
+	if (item->getMiniMapColor() != 0) {
+		// It may have been the topmost coloured item, look again when asked
+		minimapColor = INVALID_MINIMAP_COLOR;
+	}
+	return recount;
 }
 
 void Tile::select() {
@@ -353,8 +510,8 @@ void Tile::select() {
 		npc->select();
 	}
 
-	for (Item* item : items) {
-		item->select();
+	for (size_t index = 0; index < items.size(); ++index) {
+		items.select(index);
 	}
 
 	statflags |= TILESTATE_SELECTED;
@@ -377,17 +534,17 @@ void Tile::deselect() {
 		npc->deselect();
 	}
 
-	for (Item* item : items) {
-		item->deselect();
+	for (size_t index = 0; index < items.size(); ++index) {
+		items.deselect(index);
 	}
 
 	statflags &= ~TILESTATE_SELECTED;
 }
 
 Item* Tile::getTopSelectedItem() {
-	for (auto it = items.rbegin(); it != items.rend(); ++it) {
-		if ((*it)->isSelected() && !(*it)->isMetaItem()) {
-			return *it;
+	for (size_t index = items.size(); index-- > 0;) {
+		if (items.isSelected(index) && !items.visit(index, [](const Item &item) { return item.isMetaItem(); })) {
+			return items[index];
 		}
 	}
 	if (ground && ground->isSelected() && !ground->isMetaItem()) {
@@ -404,15 +561,13 @@ ItemVector Tile::popSelectedItems(bool ignoreTileSelected) {
 	}
 
 	if (ground && ground->isSelected()) {
-		pop_items.push_back(ground);
-		ground = nullptr;
+		pop_items.push_back(releaseGround());
 	}
 
 	for (auto it = items.begin(); it != items.end();) {
-		Item* item = (*it);
-		if (item->isSelected()) {
-			pop_items.push_back(item);
-			it = items.erase(it);
+		if (items.isSelected(it.getIndex())) {
+			pop_items.push_back(*it);
+			it = eraseItem(it);
 		} else {
 			++it;
 		}
@@ -433,9 +588,9 @@ ItemVector Tile::getSelectedItems() {
 		selected_items.push_back(ground);
 	}
 
-	for (Item* item : items) {
-		if (item->isSelected()) {
-			selected_items.push_back(item);
+	for (size_t index = 0; index < items.size(); ++index) {
+		if (items.isSelected(index)) {
+			selected_items.push_back(items[index]);
 		}
 	}
 
@@ -447,8 +602,8 @@ uint8_t Tile::getMiniMapColor() const {
 		return minimapColor;
 	}
 
-	for (auto it = items.rbegin(); it != items.rend(); ++it) {
-		uint8_t color = (*it)->getMiniMapColor();
+	for (size_t index = items.size(); index-- > 0;) {
+		uint8_t color = g_items.getMiniMapColor(items.getID(index));
 		if (color != 0) {
 			return color;
 		}
@@ -462,70 +617,78 @@ uint8_t Tile::getMiniMapColor() const {
 	return 0;
 }
 
+void Tile::settleFlags() {
+	bool selected = (ground && ground->isSelected()) || (spawnMonster && spawnMonster->isSelected()) || (spawnNpc && spawnNpc->isSelected()) || (monster && monster->isSelected()) || (npc && npc->isSelected());
+	for (size_t index = 0; index < items.size() && !selected; ++index) {
+		selected = items.isSelected(index);
+	}
+	if (selected) {
+		statflags |= TILESTATE_SELECTED;
+	} else {
+		statflags &= ~TILESTATE_SELECTED;
+	}
+
+	for (size_t index = 0; index < CountedStateCount; ++index) {
+		if (state_counts[index] == 0) {
+			statflags &= ~CountedStates[index];
+		}
+	}
+}
+
 void Tile::update() {
-	statflags &= TILESTATE_MODIFIED;
+	uint16_t state = statflags & TILESTATE_MODIFIED;
+	uint8_t color = INVALID_MINIMAP_COLOR;
+	computeState(state, color, state_counts);
+	statflags = state;
+	minimapColor = color;
+}
 
+void Tile::computeState(uint16_t &state, uint8_t &color, uint8_t (&counts)[CountedStateCount]) const {
 	if (spawnMonster && spawnMonster->isSelected()) {
-		statflags |= TILESTATE_SELECTED;
+		state |= TILESTATE_SELECTED;
 	}
 	if (spawnNpc && spawnNpc->isSelected()) {
-		statflags |= TILESTATE_SELECTED;
+		state |= TILESTATE_SELECTED;
 	}
 	if (monster && monster->isSelected()) {
-		statflags |= TILESTATE_SELECTED;
+		state |= TILESTATE_SELECTED;
 	}
 	if (npc && npc->isSelected()) {
-		statflags |= TILESTATE_SELECTED;
+		state |= TILESTATE_SELECTED;
 	}
 
-	if (ground) {
-		if (ground->isSelected()) {
-			statflags |= TILESTATE_SELECTED;
-		}
-		if (ground->isBlocking()) {
-			statflags |= TILESTATE_BLOCKING;
-		}
-		if (ground->getUniqueID() != 0) {
-			statflags |= TILESTATE_UNIQUE;
-		}
-		if (ground->getMiniMapColor() != 0) {
-			minimapColor = ground->getMiniMapColor();
-		}
-	}
-
-	for (const Item* item : items) {
-		if (item->isSelected()) {
-			statflags |= TILESTATE_SELECTED;
-		}
-		if (item->getUniqueID() != 0) {
-			statflags |= TILESTATE_UNIQUE;
-		}
-		if (item->getMiniMapColor() != 0) {
-			minimapColor = item->getMiniMapColor();
-		}
-
-		const ItemType &type = g_items.getItemType(item->getID());
-
-		if (type.unpassable) {
-			statflags |= TILESTATE_BLOCKING;
-		}
-		if (type.isOptionalBorder) {
-			statflags |= TILESTATE_OP_BORDER;
-		}
-		if (type.isTable) {
-			statflags |= TILESTATE_HAS_TABLE;
+	std::fill(std::begin(counts), std::end(counts), 0);
+	// Bottom to top, so the topmost coloured item sets the minimap colour
+	const auto add = [&](const Item &item, bool isGround) {
+		const uint16_t itemState = getItemState(&item, isGround);
+		state |= itemState;
+		for (size_t index = 0; index < CountedStateCount; ++index) {
+			if ((itemState & CountedStates[index]) && counts[index] != std::numeric_limits<uint8_t>::max()) {
+				++counts[index];
+			}
 		}
-		if (type.isCarpet) {
-			statflags |= TILESTATE_HAS_CARPET;
+		if (uint8_t itemColor = item.getMiniMapColor(); itemColor != 0) {
+			color = itemColor;
 		}
+	};
+	if (ground) {
+		add(*ground, true);
 	}
+	items.forEach([&](const Item &item) {
+		add(item, false);
+	});
+}
 
-	if ((statflags & TILESTATE_BLOCKING) == 0) {
-		if (!ground && items.empty()) {
-			statflags |= TILESTATE_BLOCKING;
-		}
-	}
+#ifdef __DEBUG__
+bool Tile::hasConsistentState() const {
+	uint16_t state = statflags & TILESTATE_MODIFIED;
+	uint8_t color = INVALID_MINIMAP_COLOR;
+	uint8_t counts[CountedStateCount];
+	computeState(state, color, counts);
+	// An unknown colour is looked up when asked for
+	return state == statflags && std::equal(std::begin(counts), std::end(counts), state_counts) && (minimapColor == INVALID_MINIMAP_COLOR || color == minimapColor);
 }
+#endif
 
 void Tile::borderize(BaseMap* parent) {
 	GroundBrush::doBorders(parent, this);
@@ -536,7 +699,7 @@ void Tile::addBorderItem(Item* item) {
 		return;
 	}
 	ASSERT(item->isBorder());
-	items.insert(items.begin(), item);
+	insertItem(items.begin(), item);
 }
 
 GroundBrush* Tile::getGroundBrush() const {
@@ -552,14 +715,12 @@ void Tile::cleanBorders() {
 	}
 
 	for (auto it = items.begin(); it != items.end();) {
-		Item* item = (*it);
 		// Borders should only be on the bottom, we can ignore the rest of the items
-		if (!item->isBorder()) {
+		if (!items.visit(it.getIndex(), [](const Item &item) { return item.isBorder(); })) {
 			break;
 		}
 
-		delete item;
-		it = items.erase(it);
+		it = destroyItem(it);
 	}
 }
 
@@ -568,27 +729,27 @@ void Tile::wallize(BaseMap* parent) {
 }
 
 Item* Tile::getWall() const {
-	for (Item* item : items) {
-		if (item->isWall()) {
-			return item;
+	for (size_t index = 0; index < items.size(); ++index) {
+		if (items.visit(index, [](const Item &item) { return item.isWall(); })) {
+			return items[index];
 		}
 	}
 	return nullptr;
 }
 
 Item* Tile::getCarpet() const {
-	for (Item* item : items) {
-		if (item->isCarpet()) {
-			return item;
+	for (size_t index = 0; index < items.size(); ++index) {
+		if (items.visit(index, [](const Item &item) { return item.isCarpet(); })) {
+			return items[index];
 		}
 	}
 	return nullptr;
 }
 
 Item* Tile::getTable() const {
-	for (Item* item : items) {
-		if (item->isTable()) {
-			return item;
+	for (size_t index = 0; index < items.size(); ++index) {
+		if (items.visit(index, [](const Item &item) { return item.isTable(); })) {
+			return items[index];
 		}
 	}
 	return nullptr;
@@ -609,12 +770,8 @@ void Tile::cleanWalls(bool dontdelete) {
 	}
 
 	for (auto it = items.begin(); it != items.end();) {
-		Item* item = (*it);
-		if (item && item->isWall()) {
-			if (!dontdelete) {
-				delete item;
-			}
-			it = items.erase(it);
+		if (items.visit(it.getIndex(), [](const Item &item) { return item.isWall(); })) {
+			it = dontdelete ? eraseItem(it) : destroyItem(it);
 		} else {
 			++it;
 		}
@@ -622,13 +779,9 @@ void Tile::cleanWalls(bool dontdelete) {
 }
 
 void Tile::cleanWalls(WallBrush* brush) {
-	ItemVector::iterator it;
-
 	for (auto it = items.begin(); it != items.end();) {
-		Item* item = (*it);
-		if (item && item->isWall() && brush->hasWall(item)) {
-			delete item;
-			it = items.erase(it);
+		if (items.visit(it.getIndex(), [brush](Item &item) { return item.isWall() && brush->hasWall(&item); })) {
+			it = destroyItem(it);
 		} else {
 			++it;
 		}
@@ -641,12 +794,8 @@ void Tile::cleanTables(bool dontdelete) {
 	}
 
 	for (auto it = items.begin(); it != items.end();) {
-		Item* item = (*it);
-		if (item && item->isTable()) {
-			if (!dontdelete) {
-				delete item;
-			}
-			it = items.erase(it);
+		if (items.visit(it.getIndex(), [](const Item &item) { return item.isTable(); })) {
+			it = dontdelete ? eraseItem(it) : destroyItem(it);
 		} else {
 			++it;
 		}
@@ -667,13 +816,11 @@ void Tile::selectGround() {
 		ground->select();
 		selected = true;
 	}
-	ItemVector::iterator it;
-
-	for (Item* item : items) {
-		if (!item->isBorder()) {
+	for (size_t index = 0; index < items.size(); ++index) {
+		if (!items.visit(index, [](const Item &item) { return item.isBorder(); })) {
 			break;
 		}
-		item->select();
+		items.select(index);
 		selected = true;
 	}
 
@@ -686,12 +833,12 @@ void Tile::deselectGround() {
 	if (ground) {
 		ground->deselect();
 	}
-	for (Item* item : items) {
-		if (!item->isBorder()) {
+	for (size_t index = 0; index < items.size(); ++index) {
+		if (!items.visit(index, [](const Item &item) { return item.isBorder(); })) {
 			break;
 		}
 
-		item->deselect();
+		items.deselect(index);
 	}
 }
 
@@ -20,6 +20,7 @@
 
 #include "position.h"
 #include "item.h"
+#include "tile_items.h"
 #include "map_region.h"
 #include "spawn_npc.h"
 #include "npc.h"
@@ -47,17 +48,20 @@ enum : uint8_t {
 	INVALID_MINIMAP_COLOR = 0xFF
 };
 
+// Zone ids of a tile, almost always none or a single one
+typedef SmallVector<unsigned int, 2> TileZoneList;
+
 class Tile {
 public: // Members
 	TileLocation* location;
 	Item* ground;
-	ItemVector items;
+	TileItems items;
 	Monster* monster;
 	SpawnMonster* spawnMonster;
 	Npc* npc;
 	SpawnNpc* spawnNpc;
+	TileZoneList zones; // Kept sorted, see addZone
 	uint32_t house_id; // House id for this tile (pointer not safe)
-	std::set<unsigned int> zones;
 
 public:
 	// ALWAYS use this constructor if the Tile is EVER going to be placed on a map
@@ -67,7 +71,16 @@ public:
 
 	~Tile();
 
+	// Tiles are carved out of slab pools (see MapAllocator), delete returns them to their pool
+	static void* operator new(size_t size);
+	static void* operator new(size_t size, void* where) noexcept {
+		return where;
+	}
+	static void operator delete(void* block);
+	static void operator delete(void* block, void* where) noexcept { }
+
 	// Argument is a the map to allocate the tile from
+	// Plain items are copied as records, the others are shared with the copy until one side changes them
 	Tile* deepCopy(BaseMap &map) const;
 
 	// The location of the tile
@@ -115,15 +128,17 @@ public: // Functions
 
 	// Get memory footprint size
 	uint32_t memsize() const;
+	// Hash of everything the map saves of this tile, ContentHash::Empty when there is nothing
+	uint64_t getContentHash() const;
 	// Get number of items on the tile
 	bool empty() const {
 		return size() == 0;
 	}
 	int size() const;
 
-	// Blocking?
+	// Blocking? An empty tile blocks too
 	bool isBlocking() const {
-		return testFlags(statflags, TILESTATE_BLOCKING);
+		return testFlags(statflags, TILESTATE_BLOCKING) || (!ground && items.empty());
 	}
 
 	// PVP
@@ -154,8 +169,28 @@ public: // Functions
 
 	int getIndexOf(Item* item) const;
 	Item* getTopItem() const; // Returns the topmost item, or nullptr if the tile is empty
+	// Calls func(const Item&) with the topmost item without building it (see TileItems::visit),
+	// returns false if the tile is empty
+	template <typename Func>
+	bool visitTopItem(Func &&func) const;
 	Item* getItemAt(int index) const;
+
+	// Changes to the ground and items go through these, they keep the derived flags
+	// (blocking, table, carpet, ...) current in constant time
 	void addItem(Item* item);
+	// Puts the item at position as it is, for callers that keep their own order
+	TileItems::iterator insertItem(TileItems::iterator position, Item* item);
+	// Takes the item off the tile and hands it to the caller
+	TileItems::iterator eraseItem(TileItems::iterator position);
+	// Takes the item off the tile and deletes it
+	TileItems::iterator destroyItem(TileItems::iterator position);
+	// Replaces the ground and deletes the old one, nullptr only removes it
+	void setGround(Item* item);
+	// Takes the ground off the tile and hands it to the caller
+	Item* releaseGround();
+	// Changes an item of the tile (the ground or one of the items) in place, such as its id
+	template <typename Func>
+	void changeItem(Item* item, Func &&change);
 
 	void select();
 	void deselect();
@@ -174,8 +209,17 @@ public: // Functions
 	ItemVector getSelectedItems();
 	Item* getTopSelectedItem();
 
-	// Refresh internal flags (such as selected etc.)
+	// Flags that are set by hand rather than by the items: the selection is read off the items
+	// again and the optional border tool's mark is dropped unless an item carries it.
+	// Run when a change is committed, it only reads the selection of each item.
+	void settleFlags();
+	// Computes every derived flag again by walking the items and their types. The changes
+	// above keep them current, this is for tiles built by other means.
 	void update();
+#ifdef __DEBUG__
+	// Whether the incrementally kept flags match what update() would compute
+	bool hasConsistentState() const;
+#endif
 
 	uint8_t getMiniMapColor() const;
 
@@ -186,7 +230,7 @@ public: // Functions
 		return ground != nullptr;
 	}
 	bool hasBorders() const {
-		return !items.empty() && items.front()->isBorder();
+		return !items.empty() && items.visit(0, [](const Item &item) { return item.isBorder(); });
 	}
 
 	// Get the border brush of this tile
@@ -266,18 +310,24 @@ public: // Functions
 	}
 
 	bool hasZone(unsigned int zone) const {
-		return zones.find(zone) != zones.end();
+		return std::binary_search(zones.begin(), zones.end(), zone);
 	}
 
 	void addZone(unsigned int zone) {
 		if (zone == 0) {
 			return;
 		}
-		zones.insert(zone);
+		const auto it = std::lower_bound(zones.begin(), zones.end(), zone);
+		if (it == zones.end() || *it != zone) {
+			zones.insert(it, zone);
+		}
 	}
 
 	void removeZone(unsigned int zone) {
-		zones.erase(zone);
+		const auto it = std::lower_bound(zones.begin(), zones.end(), zone);
+		if (it != zones.end() && *it == zone) {
+			zones.erase(it);
+		}
 	}
 
 	void removeZones() {
@@ -294,7 +344,29 @@ protected:
 	};
 
 private:
+	// Derived flags counted per item, removing the last item carrying one clears it
+	static constexpr uint16_t CountedStates[] = {
+		TILESTATE_BLOCKING,
+		TILESTATE_UNIQUE,
+		TILESTATE_OP_BORDER,
+		TILESTATE_HAS_TABLE,
+		TILESTATE_HAS_CARPET,
+	};
+	static constexpr size_t CountedStateCount = std::size(CountedStates);
+
+	// Derived flags one item brings to the tile
+	static uint16_t getItemState(const Item* item, bool isGround);
+	// Derived flags, their counts and the minimap colour from every item, what update() stores
+	void computeState(uint16_t &state, uint8_t &color, uint8_t (&counts)[CountedStateCount]) const;
+	// Folds one item into the derived flags and the minimap colour
+	void addItemState(const Item* item, bool isGround, bool topmost);
+	// Takes one item out of them again, true when a count ran full and the tile has to be
+	// counted again with update() once the item is gone
+	bool removeItemState(const Item* item, bool isGround);
+
 	uint8_t minimapColor;
+	// Items carrying each of CountedStates, stuck at the maximum once they run full
+	uint8_t state_counts[CountedStateCount];
 
 	Tile(const Tile &tile); // No copy
 	Tile &operator=(const Tile &i); // Can't copy
@@ -305,8 +377,40 @@ typedef std::vector<Tile*> TileVector;
 typedef std::unordered_set<Tile*> TileSet;
 typedef std::list<Tile*> TileList;
 
+template <typename Func>
+void Tile::changeItem(Item* item, Func &&change) {
+	const bool isGround = item == ground;
+	const bool recount = removeItemState(item, isGround);
+	change(item);
+	if (recount) {
+		update();
+	} else {
+		// The colour is looked up again when it is next asked for
+		addItemState(item, isGround, false);
+		minimapColor = INVALID_MINIMAP_COLOR;
+	}
+}
+
+template <typename Func>
+bool Tile::visitTopItem(Func &&func) const {
+	if (!items.empty() && !items.visit(items.size() - 1, [](const Item &item) { return item.isMetaItem(); })) {
+		items.visit(items.size() - 1, func);
+		return true;
+	}
+	if (ground && !ground->isMetaItem()) {
+		func(static_cast<const Item &>(*ground));
+		return true;
+	}
+	return false;
+}
+
 inline bool Tile::hasWall() const {
-	return getWall() != nullptr;
+	for (size_t index = 0; index < items.size(); ++index) {
+		if (items.visit(index, [](const Item &item) { return item.isWall(); })) {
+			return true;
+		}
+	}
+	return false;
 }
 
 inline bool Tile::isHouseTile() const noexcept {
@@ -0,0 +1,226 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "tile_items.h"
+
+#include <mutex>
+
+namespace {
+	// Guards Item::references and the hand-over of shared items between lists
+	std::mutex sharedItemsMutex;
+}
+
+TileItems::~TileItems() {
+	for (const Slot &slot : slots) {
+		if (!isRecordBits(slot.bits)) {
+			unshare(toItem(slot.bits));
+		}
+	}
+}
+
+size_t TileItems::memsize() const {
+	size_t mem = slots.getHeapBytes() + getSharedBytes();
+	for (const Slot &slot : slots) {
+		if (!isRecordBits(slot.bits) && !isSharedBits(slot.bits)) {
+			mem += toItem(slot.bits)->memsize();
+		}
+	}
+	return mem;
+}
+
+size_t TileItems::getRecordCount() const noexcept {
+	return std::count_if(slots.begin(), slots.end(), [](const Slot &slot) {
+		return isRecordBits(slot.bits);
+	});
+}
+
+size_t TileItems::getSharedCount() const noexcept {
+	return std::count_if(slots.begin(), slots.end(), [](const Slot &slot) {
+		return isSharedBits(slot.bits);
+	});
+}
+
+size_t TileItems::getSharedBytes() const noexcept {
+	size_t mem = 0;
+	for (size_t index = 0; index < slots.size(); ++index) {
+		const uint64_t bits = load(index);
+		if (isSharedBits(bits)) {
+			Item* item = toItem(bits);
+			const uint16_t references = std::atomic_ref<uint16_t>(item->references).load(std::memory_order_relaxed);
+			mem += item->memsize() / std::max<uint16_t>(references, 1);
+		}
+	}
+	return mem;
+}
+
+int TileItems::indexOf(const Item* item) const noexcept {
+	for (size_t index = 0; index < slots.size(); ++index) {
+		if (load(index) == fromItem(item)) {
+			return static_cast<int>(index);
+		}
+	}
+	return -1;
+}
+
+void TileItems::select(size_t index) noexcept {
+	const uint64_t bits = load(index);
+	if (isRecordBits(bits)) {
+		slotAt(index).fetch_or(SelectedBit, std::memory_order_acq_rel);
+	} else {
+		// A shared item is never changed, the slot gets one of its own first
+		materialize(index)->select();
+	}
+}
+
+void TileItems::deselect(size_t index) noexcept {
+	const uint64_t bits = load(index);
+	if (isRecordBits(bits)) {
+		slotAt(index).fetch_and(~SelectedBit, std::memory_order_acq_rel);
+	} else if (!isSharedBits(bits)) {
+		toItem(bits)->deselect();
+	}
+}
+
+TileItems::iterator TileItems::erase(iterator first, iterator last) {
+	for (size_t index = first.getIndex(); index < last.getIndex(); ++index) {
+		release(index);
+	}
+	slots.erase(slots.begin() + first.getIndex(), slots.begin() + last.getIndex());
+	return first;
+}
+
+TileItems::iterator TileItems::destroy(iterator position) {
+	const uint64_t bits = load(position.getIndex());
+	if (!isRecordBits(bits) && !isSharedBits(bits)) {
+		delete toItem(bits);
+	}
+	return erase(position);
+}
+
+void TileItems::clear() noexcept {
+	for (size_t index = 0; index < slots.size(); ++index) {
+		release(index);
+	}
+	slots.clear();
+}
+
+void TileItems::copyFrom(const TileItems &other) {
+	slots.reserve(slots.size() + other.size());
+	for (size_t index = 0; index < other.size(); ++index) {
+		slots.push_back(other.copySlot(index));
+	}
+}
+
+void TileItems::compact() {
+	for (Slot &slot : slots) {
+		if (isRecordBits(slot.bits) || isSharedBits(slot.bits)) {
+			continue;
+		}
+		Item* item = toItem(slot.bits);
+		if (!item) {
+			continue;
+		}
+		if (item->isCompactable()) {
+			slot.bits = makeRecord(item);
+			delete item;
+		} else if (!item->isSelected()) {
+			item->references = 1;
+			slot.bits = fromSharedItem(item);
+		}
+	}
+}
+
+Item* TileItems::materialize(size_t index) const {
+	std::atomic_ref<uint64_t> slot = slotAt(index);
+	uint64_t bits = slot.load(std::memory_order_acquire);
+	while (isRecordBits(bits)) {
+		Item* item = new Item(recordID(bits), recordSubtype(bits), (bits & SelectedBit) != 0);
+		if (slot.compare_exchange_strong(bits, fromItem(item), std::memory_order_acq_rel, std::memory_order_acquire)) {
+			return item;
+		}
+		// Someone else got there first, bits now holds what they stored
+		delete item;
+	}
+	if (!isSharedBits(bits)) {
+		return toItem(bits);
+	}
+
+	std::lock_guard<std::mutex> lock(sharedItemsMutex);
+	bits = slot.load(std::memory_order_acquire);
+	if (!isSharedBits(bits)) {
+		return toItem(bits);
+	}
+	Item* shared = toItem(bits);
+	Item* item;
+	if (shared->references == 1) {
+		// Nobody else holds it, so it is ours to change
+		shared->references = 0;
+		item = shared;
+	} else {
+		item = shared->deepCopy();
+		--shared->references;
+	}
+	slot.store(fromItem(item), std::memory_order_release);
+	return item;
+}
+
+void TileItems::unshare(Item* item) noexcept {
+	{
+		std::lock_guard<std::mutex> lock(sharedItemsMutex);
+		if (item->references > 1) {
+			--item->references;
+			return;
+		}
+	}
+	delete item;
+}
+
+void TileItems::release(size_t index) noexcept {
+	const uint64_t bits = load(index);
+	if (isSharedBits(bits)) {
+		unshare(toItem(bits));
+	}
+}
+
+uint64_t TileItems::copySlot(size_t index) const {
+	uint64_t bits = load(index);
+	if (isRecordBits(bits)) {
+		return bits;
+	}
+	if (isSharedBits(bits)) {
+		std::lock_guard<std::mutex> lock(sharedItemsMutex);
+		// Read again, the slot may have been given an item of its own in the meantime
+		bits = load(index);
+		Item* item = toItem(bits);
+		if (isSharedBits(bits) && item->references < std::numeric_limits<uint16_t>::max()) {
+			++item->references;
+			return bits;
+		}
+	}
+	Item* item = toItem(bits);
+	if (item->isCompactable()) {
+		return makeRecord(item);
+	}
+	Item* copy = item->deepCopy();
+	if (copy->isSelected()) {
+		return fromItem(copy);
+	}
+	copy->references = 1;
+	return fromSharedItem(copy);
+}
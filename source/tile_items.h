@@ -0,0 +1,309 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_TILE_ITEMS_H
+#define RME_TILE_ITEMS_H
+
+#include "item.h"
+#include "small_vector.h"
+
+#include <atomic>
+#include <compare>
+#include <iterator>
+
+// The items of a tile above the ground, bottom to top. A slot holds one of three things:
+// - a record: most items on a map are plain ones (no subclass, no attributes), those are kept
+//   inline as {id, subtype, selected} in the slot a pointer would take, with no Item behind them.
+// - a shared item: the other unselected items are shared between copies of the list, counted
+//   in Item::references, and never changed while shared.
+// - an item of its own, which the list owns and its holders may change.
+// Copying a list copies records, shares shared items and only clones items of its own.
+// Asking for an Item* through the accessors gives the slot an item of its own: a record is
+// built into one, a shared item is taken over when this list is its last holder, otherwise
+// cloned. Either way the item stays valid for as long as it is on the tile.
+// Drawing, the hover status, saving, hashing, the map indexes and the read-only searches read
+// through getID, visit and forEach, which never do that. The finders that keep what they find
+// only build their matches (see foreach_ItemOnTile). Selecting a shared item gives the slot
+// its own copy first.
+// Threads reading the same list, building items included, stay safe.
+// Erasing an item of its own hands it over to the caller.
+class TileItems {
+public:
+	class iterator {
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = Item*;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = Item*;
+
+		iterator() noexcept :
+			list(nullptr), index(0) { }
+		iterator(const TileItems* list, size_t index) noexcept :
+			list(list), index(index) { }
+
+		Item* operator*() const {
+			return list->materialize(index);
+		}
+		Item* operator[](difference_type offset) const {
+			return list->materialize(index + offset);
+		}
+
+		iterator &operator++() noexcept {
+			++index;
+			return *this;
+		}
+		iterator operator++(int) noexcept {
+			iterator old = *this;
+			++index;
+			return old;
+		}
+		iterator &operator--() noexcept {
+			--index;
+			return *this;
+		}
+		iterator operator--(int) noexcept {
+			iterator old = *this;
+			--index;
+			return old;
+		}
+		iterator &operator+=(difference_type offset) noexcept {
+			index += offset;
+			return *this;
+		}
+		iterator &operator-=(difference_type offset) noexcept {
+			index -= offset;
+			return *this;
+		}
+		iterator operator+(difference_type offset) const noexcept {
+			return iterator(list, index + offset);
+		}
+		friend iterator operator+(difference_type offset, const iterator &it) noexcept {
+			return it + offset;
+		}
+		iterator operator-(difference_type offset) const noexcept {
+			return iterator(list, index - offset);
+		}
+		difference_type operator-(const iterator &other) const noexcept {
+			return static_cast<difference_type>(index) - static_cast<difference_type>(other.index);
+		}
+
+		bool operator==(const iterator &other) const noexcept {
+			return index == other.index;
+		}
+		std::strong_ordering operator<=>(const iterator &other) const noexcept {
+			return index <=> other.index;
+		}
+
+		// Position in the list, for the accessors that work on records
+		size_t getIndex() const noexcept {
+			return index;
+		}
+
+	private:
+		const TileItems* list;
+		size_t index;
+	};
+	using const_iterator = iterator;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = reverse_iterator;
+	using value_type = Item*;
+	using size_type = size_t;
+
+	TileItems() noexcept = default;
+	~TileItems();
+
+	TileItems(const TileItems &) = delete;
+	TileItems &operator=(const TileItems &) = delete;
+
+	// Size
+	bool empty() const noexcept {
+		return slots.empty();
+	}
+	size_t size() const noexcept {
+		return slots.size();
+	}
+	void reserve(size_t wanted) {
+		slots.reserve(wanted);
+	}
+	// Memory held outside the tile, the full items and the slots once they outgrow the tile
+	size_t memsize() const;
+	size_t getHeapBytes() const noexcept {
+		return slots.getHeapBytes();
+	}
+	size_t getRecordCount() const noexcept;
+	size_t getSharedCount() const noexcept;
+	// This list's part of the shared items, each split evenly over its holders
+	size_t getSharedBytes() const noexcept;
+
+	// Items of the slot's own, records and shared items are turned into one on the way
+	Item* operator[](size_t index) const {
+		return materialize(index);
+	}
+	Item* front() const {
+		return materialize(0);
+	}
+	Item* back() const {
+		return materialize(slots.size() - 1);
+	}
+	iterator begin() const noexcept {
+		return iterator(this, 0);
+	}
+	iterator end() const noexcept {
+		return iterator(this, slots.size());
+	}
+	reverse_iterator rbegin() const noexcept {
+		return reverse_iterator(end());
+	}
+	reverse_iterator rend() const noexcept {
+		return reverse_iterator(begin());
+	}
+	// Position of an item handed out before, records are never a match
+	int indexOf(const Item* item) const noexcept;
+
+	// Reading without building items
+	bool isRecord(size_t index) const noexcept {
+		return isRecordBits(load(index));
+	}
+	bool isShared(size_t index) const noexcept {
+		return isSharedBits(load(index));
+	}
+	uint16_t getID(size_t index) const noexcept {
+		const uint64_t bits = load(index);
+		return isRecordBits(bits) ? recordID(bits) : toItem(bits)->getID();
+	}
+	bool isSelected(size_t index) const noexcept {
+		// Shared items are never selected
+		const uint64_t bits = load(index);
+		return isRecordBits(bits) ? (bits & SelectedBit) != 0 : toItem(bits)->isSelected();
+	}
+	// Calls func with the item at index, a record is read through a stand-in item on the stack
+	// that only lives for the call, so func must not keep hold of it. A shared item is handed
+	// over as it is, func may only touch its drawing state (the animation frame).
+	template <typename Func>
+	decltype(auto) visit(size_t index, Func &&func) const {
+		const uint64_t bits = load(index);
+		if (isRecordBits(bits)) {
+			Item item(recordID(bits), recordSubtype(bits), (bits & SelectedBit) != 0);
+			return func(item);
+		}
+		return func(*toItem(bits));
+	}
+	// The same for every item, bottom to top
+	template <typename Func>
+	void forEach(Func &&func) const {
+		for (size_t index = 0; index < slots.size(); ++index) {
+			visit(index, func);
+		}
+	}
+
+	void select(size_t index) noexcept;
+	void deselect(size_t index) noexcept;
+
+	// Changes
+	void push_back(Item* item) {
+		slots.push_back(fromItem(item));
+	}
+	iterator insert(iterator position, Item* item) {
+		slots.insert(slots.begin() + position.getIndex(), fromItem(item));
+		return position;
+	}
+	iterator erase(iterator position) {
+		return erase(position, position + 1);
+	}
+	// Items of the slots' own go to the caller, shared items are let go of
+	iterator erase(iterator first, iterator last);
+	void pop_back() noexcept {
+		release(slots.size() - 1);
+		slots.pop_back();
+	}
+	// Erases the item and deletes it, records and shared items go without ever being built
+	iterator destroy(iterator position);
+	void swap(size_t first, size_t second) noexcept {
+		std::swap(slots[first], slots[second]);
+	}
+	// Drops every slot, the items of their own are left to whoever took them
+	void clear() noexcept;
+
+	// Copy of another list: records are copied, plain items come out as records,
+	// shared items are shared once more and the other items are cloned into shared ones
+	void copyFrom(const TileItems &other);
+	// Turns the plain items into records and shares the other unselected ones,
+	// only for lists nobody took item pointers from yet
+	void compact();
+
+private:
+	// Bit 0 tells records from pointers, bit 1 is the selection of a record and marks a shared
+	// item in a pointer. Items are at least 8 byte aligned.
+	static constexpr uint64_t RecordBit = 1;
+	static constexpr uint64_t SelectedBit = 2;
+	static constexpr uint64_t SharedBit = 2;
+	static constexpr uint64_t TagBits = RecordBit | SharedBit;
+
+	struct alignas(8) Slot {
+		Slot() noexcept = default;
+		Slot(uint64_t bits) noexcept :
+			bits(bits) { }
+		uint64_t bits;
+	};
+
+	static bool isRecordBits(uint64_t bits) noexcept {
+		return (bits & RecordBit) != 0;
+	}
+	static bool isSharedBits(uint64_t bits) noexcept {
+		return (bits & TagBits) == SharedBit;
+	}
+	static uint64_t makeRecord(uint16_t id, uint16_t subtype, bool selected) noexcept {
+		return static_cast<uint64_t>(id) << 32 | static_cast<uint64_t>(subtype) << 16 | (selected ? SelectedBit : 0) | RecordBit;
+	}
+	static uint64_t makeRecord(const Item* item) noexcept {
+		return makeRecord(item->id, item->subtype, item->selected);
+	}
+	static uint16_t recordID(uint64_t bits) noexcept {
+		return static_cast<uint16_t>(bits >> 32);
+	}
+	static uint16_t recordSubtype(uint64_t bits) noexcept {
+		return static_cast<uint16_t>(bits >> 16);
+	}
+	static Item* toItem(uint64_t bits) noexcept {
+		return reinterpret_cast<Item*>(static_cast<uintptr_t>(bits & ~TagBits));
+	}
+	static uint64_t fromItem(const Item* item) noexcept {
+		return reinterpret_cast<uintptr_t>(item);
+	}
+	static uint64_t fromSharedItem(const Item* item) noexcept {
+		return fromItem(item) | SharedBit;
+	}
+
+	std::atomic_ref<uint64_t> slotAt(size_t index) const noexcept {
+		return std::atomic_ref<uint64_t>(const_cast<uint64_t &>(slots[index].bits));
+	}
+	uint64_t load(size_t index) const noexcept {
+		return slotAt(index).load(std::memory_order_acquire);
+	}
+	Item* materialize(size_t index) const;
+	// Drops a shared item's holder, or deletes an item of the slot's own
+	static void unshare(Item* item) noexcept;
+	// Lets go of a shared item in the slot, records and items of its own are left alone
+	void release(size_t index) noexcept;
+	// What a copy of the list gets for the slot at index
+	uint64_t copySlot(size_t index) const;
+
+	SmallVector<Slot, 3> slots;
+};
+
+#endif
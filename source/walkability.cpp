@@ -0,0 +1,296 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#include "main.h"
+
+#include "walkability.h"
+#include "tile.h"
+#include "complexitem.h"
+
+#include <bit>
+
+bool TileBitmap::test(int x, int y, int z) const {
+	if (!inside(x, y, z)) {
+		return false;
+	}
+
+	auto it = blocks.find(blockKey(x, y, z));
+	if (it == blocks.end()) {
+		return false;
+	}
+	return (it->second.rows[y % BlockSize] >> (x % BlockSize)) & 1;
+}
+
+void TileBitmap::set(int x, int y, int z, bool value) {
+	if (!inside(x, y, z)) {
+		return;
+	}
+
+	const uint32_t key = blockKey(x, y, z);
+	const uint64_t mask = uint64_t(1) << (x % BlockSize);
+	if (value) {
+		Block &block = blocks[key];
+		uint64_t &row = block.rows[y % BlockSize];
+		if (!(row & mask)) {
+			row |= mask;
+			++block.count;
+			++bits;
+		}
+		return;
+	}
+
+	auto it = blocks.find(key);
+	if (it == blocks.end()) {
+		return;
+	}
+
+	Block &block = it->second;
+	uint64_t &row = block.rows[y % BlockSize];
+	if (row & mask) {
+		row &= ~mask;
+		--bits;
+		if (--block.count == 0) {
+			blocks.erase(it);
+		}
+	}
+}
+
+bool TileBitmap::any(int z, int x0, int y0, int x1, int y1) const {
+	x0 = std::max(x0, 0);
+	y0 = std::max(y0, 0);
+	x1 = std::min(x1, 0xFFFF);
+	y1 = std::min(y1, 0xFFFF);
+	if (z < 0 || z > rme::MapMaxLayer || x0 > x1 || y0 > y1) {
+		return false;
+	}
+
+	for (int blockY = y0 / BlockSize; blockY <= y1 / BlockSize; ++blockY) {
+		for (int blockX = x0 / BlockSize; blockX <= x1 / BlockSize; ++blockX) {
+			auto it = blocks.find(blockKey(blockX * BlockSize, blockY * BlockSize, z));
+			if (it == blocks.end()) {
+				continue;
+			}
+
+			// Columns of this block inside the rectangle
+			const int left = std::max(x0 - blockX * BlockSize, 0);
+			const int right = std::min(x1 - blockX * BlockSize, BlockSize - 1);
+			const uint64_t mask = (right == BlockSize - 1 ? ~uint64_t(0) : (uint64_t(1) << (right + 1)) - 1) & ~((uint64_t(1) << left) - 1);
+
+			const int top = std::max(y0 - blockY * BlockSize, 0);
+			const int bottom = std::min(y1 - blockY * BlockSize, BlockSize - 1);
+			const Block &block = it->second;
+			for (int row = top; row <= bottom; ++row) {
+				if (block.rows[row] & mask) {
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+TileBitmap TileBitmap::difference(const TileBitmap &other) const {
+	TileBitmap result;
+	for (const auto &[key, block] : blocks) {
+		auto it = other.blocks.find(key);
+
+		Block remaining;
+		for (int row = 0; row < BlockSize; ++row) {
+			remaining.rows[row] = block.rows[row] & (it == other.blocks.end() ? ~uint64_t(0) : ~it->second.rows[row]);
+			remaining.count += std::popcount(remaining.rows[row]);
+		}
+
+		if (remaining.count != 0) {
+			result.bits += remaining.count;
+			result.blocks.emplace(key, remaining);
+		}
+	}
+	return result;
+}
+
+void TileBitmap::clear() {
+	blocks.clear();
+	bits = 0;
+}
+
+uint64_t TileBitmap::memsize() const {
+	return blocks.bucket_count() * sizeof(void*) + blocks.size() * (sizeof(std::pair<const uint32_t, Block>) + sizeof(void*));
+}
+
+void WalkabilityMap::updateTile(const Position &position, const Tile* tile) {
+	walkable.set(position, tile && !tile->isBlocking());
+
+	Link link;
+	if (tile) {
+		const auto addItem = [&link](const Item* item) {
+			const uint16_t id = item->getID();
+			if (g_items.hasFlag(id, ITEMTYPE_FLOOR_CHANGE)) {
+				const ItemType &type = g_items.getItemType(id);
+				if (type.floorChangeDown) {
+					link.floor_change |= FLOOR_CHANGE_DOWN;
+				} else if (type.floorChangeNorth) {
+					link.floor_change |= FLOOR_CHANGE_NORTH;
+				} else if (type.floorChangeEast) {
+					link.floor_change |= FLOOR_CHANGE_EAST;
+				} else if (type.floorChangeSouth) {
+					link.floor_change |= FLOOR_CHANGE_SOUTH;
+				} else if (type.floorChangeWest) {
+					link.floor_change |= FLOOR_CHANGE_WEST;
+				} else {
+					link.floor_change |= FLOOR_CHANGE_UP;
+				}
+			}
+			if (const Teleport* teleport = dynamic_cast<const Teleport*>(item)) {
+				if (teleport->hasDestination()) {
+					link.teleport = true;
+					link.destination = teleport->getDestination();
+				}
+			}
+		};
+
+		if (tile->ground) {
+			addItem(tile->ground);
+		}
+		tile->items.forEach([&](const Item &item) {
+			addItem(&item);
+		});
+	}
+
+	const uint64_t key = linkKey(position.x, position.y, position.z);
+	if (link.floor_change != 0 || link.teleport) {
+		links[key] = link;
+	} else {
+		links.erase(key);
+	}
+}
+
+void WalkabilityMap::clear() {
+	walkable.clear();
+	links.clear();
+}
+
+TileBitmap WalkabilityMap::findReachable(const std::vector<Position> &seeds) const {
+	TileBitmap reached;
+	fill(seeds, reached, nullptr);
+	return reached;
+}
+
+TileBitmap WalkabilityMap::findIsolated(const std::vector<Position> &seeds) const {
+	return walkable.difference(findReachable(seeds));
+}
+
+bool WalkabilityMap::pathExists(const Position &from, const Position &to) const {
+	if (!walkable.test(from) || !walkable.test(to)) {
+		return false;
+	}
+
+	TileBitmap reached;
+	return fill({ from }, reached, &to);
+}
+
+uint64_t WalkabilityMap::memsize() const {
+	// Rough node size of the link tree, the standard containers don't expose it
+	return walkable.memsize() + links.size() * (sizeof(std::pair<const uint64_t, Link>) + 4 * sizeof(void*));
+}
+
+bool WalkabilityMap::fill(const std::vector<Position> &seeds, TileBitmap &reached, const Position* target) const {
+	std::vector<Position> pending;
+	const auto open = [&](int x, int y, int z) {
+		return walkable.test(x, y, z) && !reached.test(x, y, z);
+	};
+	const auto land = [&](const Position &center, int radius) {
+		for (int y = center.y - radius; y <= center.y + radius; ++y) {
+			for (int x = center.x - radius; x <= center.x + radius; ++x) {
+				if (open(x, y, center.z)) {
+					pending.emplace_back(x, y, center.z);
+				}
+			}
+		}
+	};
+
+	for (const Position &seed : seeds) {
+		land(seed, 0);
+	}
+
+	while (!pending.empty()) {
+		const Position position = pending.back();
+		pending.pop_back();
+
+		const int y = position.y;
+		const int z = position.z;
+		if (reached.test(position)) {
+			continue;
+		}
+
+		// Grow the run along the row, then only the first tile of each run next to it is queued
+		int left = position.x;
+		int right = position.x;
+		while (open(left - 1, y, z)) {
+			--left;
+		}
+		while (open(right + 1, y, z)) {
+			++right;
+		}
+		for (int x = left; x <= right; ++x) {
+			reached.set(x, y, z);
+		}
+
+		if (target && target->z == z && target->y == y && target->x >= left && target->x <= right) {
+			return true;
+		}
+
+		// Diagonal steps count, so the rows next to it are scanned one tile wider
+		for (const int nextY : { y - 1, y + 1 }) {
+			bool run = false;
+			for (int x = left - 1; x <= right + 1; ++x) {
+				const bool isOpen = open(x, nextY, z);
+				if (isOpen && !run) {
+					pending.emplace_back(x, nextY, z);
+				}
+				run = isOpen;
+			}
+		}
+
+		for (auto it = links.lower_bound(linkKey(left, y, z)), end = links.upper_bound(linkKey(right, y, z)); it != end; ++it) {
+			const Link &link = it->second;
+			const int x = int(it->first & 0xFFFF);
+			if (link.teleport) {
+				land(link.destination, 1);
+			}
+			if (link.floor_change & FLOOR_CHANGE_DOWN) {
+				land(Position(x, y, z + 1), 1);
+			}
+			if (link.floor_change & FLOOR_CHANGE_NORTH) {
+				land(Position(x, y - 1, z - 1), 1);
+			}
+			if (link.floor_change & FLOOR_CHANGE_EAST) {
+				land(Position(x + 1, y, z - 1), 1);
+			}
+			if (link.floor_change & FLOOR_CHANGE_SOUTH) {
+				land(Position(x, y + 1, z - 1), 1);
+			}
+			if (link.floor_change & FLOOR_CHANGE_WEST) {
+				land(Position(x - 1, y, z - 1), 1);
+			}
+			if (link.floor_change & FLOOR_CHANGE_UP) {
+				land(Position(x, y, z - 1), 2);
+			}
+		}
+	}
+	return target == nullptr;
+}
@@ -0,0 +1,140 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_WALKABILITY_H
+#define RME_WALKABILITY_H
+
+#include "position.h"
+
+#include <array>
+#include <map>
+#include <unordered_map>
+
+class Tile;
+
+// One bit per tile, stored as 64x64 blocks of one floor that only exist once a bit is set in them
+class TileBitmap {
+public:
+	static constexpr int BlockSize = 64;
+
+	bool test(int x, int y, int z) const;
+	bool test(const Position &position) const {
+		return test(position.x, position.y, position.z);
+	}
+	void set(int x, int y, int z, bool value = true);
+	void set(const Position &position, bool value = true) {
+		set(position.x, position.y, position.z, value);
+	}
+
+	// Any bit set between the two corners, both included
+	bool any(int z, int x0, int y0, int x1, int y1) const;
+
+	// The bits set here and not in other
+	TileBitmap difference(const TileBitmap &other) const;
+
+	size_t count() const noexcept {
+		return bits;
+	}
+	bool empty() const noexcept {
+		return bits == 0;
+	}
+	void clear();
+
+	uint64_t memsize() const;
+
+private:
+	struct Block {
+		// One word per row, bit i is the tile at the block x + i
+		std::array<uint64_t, BlockSize> rows {};
+		uint32_t count = 0;
+	};
+
+	static bool inside(int x, int y, int z) noexcept {
+		return x >= 0 && y >= 0 && z >= 0 && x <= 0xFFFF && y <= 0xFFFF && z <= rme::MapMaxLayer;
+	}
+	static uint32_t blockKey(int x, int y, int z) noexcept {
+		return (uint32_t(z) << 20) | (uint32_t(y / BlockSize) << 10) | uint32_t(x / BlockSize);
+	}
+
+	std::unordered_map<uint32_t, Block> blocks;
+	size_t bits = 0;
+};
+
+// Which tiles a player can stand on, and the stairs, holes and teleports joining them.
+// The map feeds it every tile it replaces, so it follows brushes, undo and loading.
+// Reachability is a flood fill over it: 8 directions on a floor, plus the links.
+// Levers, ladders and other scripted moves aren't known to the editor and are not followed.
+class WalkabilityMap {
+public:
+	// tile may be null when the position was emptied
+	void updateTile(const Position &position, const Tile* tile);
+	void clear();
+
+	bool isWalkable(const Position &position) const {
+		return walkable.test(position);
+	}
+	// Whether a player could stand anywhere between the two corners of floor z
+	bool anyWalkable(int z, int x0, int y0, int x1, int y1) const {
+		return walkable.any(z, x0, y0, x1, y1);
+	}
+	const TileBitmap &getWalkable() const noexcept {
+		return walkable;
+	}
+
+	// Every walkable tile a player starting on any of the seeds can walk to
+	TileBitmap findReachable(const std::vector<Position> &seeds) const;
+	// Every walkable tile none of the seeds can walk to
+	TileBitmap findIsolated(const std::vector<Position> &seeds) const;
+	// Stops as soon as to is reached
+	bool pathExists(const Position &from, const Position &to) const;
+
+	size_t linkCount() const noexcept {
+		return links.size();
+	}
+
+	uint64_t memsize() const;
+
+private:
+	enum FloorChange : uint8_t {
+		FLOOR_CHANGE_DOWN = 1 << 0,
+		FLOOR_CHANGE_NORTH = 1 << 1,
+		FLOOR_CHANGE_EAST = 1 << 2,
+		FLOOR_CHANGE_SOUTH = 1 << 3,
+		FLOOR_CHANGE_WEST = 1 << 4,
+		// Up, without a direction items.otb knows about
+		FLOOR_CHANGE_UP = 1 << 5,
+	};
+
+	struct Link {
+		uint8_t floor_change = 0;
+		bool teleport = false;
+		Position destination;
+	};
+
+	// Sorted by floor, row and column, so the links of a run of tiles are one range
+	static uint64_t linkKey(int x, int y, int z) noexcept {
+		return (uint64_t(z) << 32) | (uint64_t(y) << 16) | uint64_t(x);
+	}
+
+	bool fill(const std::vector<Position> &seeds, TileBitmap &reached, const Position* target) const;
+
+	TileBitmap walkable;
+	std::map<uint64_t, Link> links;
+};
+
+#endif
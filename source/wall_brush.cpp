@@ -260,7 +260,7 @@ void WallBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 	bool b = (parameter ? *reinterpret_cast<bool*>(parameter) : false);
 	if (b) {
 		// Find a matching wall item on this tile, and shift the id
-		for (ItemVector::iterator item_iter = tile->items.begin(); item_iter != tile->items.end(); ++item_iter) {
+		for (TileItems::iterator item_iter = tile->items.begin(); item_iter != tile->items.end(); ++item_iter) {
 			Item* item = *item_iter;
 			if (item->isWall()) {
 				WallBrush* wb = item->getWallBrush();
@@ -303,7 +303,7 @@ void WallBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 						}
 					}
 					if (id != 0) {
-						item->setID(id);
+						tile->changeItem(item, [id](Item* wall) { wall->setID(id); });
 					}
 					return;
 				}
@@ -357,7 +357,7 @@ bool hasMatchingWallBrushAtTile(BaseMap* map, WallBrush* wall_brush, uint32_t x,
 		return false;
 	}
 
-	ItemVector::const_iterator it = t->items.begin();
+	TileItems::const_iterator it = t->items.begin();
 	for (; it != t->items.end(); ++it) {
 		Item* item = *it;
 		if (item->isWall()) {
@@ -382,7 +382,7 @@ void WallBrush::doWalls(BaseMap* map, Tile* tile) {
 	unsigned int z = tile->getPosition().z;
 
 	// Advance the vector to the beginning of the walls
-	ItemVector::iterator it = tile->items.begin();
+	TileItems::iterator it = tile->items.begin();
 	for (; it != tile->items.end() && (*it)->isBorder(); ++it)
 		;
 
@@ -403,7 +403,7 @@ void WallBrush::doWalls(BaseMap* map, Tile* tile) {
 		// or if it's a decoration brush.
 		if (wall_brush->isWallDecoration()) {
 			items_to_add.push_back(wall);
-			it = tile->items.erase(it);
+			it = tile->eraseItem(it);
 			continue;
 		}
 		bool neighbours[4];
@@ -454,13 +454,13 @@ void WallBrush::doWalls(BaseMap* map, Tile* tile) {
 
 			if (wall->getWallAlignment() == WALL_UNTOUCHABLE) {
 				items_to_add.push_back(wall);
-				it = tile->items.erase(it);
+				it = tile->eraseItem(it);
 				exit = true;
 			} else if (wall->getWallAlignment() == bt) {
 				// Do nothing, the tile already has a wall like this
 				// However, wall decorations associated with this wall might need to change...
 				items_to_add.push_back(wall);
-				it = tile->items.erase(it);
+				it = tile->eraseItem(it);
 				exit = true;
 
 				while (it != tile->items.end()) {
@@ -474,7 +474,7 @@ void WallBrush::doWalls(BaseMap* map, Tile* tile) {
 						if (wall_decoration->getWallAlignment() == bt) {
 							// Same, no need to change...
 							items_to_add.push_back(wall_decoration);
-							it = tile->items.erase(it);
+							it = tile->eraseItem(it);
 							continue;
 						}
 						// Not the same alignment, create newd item with correct alignment
@@ -667,7 +667,7 @@ WallDecorationBrush::~WallDecorationBrush() {
 void WallDecorationBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 	ASSERT(tile);
 
-	ItemVector::iterator iter = tile->items.begin();
+	TileItems::iterator iter = tile->items.begin();
 
 	tile->cleanWalls(this);
 	while (iter != tile->items.end()) {
@@ -750,7 +750,7 @@ void WallDecorationBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 			// Add a matching item above this item.
 			Item* item = Item::Create(id);
 			++iter;
-			iter = tile->items.insert(iter, item);
+			iter = tile->insertItem(iter, item);
 		}
 		++iter;
 	}
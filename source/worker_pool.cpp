@@ -0,0 +1,152 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "worker_pool.h"
+
+#include <chrono>
+
+WorkerPool g_workers;
+
+namespace {
+	thread_local bool insideWorker = false;
+	// Set while a thread waits for its batch, the idle callback may get here again
+	thread_local bool insideRun = false;
+}
+
+WorkerPool::WorkerPool() :
+	thread_count(std::max(1u, std::thread::hardware_concurrency())),
+	task(nullptr),
+	count(0),
+	next(0),
+	pending(0),
+	batch(0),
+	stopping(false) {
+	////
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+}
+
+void WorkerPool::start() {
+	threads.reserve(thread_count);
+	for (size_t worker = 0; worker < thread_count; ++worker) {
+		threads.emplace_back([this, worker]() {
+			insideWorker = true;
+			work(worker);
+		});
+	}
+}
+
+void WorkerPool::run(size_t count, const Task &task, const std::function<void()> &idle) {
+	if (count == 0) {
+		return;
+	}
+
+	if (insideWorker || insideRun) {
+		// Waiting on the pool from one of its own threads, or from inside a wait, would never finish
+		for (size_t index = 0; index < count; ++index) {
+			task(index, 0);
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> batch_guard(run_lock);
+	std::unique_lock<std::mutex> guard(lock);
+	if (threads.empty()) {
+		start();
+	}
+
+	this->task = &task;
+	this->count = count;
+	next = 0;
+	pending = count;
+	error = nullptr;
+	++batch;
+	insideRun = true;
+	wake.notify_all();
+
+	while (!finished.wait_for(guard, std::chrono::milliseconds(50), [this]() { return pending == 0; })) {
+		if (idle) {
+			guard.unlock();
+			idle();
+			guard.lock();
+		}
+	}
+
+	this->task = nullptr;
+	std::exception_ptr failure = error;
+	error = nullptr;
+	guard.unlock();
+
+	if (idle) {
+		idle();
+	}
+	insideRun = false;
+	if (failure) {
+		std::rethrow_exception(failure);
+	}
+}
+
+bool WorkerPool::isWaiting() noexcept {
+	return insideRun;
+}
+
+void WorkerPool::work(size_t worker) {
+	uint64_t seen = 0;
+	std::unique_lock<std::mutex> guard(lock);
+	while (true) {
+		wake.wait(guard, [this, seen]() { return stopping || batch != seen; });
+		if (stopping) {
+			return;
+		}
+		seen = batch;
+
+		while (next < count) {
+			const size_t index = next++;
+			const Task &current = *task;
+			guard.unlock();
+
+			std::exception_ptr failure;
+			try {
+				current(index, worker);
+			} catch (...) {
+				failure = std::current_exception();
+			}
+
+			guard.lock();
+			if (failure && !error) {
+				error = failure;
+				// Drop what nobody has picked up yet
+				pending -= count - next;
+				next = count;
+			}
+			if (--pending == 0) {
+				finished.notify_all();
+			}
+		}
+	}
+}
@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_WORKER_POOL_H
+#define RME_WORKER_POOL_H
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads for splitting heavy map work into independent pieces.
+// The threads are started on first use and sleep between batches.
+class WorkerPool {
+public:
+	// task(index, worker), worker is below getThreadCount() and unique among the running tasks
+	using Task = std::function<void(size_t index, size_t worker)>;
+
+	WorkerPool();
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool &) = delete;
+	WorkerPool &operator=(const WorkerPool &) = delete;
+
+	size_t getThreadCount() const noexcept {
+		return thread_count;
+	}
+
+	// Calls task for every index below count and returns once all of them are done.
+	// The calling thread only waits, calling idle every few milliseconds so a load bar can be updated.
+	// The first exception thrown by a task is rethrown here, the remaining indices are skipped.
+	// Called from inside a task or from idle, the batch runs inline on that thread instead.
+	void run(size_t count, const Task &task, const std::function<void()> &idle = nullptr);
+	// True while the calling thread waits in run, e.g. for events handled while idle updates a load bar
+	static bool isWaiting() noexcept;
+
+private:
+	void start();
+	void work(size_t worker);
+
+	size_t thread_count;
+	std::vector<std::thread> threads;
+
+	std::mutex run_lock; // One batch at a time
+	std::mutex lock;
+	std::condition_variable wake;
+	std::condition_variable finished;
+
+	// Current batch, guarded by lock
+	const Task* task;
+	size_t count;
+	size_t next;
+	size_t pending;
+	uint64_t batch;
+	bool stopping;
+	std::exception_ptr error;
+};
+
+extern WorkerPool g_workers;
+
+#endif
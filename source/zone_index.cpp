@@ -0,0 +1,173 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#include "main.h"
+
+#include "zone_index.h"
+#include "tile.h"
+
+void ZoneIndex::addTile(const Tile* tile) {
+	const Position &position = tile->getPosition();
+	const uint32_t key = MapLeaf::key(position);
+	const uint16_t bit = leafBit(position);
+	for (const unsigned int zoneId : tile->zones) {
+		Zone &zone = zones[zoneId];
+		uint16_t &bits = zone.leaves[key];
+		if (bits & bit) {
+			continue;
+		}
+		bits |= bit;
+
+		if (zone.tiles++ == 0) {
+			zone.min_bound = position;
+			zone.max_bound = position;
+			zone.dirty = false;
+		} else if (!zone.dirty) {
+			zone.min_bound = Position(std::min(zone.min_bound.x, position.x), std::min(zone.min_bound.y, position.y), std::min(zone.min_bound.z, position.z));
+			zone.max_bound = Position(std::max(zone.max_bound.x, position.x), std::max(zone.max_bound.y, position.y), std::max(zone.max_bound.z, position.z));
+		}
+	}
+}
+
+void ZoneIndex::removeTile(const Tile* tile) {
+	const Position &position = tile->getPosition();
+	const uint32_t key = MapLeaf::key(position);
+	const uint16_t bit = leafBit(position);
+	for (const unsigned int zoneId : tile->zones) {
+		auto zoneIt = zones.find(zoneId);
+		if (zoneIt == zones.end()) {
+			continue;
+		}
+
+		Zone &zone = zoneIt->second;
+		auto leafIt = zone.leaves.find(key);
+		if (leafIt == zone.leaves.end() || !(leafIt->second & bit)) {
+			continue;
+		}
+
+		leafIt->second &= ~bit;
+		if (leafIt->second == 0) {
+			zone.leaves.erase(leafIt);
+		}
+
+		if (--zone.tiles == 0) {
+			zones.erase(zoneIt);
+			continue;
+		}
+
+		const Position &minBound = zone.min_bound;
+		const Position &maxBound = zone.max_bound;
+		if (position.x == minBound.x || position.y == minBound.y || position.z == minBound.z || position.x == maxBound.x || position.y == maxBound.y || position.z == maxBound.z) {
+			zone.dirty = true;
+		}
+	}
+}
+
+void ZoneIndex::clear() {
+	zones.clear();
+}
+
+void ZoneIndex::eraseZone(unsigned int zoneId) {
+	zones.erase(zoneId);
+}
+
+size_t ZoneIndex::getTileCount(unsigned int zoneId) const {
+	auto it = zones.find(zoneId);
+	return it == zones.end() ? 0 : it->second.tiles;
+}
+
+bool ZoneIndex::getBounds(unsigned int zoneId, Position &minPosition, Position &maxPosition) const {
+	auto it = zones.find(zoneId);
+	if (it == zones.end()) {
+		return false;
+	}
+
+	const Zone &zone = it->second;
+	if (zone.dirty) {
+		zone.updateBounds();
+	}
+	minPosition = zone.min_bound;
+	maxPosition = zone.max_bound;
+	return true;
+}
+
+std::vector<Position> ZoneIndex::getPositions(unsigned int zoneId) const {
+	std::vector<Position> positions;
+	auto it = zones.find(zoneId);
+	if (it == zones.end()) {
+		return positions;
+	}
+
+	const Zone &zone = it->second;
+	positions.reserve(zone.tiles);
+	for (const auto &[key, bits] : zone.leaves) {
+		for (int bit = 0; bit < MapLeaf::Size * MapLeaf::Size; ++bit) {
+			if (bits & (1 << bit)) {
+				positions.push_back(leafPosition(key, bit));
+			}
+		}
+	}
+
+	// Leaves come in row order, their tiles are still column major
+	std::sort(positions.begin(), positions.end(), [](const Position &a, const Position &b) {
+		return std::tie(a.z, a.y, a.x) < std::tie(b.z, b.y, b.x);
+	});
+	return positions;
+}
+
+std::vector<unsigned int> ZoneIndex::getZoneIds() const {
+	std::vector<unsigned int> ids;
+	ids.reserve(zones.size());
+	for (const auto &[zoneId, zone] : zones) {
+		ids.push_back(zoneId);
+	}
+	std::sort(ids.begin(), ids.end());
+	return ids;
+}
+
+uint64_t ZoneIndex::memsize() const {
+	// Rough node sizes, the standard containers don't expose them
+	uint64_t bytes = zones.bucket_count() * sizeof(void*);
+	for (const auto &[zoneId, zone] : zones) {
+		bytes += sizeof(std::pair<const unsigned int, Zone>) + 2 * sizeof(void*);
+		bytes += zone.leaves.size() * (sizeof(std::pair<const uint32_t, uint16_t>) + 4 * sizeof(void*));
+	}
+	return bytes;
+}
+
+void ZoneIndex::Zone::updateBounds() const {
+	bool first = true;
+	for (const auto &[key, bits] : leaves) {
+		for (int bit = 0; bit < MapLeaf::Size * MapLeaf::Size; ++bit) {
+			if (!(bits & (1 << bit))) {
+				continue;
+			}
+
+			const Position position = leafPosition(key, bit);
+			if (first) {
+				min_bound = position;
+				max_bound = position;
+				first = false;
+			} else {
+				min_bound = Position(std::min(min_bound.x, position.x), std::min(min_bound.y, position.y), std::min(min_bound.z, position.z));
+				max_bound = Position(std::max(max_bound.x, position.x), std::max(max_bound.y, position.y), std::max(max_bound.z, position.z));
+			}
+		}
+	}
+	dirty = false;
+}
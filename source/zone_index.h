@@ -0,0 +1,84 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_ZONE_INDEX_H
+#define RME_ZONE_INDEX_H
+
+#include "map_leaf.h"
+
+#include <map>
+#include <unordered_map>
+
+class Tile;
+
+// The tiles of every zone, as one bitmap per map leaf (4x4 tiles of one floor)
+// plus a bounding box, so jumping to or deleting a zone only visits its own tiles.
+// The map feeds it each tile as it enters or leaves, which covers brushes and undo.
+class ZoneIndex {
+public:
+	void addTile(const Tile* tile);
+	void removeTile(const Tile* tile);
+	void clear();
+
+	// Forgets the zone, for when its tiles are cleaned without replacing them
+	void eraseZone(unsigned int zoneId);
+
+	bool hasZone(unsigned int zoneId) const {
+		return zones.contains(zoneId);
+	}
+	size_t getTileCount(unsigned int zoneId) const;
+
+	// False when no tile has the zone
+	bool getBounds(unsigned int zoneId, Position &minPosition, Position &maxPosition) const;
+
+	// Sorted by floor, then row, then column
+	std::vector<Position> getPositions(unsigned int zoneId) const;
+	// Zone ids used by at least one tile
+	std::vector<unsigned int> getZoneIds() const;
+
+	size_t size() const noexcept {
+		return zones.size();
+	}
+
+	uint64_t memsize() const;
+
+private:
+	struct Zone {
+		// Leaf key to the bits of its tiles, bit i is x + (i >> 2), y + (i & 3) like Floor
+		std::map<uint32_t, uint16_t> leaves;
+		size_t tiles = 0;
+		// Removing a tile on the edge only marks the bounds, they are rebuilt on demand
+		mutable Position min_bound;
+		mutable Position max_bound;
+		mutable bool dirty = false;
+
+		void updateBounds() const;
+	};
+
+	static uint16_t leafBit(const Position &position) noexcept {
+		return uint16_t(1) << ((position.x % MapLeaf::Size) * MapLeaf::Size + position.y % MapLeaf::Size);
+	}
+	static Position leafPosition(uint32_t key, int bit) noexcept {
+		const Position corner = MapLeaf::corner(key);
+		return Position(corner.x + (bit >> 2), corner.y + (bit & 3), corner.z);
+	}
+
+	std::unordered_map<unsigned int, Zone> zones;
+};
+
+#endif
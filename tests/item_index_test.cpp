@@ -0,0 +1,96 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+// The item index and the item id registry stay current when items are removed in place
+
+#include "main.h"
+
+#include "map.h"
+#include "item.h"
+#include "tile.h"
+
+#include "test_support.h"
+
+namespace {
+	constexpr uint16_t KeptId = 100;
+	constexpr uint16_t RemovedId = 101;
+	constexpr uint16_t MarkedId = 102;
+	constexpr int TileCount = 16;
+
+	struct RemoveById {
+		uint16_t id;
+
+		bool operator()(Map &map, Item* item, int64_t removed, int64_t done) {
+			return item->getID() == id;
+		}
+	};
+
+	size_t countLeaves(const ItemIndex &index, uint16_t id) {
+		size_t leaves = 0;
+		index.forEachLeaf(id, [&leaves](int x, int y, int z) {
+			++leaves;
+		});
+		return leaves;
+	}
+
+	void fillMap(Map &map) {
+		for (int x = 0; x < TileCount; ++x) {
+			const Position position(1000 + x, 1000, rme::MapGroundLayer);
+			Tile* tile = map.allocator(map.createTileL(position));
+			tile->addItem(Item::Create(KeptId));
+			tile->addItem(Item::Create(RemovedId));
+
+			Item* marked = Item::Create(MarkedId);
+			marked->setUniqueID(2000 + x);
+			tile->addItem(marked);
+			map.setTile(position, tile);
+		}
+	}
+
+	void testRemoveItemOnMap() {
+		Map map;
+		fillMap(map);
+
+		const ItemIndex* index = map.getItemIndex();
+		expect(index != nullptr, "the item index is built");
+		if (!index) {
+			return;
+		}
+		expect(index->getCount(RemovedId) == TileCount, "every item is indexed");
+
+		RemoveById removeItem { RemovedId };
+		expect(RemoveItemOnMap(map, removeItem, false) == TileCount, "RemoveItemOnMap removes every copy");
+
+		index = map.getItemIndex();
+		expect(index && index->getCount(RemovedId) == 0, "removed items leave the index");
+		expect(index && countLeaves(*index, RemovedId) == 0, "removed items leave no leaves behind");
+		expect(index && index->getCount(KeptId) == TileCount, "the other items stay indexed");
+		expect(index && countLeaves(*index, KeptId) == TileCount / MapLeaf::Size, "the other items keep their leaves");
+
+		RemoveById removeMarked { MarkedId };
+		RemoveItemOnMap(map, removeMarked, false);
+		expect(!map.hasUniqueId(2000), "removed unique ids leave the registry");
+		expect(map.getItemIds().getUniqueIds().empty(), "no unique id is left");
+	}
+}
+
+int main() {
+	wxInitializer initializer;
+
+	testRemoveItemOnMap();
+	return testResult("item index");
+}
@@ -0,0 +1,107 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+// The item index's table keeps its per id leaf lists sorted, folded and counted
+// through building, merging, adding and removing
+
+#include "item_leaf_table.h"
+
+#include "test_support.h"
+
+namespace {
+	constexpr uint16_t FirstId = 100;
+	constexpr uint16_t SecondId = 101;
+
+	bool isSortedAndFolded(const ItemLeafTable::LeafList &list) {
+		for (size_t i = 1; i < list.size(); ++i) {
+			if (list[i - 1].key >= list[i].key) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void testLeafKey() {
+		const Position position(1001, 2003, 7);
+		const uint32_t key = MapLeaf::key(position);
+		const Position corner = MapLeaf::corner(key);
+		expect(corner.x == 1000 && corner.y == 2000 && corner.z == 7, "a key gives the top left tile of its leaf");
+		expect(MapLeaf::key(corner) == key, "the tiles of a leaf share its key");
+		expect(MapLeaf::key(Position(0, 0, 8)) > MapLeaf::key(Position(4000, 4000, 7)), "keys sort by floor first");
+		expect(MapLeaf::key(Position(0, 4, 7)) > MapLeaf::key(Position(4000, 0, 7)), "then by row");
+	}
+
+	void testBuild() {
+		// Two workers that each saw runs of the same leaves, out of order
+		ItemLeafTable first;
+		ItemLeafTable second;
+		const uint32_t near = MapLeaf::key(Position(100, 100, 7));
+		const uint32_t far = MapLeaf::key(Position(200, 100, 7));
+		first.append(FirstId, far);
+		first.append(FirstId, far);
+		first.append(FirstId, near);
+		second.append(FirstId, far);
+		second.append(SecondId, near);
+
+		first.merge(std::move(second));
+		first.finish();
+
+		const ItemLeafTable::LeafList &leaves = first.getLeaves(FirstId);
+		expect(leaves.size() == 2 && isSortedAndFolded(leaves), "runs of a leaf fold into one sorted entry");
+		expect(leaves.size() == 2 && leaves[0].key == near && leaves[1].key == far && leaves[1].count == 3, "folded counts add up");
+		expect(first.getCount(FirstId) == 4 && first.getCount(SecondId) == 1, "totals per id survive the merge");
+		expect(first.getEntryCount() == 3, "entries count leaves, not items");
+	}
+
+	void testUpdates() {
+		ItemLeafTable table;
+		table.finish();
+		expect(table.getLeaves(FirstId).empty() && table.getCount(FirstId) == 0, "a finished empty table is empty");
+
+		for (int x = 40; x >= 0; x -= 4) {
+			table.add(FirstId, MapLeaf::key(Position(x, 0, 7)));
+		}
+		table.add(FirstId, MapLeaf::key(Position(20, 0, 7)));
+		expect(isSortedAndFolded(table.getLeaves(FirstId)), "adding keeps the list sorted");
+		expect(table.getLeaves(FirstId).size() == 11 && table.getCount(FirstId) == 12, "a second item joins its leaf");
+
+		table.remove(FirstId, MapLeaf::key(Position(20, 0, 7)));
+		expect(table.getLeaves(FirstId).size() == 11, "a leaf stays while it still holds the id");
+		table.remove(FirstId, MapLeaf::key(Position(20, 0, 7)));
+		expect(table.getLeaves(FirstId).size() == 10 && table.getEntryCount() == 10, "the last item takes its leaf along");
+
+		// Removing what was never added changes nothing
+		table.remove(FirstId, MapLeaf::key(Position(1000, 0, 7)));
+		table.remove(SecondId, MapLeaf::key(Position(0, 0, 7)));
+		expect(table.getCount(FirstId) == 10 && table.getCount(SecondId) == 0, "unknown removals are ignored");
+
+		const uint64_t bytes = table.getEstimatedBytes();
+		table.add(SecondId, MapLeaf::key(Position(0, 0, 7)));
+		expect(table.getEstimatedBytes() == bytes + sizeof(ItemLeafTable::LeafEntry), "the estimate grows by entry");
+
+		table.clear();
+		expect(table.empty() && table.getCount(FirstId) == 0 && table.memsize() == 0, "clear frees everything");
+	}
+}
+
+int main() {
+	testLeafKey();
+	testBuild();
+	testUpdates();
+	return testResult("item leaf table");
+}
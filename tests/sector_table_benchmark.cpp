@@ -0,0 +1,149 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+// Leaf lookups and full leaf walks through the hextree against the sector table, over a
+// populated 2048x2048 area plus scattered islands, and over a copy buffer sized area.
+// Build with -DOPTIONS_ENABLE_TESTS=ON and run sector_table_benchmark.
+
+#include "main.h"
+
+#include "basemap.h"
+#include "map_traversal.h"
+#include "tile.h"
+
+#include <chrono>
+#include <random>
+
+namespace {
+	struct BenchmarkMap : BaseMap {
+		QTreeNode &getRoot() {
+			return root;
+		}
+	};
+
+	bool check(BenchmarkMap &map, const SectorTable &table, std::mt19937 &rng) {
+		for (int i = 0; i < 200000; ++i) {
+			int x = rng() % 65536, y = rng() % 65536;
+			if (map.getRoot().getLeaf(x, y) != table.getLeaf(x, y)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <typename Func>
+	void bench(const char* name, int from, int side, Func &&getLeaf) {
+		size_t hits = 0;
+
+		// Row scans are what drawing and selection do, random lookups what brushes do
+		auto start = std::chrono::steady_clock::now();
+		for (int x = from; x < from + side; ++x) {
+			for (int y = from; y < from + side; ++y) {
+				hits += getLeaf(x, y) != nullptr;
+			}
+		}
+		auto scanned = std::chrono::steady_clock::now();
+
+		std::mt19937 rng(3);
+		for (int i = 0; i < 1000000; ++i) {
+			hits += getLeaf(from + rng() % side, from + rng() % side) != nullptr;
+		}
+		auto randomized = std::chrono::steady_clock::now();
+
+		// A tile and its eight neighbours, the way borders and walls are redone around a change
+		for (int i = 0; i < 1000000; ++i) {
+			const int x = from + 1 + rng() % (side - 2), y = from + 1 + rng() % (side - 2);
+			for (int dx = -1; dx <= 1; ++dx) {
+				for (int dy = -1; dy <= 1; ++dy) {
+					hits += getLeaf(x + dx, y + dy) != nullptr;
+				}
+			}
+		}
+		auto done = std::chrono::steady_clock::now();
+
+		printf(
+			"%-8s scan %7.1f ms  1M random %7.1f ms  1M neighbourhoods %7.1f ms  (%zu hits)\n", name,
+			std::chrono::duration<double, std::milli>(scanned - start).count(),
+			std::chrono::duration<double, std::milli>(randomized - scanned).count(),
+			std::chrono::duration<double, std::milli>(done - randomized).count(), hits
+		);
+	}
+
+	// Every leaf once, reading one of its floors, the way whole map walks start out
+	template <typename Func>
+	size_t iterate(const char* name, Func &&forEachLeaf) {
+		size_t leaves = 0, floors = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int round = 0; round < 10; ++round) {
+			forEachLeaf([&](QTreeNode* leaf) {
+				++leaves;
+				floors += leaf->getFloor(rme::MapGroundLayer) != nullptr;
+			});
+		}
+		auto done = std::chrono::steady_clock::now();
+
+		printf("%-8s 10 full walks %7.1f ms  (%zu leaves, %zu floors)\n", name, std::chrono::duration<double, std::milli>(done - start).count(), leaves / 10, floors / 10);
+		return leaves;
+	}
+
+	bool run(const char* title, int from, int side, int islands) {
+		BenchmarkMap map;
+		SectorTable table;
+		std::mt19937 rng(7);
+
+		for (int x = from; x < from + side; x += 4) {
+			for (int y = from; y < from + side; y += 4) {
+				QTreeNode* leaf = map.getRoot().getLeafForce(x, y);
+				leaf->createFloor(x, y, rme::MapGroundLayer);
+				table.setLeaf(x, y, leaf);
+			}
+		}
+		for (int i = 0; i < islands; ++i) {
+			int x = rng() % 65536, y = rng() % 65536;
+			table.setLeaf(x, y, map.getRoot().getLeafForce(x, y));
+		}
+
+		printf("%s: %zu sectors, top level %s, %zu KiB\n", title, table.getSectorCount(), table.hasTopLevel() ? "allocated" : "not allocated", table.memsize() / 1024);
+		if (!check(map, table, rng)) {
+			printf("sector table and hextree disagree\n");
+			return false;
+		}
+		bench("hextree", from, side, [&](int x, int y) { return map.getRoot().getLeaf(x, y); });
+		bench("sectors", from, side, [&](int x, int y) { return table.getLeaf(x, y); });
+
+		const size_t tree_leaves = iterate("hextree", [&](auto &&func) {
+			for (QTreeNode* leaf : MapTraversal::getNodes(map, 4)) {
+				func(leaf);
+			}
+		});
+		const size_t table_leaves = iterate("sectors", [&](auto &&func) {
+			table.forEachLeaf(func);
+		});
+		if (tree_leaves != table_leaves) {
+			printf("sector table and hextree walk a different number of leaves\n");
+			return false;
+		}
+		return true;
+	}
+}
+
+int main() {
+	bool ok = run("Map", 31000, 2048, 2000);
+	ok = run("Copy buffer", 32000, 300, 0) && ok;
+	return ok ? 0 : 1;
+}
+
@@ -0,0 +1,73 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+// SmallVector behaves like std::vector, also across the switch from inline to heap storage
+
+#include "small_vector.h"
+
+#include "test_support.h"
+
+#include <vector>
+
+namespace {
+	template <typename T, uint32_t N>
+	void expectEqual(const SmallVector<T, N> &vector, const std::vector<T> &expected, const char* what) {
+		expect(std::equal(vector.begin(), vector.end(), expected.begin(), expected.end()), what);
+	}
+
+	void testGrowth() {
+		SmallVector<int, 3> vector;
+		std::vector<int> expected;
+		for (int i = 0; i < 10; ++i) {
+			vector.push_back(i);
+			expected.push_back(i);
+		}
+		expectEqual(vector, expected, "push_back past the inline room");
+
+		vector.erase(vector.begin() + 2, vector.begin() + 9);
+		expected.erase(expected.begin() + 2, expected.begin() + 9);
+		vector.shrink_to_fit();
+		expectEqual(vector, expected, "erase and shrink back inline");
+		expect(vector.isInline(), "shrink_to_fit goes back to the inline storage");
+	}
+
+	void testInsertAliased() {
+		// The source range lives in the vector and has to move when it grows
+		SmallVector<int, 3> inline_source { 1, 2, 3 };
+		inline_source.insert(inline_source.begin() + 1, inline_source.begin(), inline_source.end());
+		expectEqual(inline_source, { 1, 1, 2, 3, 2, 3 }, "insert a range of itself while inline");
+
+		SmallVector<int, 2> heap_source { 1, 2, 3, 4 };
+		heap_source.insert(heap_source.begin(), heap_source.begin() + 1, heap_source.end());
+		expectEqual(heap_source, { 2, 3, 4, 1, 2, 3, 4 }, "insert a range of itself from the heap");
+
+		// No growth, but the elements after the insert point still shift
+		SmallVector<int, 8> shifted { 1, 2, 3 };
+		shifted.insert(shifted.begin(), shifted.begin() + 1, shifted.end());
+		expectEqual(shifted, { 2, 3, 1, 2, 3 }, "insert a range of itself without growing");
+
+		SmallVector<int, 2> single { 5, 6 };
+		single.insert(single.end(), single.front());
+		expectEqual(single, { 5, 6, 5 }, "insert an element of itself");
+	}
+}
+
+int main() {
+	testGrowth();
+	testInsertAliased();
+	return testResult("SmallVector");
+}
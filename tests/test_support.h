@@ -0,0 +1,45 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_TEST_SUPPORT_H
+#define RME_TEST_SUPPORT_H
+
+#include <cstdio>
+
+// Each test is its own executable: checks print what failed and count it,
+// main returns testResult so ctest sees the failures
+
+inline int &testFailures() {
+	static int failures = 0;
+	return failures;
+}
+
+inline void expect(bool condition, const char* what) {
+	if (!condition) {
+		printf("FAILED: %s\n", what);
+		++testFailures();
+	}
+}
+
+inline int testResult(const char* suite) {
+	if (testFailures() == 0) {
+		printf("All %s tests passed\n", suite);
+	}
+	return testFailures() == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,169 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+// Plain items on a tile are kept as records and only become full items when asked for,
+// the other items are shared between copies until one of them changes
+
+#include "main.h"
+
+#include "tile_items.h"
+
+#include "test_support.h"
+
+#include <thread>
+#include <vector>
+
+namespace {
+	constexpr uint16_t FirstId = 100;
+	constexpr size_t ItemCount = 8;
+
+	void fill(TileItems &items, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			items.push_back(Item::Create(FirstId + i));
+		}
+		items.compact();
+	}
+
+	void testRecords() {
+		TileItems items;
+		fill(items, ItemCount);
+		expect(items.getRecordCount() == ItemCount, "plain items are compacted into records");
+		expect(items.getID(3) == FirstId + 3, "a record keeps its id");
+
+		items.select(4);
+		expect(items.isSelected(4) && !items.isSelected(5), "a record keeps its selection");
+
+		size_t visited = 0;
+		items.forEach([&](const Item &item) {
+			expect(item.getID() == FirstId + visited, "forEach goes bottom to top");
+			++visited;
+		});
+		expect(visited == ItemCount && items.getRecordCount() == ItemCount, "forEach leaves the records in place");
+
+		Item* item = items[4];
+		expect(item->getID() == FirstId + 4 && item->isSelected(), "a built item matches its record");
+		expect(items.getRecordCount() == ItemCount - 1, "only the item asked for is built");
+		expect(items[4] == item, "a built item stays the same");
+		expect(items.indexOf(item) == 4, "a built item is found again");
+
+		items.destroy(items.begin() + 4);
+		items.destroy(items.begin() + 2);
+		expect(items.size() == ItemCount - 2, "records and items are both destroyed");
+		expect(items.getID(2) == FirstId + 3 && items.getID(3) == FirstId + 5, "destroy keeps the order");
+	}
+
+	void testCopy() {
+		TileItems items;
+		fill(items, ItemCount);
+		Item* item = items[0];
+
+		TileItems copy;
+		copy.copyFrom(items);
+		expect(copy.size() == ItemCount && copy.getRecordCount() == ItemCount, "a copy turns plain items into records");
+		expect(copy.getID(0) == item->getID(), "a copy keeps the ids");
+
+		items.swap(0, ItemCount - 1);
+		expect(items.getID(0) == FirstId + ItemCount - 1 && items[ItemCount - 1] == item, "swap moves items and records");
+		expect(copy.getID(0) == FirstId, "the copy is left alone");
+	}
+
+	// An item with an attribute, which a list cannot keep as a record
+	Item* createComplex(uint16_t id) {
+		Item* item = Item::Create(id);
+		item->setAttribute("aid", static_cast<int32_t>(id));
+		return item;
+	}
+
+	void testShared() {
+		TileItems items;
+		items.push_back(createComplex(FirstId));
+		items.push_back(createComplex(FirstId + 1));
+		items.compact();
+		expect(items.getSharedCount() == 2 && items.getRecordCount() == 0, "unselected complex items are shared");
+		const size_t bytes = items.getSharedBytes();
+
+		{
+			TileItems copy;
+			copy.copyFrom(items);
+			expect(copy.getSharedCount() == 2, "a copy shares the items");
+			expect(copy.getSharedBytes() == items.getSharedBytes() && copy.getSharedBytes() < bytes, "shared items are split over their holders");
+
+			Item* changed = copy[0];
+			expect(!copy.isShared(0) && items.isShared(0), "asking for an item clones it for the copy");
+			expect(changed->getID() == FirstId && changed->getActionID() == FirstId, "a clone keeps the attributes");
+			expect(copy.getSharedCount() == 1 && items.getSharedCount() == 2, "the clone is no longer shared");
+
+			copy.select(1);
+			expect(copy.isSelected(1) && !copy.isShared(1), "selecting a shared item clones it");
+			expect(!items.isSelected(1) && items.isShared(1), "the original stays unselected");
+		}
+		expect(items.getSharedBytes() == bytes, "a destroyed copy lets go of the items");
+
+		TileItems copy;
+		copy.copyFrom(items);
+		items.destroy(items.begin());
+		Item* last = copy[0];
+		expect(last->getID() == FirstId && !copy.isShared(0), "the last holder takes the item over");
+		expect(copy.indexOf(last) == 0, "a taken over item is found again");
+
+		items.select(0);
+		TileItems selected;
+		selected.copyFrom(items);
+		expect(!selected.isShared(0) && selected.isSelected(0), "a selected item is cloned, not shared");
+	}
+
+	void testConcurrentBuild() {
+		// Every reader has to end up with the same item for each record or shared item
+		constexpr int Readers = 4;
+		for (int round = 0; round < 20; ++round) {
+			TileItems items;
+			for (uint16_t i = 0; i < 8; ++i) {
+				items.push_back(createComplex(FirstId + i));
+			}
+			fill(items, 64);
+			// Shared with a copy, so every reader clones them
+			TileItems copy;
+			copy.copyFrom(items);
+
+			std::vector<Item*> seen[Readers];
+			std::vector<std::thread> readers;
+			for (int reader = 0; reader < Readers; ++reader) {
+				readers.emplace_back([&items, &seen, reader] {
+					for (size_t i = 0; i < items.size(); ++i) {
+						seen[reader].push_back(items[i]);
+					}
+				});
+			}
+			for (std::thread &reader : readers) {
+				reader.join();
+			}
+			for (int reader = 1; reader < Readers; ++reader) {
+				expect(seen[reader] == seen[0], "readers building the same items agree");
+			}
+			expect(items.getRecordCount() == 0 && items.getSharedCount() == 0, "every item was built");
+			expect(copy.getSharedCount() == 8, "the copy keeps sharing its items");
+		}
+	}
+}
+
+int main() {
+	testRecords();
+	testCopy();
+	testShared();
+	testConcurrentBuild();
+	return testResult("tile item");
+}